@@ -20,6 +20,7 @@
 #include <pthread.h>
 #include <sstream>
 #include <set>
+#include <map>
 #include <vector>
 
 #include <string>
@@ -372,6 +373,82 @@ public:
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+template<class K>
+class map_cb : public Callbackable
+{
+public:
+    void set_callback(std::map<K, std::string> * _values)
+    {
+        values = _values;
+
+        Callbackable::set_callback(
+                static_cast<Callbackable::Callback>(&map_cb::callback));
+    };
+
+    int callback(void * nil, int num, char **_values, char **names)
+    {
+        if ( num != 2 || _values == 0 || _values[0] == 0 || _values[1] == 0 )
+        {
+            return -1;
+        }
+
+        std::istringstream iss(_values[0]);
+
+        K key;
+
+        iss >> key;
+
+        (*values)[key] = _values[1];
+
+        return 0;
+    };
+
+private:
+
+    std::map<K, std::string> * values;
+};
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+template<class K>
+class map_vector_cb : public Callbackable
+{
+public:
+    void set_callback(std::map<K, std::vector<std::string> > * _values)
+    {
+        values = _values;
+
+        Callbackable::set_callback(
+                static_cast<Callbackable::Callback>(&map_vector_cb::callback));
+    };
+
+    int callback(void * nil, int num, char **_values, char **names)
+    {
+        if ( num != 2 || _values == 0 || _values[0] == 0 || _values[1] == 0 )
+        {
+            return -1;
+        }
+
+        std::istringstream iss(_values[0]);
+
+        K key;
+
+        iss >> key;
+
+        (*values)[key].push_back(_values[1]);
+
+        return 0;
+    };
+
+private:
+
+    std::map<K, std::vector<std::string> > * values;
+};
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 template< template<class...> class Container, class T>
 class multiple_cb : public Callbackable
 {
@@ -22,6 +22,13 @@
 #include <xmlrpc-c/girerr.hpp>
 
 #include <string>
+#include <vector>
+#include <map>
+#include <stdexcept>
+
+#include <time.h>
+#include <pthread.h>
+#include <sys/stat.h>
 
 using namespace std;
 
@@ -31,6 +38,29 @@ using namespace std;
 // http://xmlrpc-c.sourceforge.net/doc/libxmlrpc_client++.html#simple_client
 // =============================================================================
 
+/**
+ *  Exception raised by the calls to the initialized server when it returns
+ *  a fault (e.g. xmlrpc_c::fault::CODE_NO_SUCH_METHOD if the method does not
+ *  exist)
+ */
+class ClientFault : public std::runtime_error
+{
+public:
+    ClientFault(int _code, const std::string& message):
+        std::runtime_error(message), code(_code){};
+
+    /**
+     *  @return the xml-rpc fault code
+     */
+    int get_code() const
+    {
+        return code;
+    };
+
+private:
+    int code;
+};
+
 /**
  * This class represents the connection with the core and handles the
  * xml-rpc calls.
@@ -71,11 +101,20 @@ public:
      */
     static int read_oneauth(std::string &secret, std::string& error);
 
+    /**
+     *  Gets the ONE_AUTH secret as read_oneauth, but it is cached. The file
+     *  path is resolved in the first call, and the file is only read again
+     *  when it changes (modification time, size or inode). It is used for
+     *  the calls made by the core (e.g. raft replication).
+     */
+    static int get_oneauth(std::string &secret, std::string& error);
+
 	/**
      *  Performs a xmlrpc call to the initialized server
      *    @param method name
      *    @param plist initialized param list
      *    @param result of the xmlrpc call
+     *    @throws ClientFault if the server returns a fault
      */
     void call(const std::string& method, const xmlrpc_c::paramList& plist,
 		 xmlrpc_c::value * const result);
@@ -88,24 +127,86 @@ public:
      *    @param timeout (ms) for the request, set 0 for global xml_rpc timeout
      *    @param result of the xmlrpc call
      *    @param error string if any
+     *    @param pooled use a connection of the pool, for the frequent calls
+     *    between servers (raft, federation). Otherwise a new connection is
+     *    opened and closed for the call.
      *    @return 0
      */
     static int call(const std::string& endpoint, const std::string& method,
         const xmlrpc_c::paramList& plist, unsigned int _timeout,
-        xmlrpc_c::value * const result, std::string& error);
+        xmlrpc_c::value * const result, std::string& error, bool pooled);
+
+    /**
+     *  Sequence of xmlrpc calls to the same server, see the window version of
+     *  call(). The calls are made in order and their replies are processed
+     *  in the same order.
+     */
+    class CallSequence
+    {
+    public:
+        virtual ~CallSequence(){};
+
+        /**
+         *  Gets the parameters of the next call of the sequence
+         *    @param plist initialized param list of the call
+         *    @return false if there are no more calls
+         */
+        virtual bool next_call(xmlrpc_c::paramList& plist) = 0;
+
+        /**
+         *  Processes the reply of the oldest call in flight
+         *    @param rc 0 if the call succeeded, -1 otherwise
+         *    @param result of the xmlrpc call
+         *    @param error string if any
+         *    @return false to stop the sequence, calls in flight are aborted
+         */
+        virtual bool reply(int rc, const xmlrpc_c::value& result,
+                const std::string& error) = 0;
+    };
+
+	/**
+     *  Performs a sequence of xmlrpc calls to the same server, keeping up to
+     *  window calls in flight on the same connection. A new call is made as
+     *  soon as the oldest one finishes (sliding window). Pooled connections
+     *  have at most CONN_POOL_MAX calls in flight.
+     *    @param endpoint of server
+     *    @param method name
+     *    @param calls the sequence of calls
+     *    @param window max number of calls in flight
+     *    @param timeout (ms) for each request, set 0 for global xml_rpc
+     *    timeout. The sequence is aborted if a call times out.
+     *    @param pooled use a connection of the pool, see the single call
+     *    version
+     *    @return 0 if all the calls succeeded, -1 otherwise
+     */
+    static int call(const std::string& endpoint, const std::string& method,
+        CallSequence& calls, unsigned int window, unsigned int _timeout,
+        bool pooled);
 
 	/**
      *  Performs an xmlrpc call to the initialized server and credentials.
      *  This method automatically adds the credential argument.
      *    @param method name
-     *    @param format of the arguments, supported arguments are i:int, s:string
-     *    and b:bool
+     *    @param format of the arguments, supported arguments are i:int, s:string,
+     *    b:bool, I:set<int>* (array of ints) and A:vector<xmlrpc_c::value>*
+     *    (array)
      *    @param result to store the xmlrpc call result
      *    @param ... xmlrpc arguments
      */
     void call(const std::string &method, const std::string format,
 		xmlrpc_c::value * const result, ...);
 
+    /**
+     *  Sets the limits of the connection pool, see the RAFT section of
+     *  oned.conf. It has to be called before any call is made.
+     *    @param size max number of idle connections kept for each server
+     *    @param max_sockets max number of sockets open to each server, in
+     *    use or idle
+     *    @param idle_timeout (s) idle connections are closed after it
+     */
+    static void set_pool(unsigned int size, unsigned int max_sockets,
+            time_t idle_timeout);
+
 private:
     /**
      * Creates a new xml-rpc client with specified options.
@@ -127,6 +228,112 @@ private:
 	unsigned int timeout;
 
     static Client * _client;
+
+    /**
+     *  Gets the path of the ONE_AUTH file
+     *    @param path of the file
+     *    @param error string if any
+     *    @return 0 on success, -1 otherwise
+     */
+    static int oneauth_path(std::string& path, std::string& error);
+
+    /**
+     *  Cached ONE_AUTH secret, and the file stat when it was read
+     */
+    static pthread_mutex_t oneauth_mutex;
+
+    static std::string oneauth_file;
+
+    static std::string oneauth_secret;
+
+    static struct stat oneauth_stat;
+
+    // -------------------------------------------------------------------------
+    // Connection pool for the calls to other servers (e.g. raft followers).
+    // The curl transport keeps the HTTP connections open (keep-alive), so
+    // reusing it avoids the connection setup on every call.
+    // -------------------------------------------------------------------------
+    struct Connection
+    {
+        Connection():client(&transport), last_used(0), sockets(1){};
+
+        xmlrpc_c::clientXmlTransport_curl transport;
+
+        xmlrpc_c::client_xml client;
+
+        /**
+         *  Time when the connection was returned to the pool
+         */
+        time_t last_used;
+
+        /**
+         *  Max calls in flight on the connection, the transport may keep a
+         *  socket open for each one
+         */
+        unsigned int sockets;
+    };
+
+    struct Endpoint
+    {
+        Endpoint():sockets(0){};
+
+        /**
+         *  Idle connections to the server
+         */
+        std::vector<Connection *> idle;
+
+        /**
+         *  Sockets of the connections to the server, in use and idle
+         */
+        unsigned int sockets;
+    };
+
+    static std::map<std::string, Endpoint> pool;
+
+    static pthread_mutex_t pool_mutex;
+
+    /**
+     *  Signaled when a connection is returned to the pool
+     */
+    static pthread_cond_t pool_cond;
+
+    /**
+     *  Max number of idle connections kept for each endpoint
+     */
+    static unsigned int pool_size;
+
+    /**
+     *  Max number of sockets open to each endpoint
+     */
+    static unsigned int pool_max_sockets;
+
+    /**
+     *  Idle connections are closed after this time (seconds), it should be
+     *  lower than the server KEEPALIVE_TIMEOUT
+     */
+    static time_t pool_idle_timeout;
+
+    /**
+     *  Gets a connection to the endpoint from the pool, a new one is created
+     *  if there are no idle connections. Idle connections that timed out are
+     *  closed. It waits for a connection to be returned if the endpoint
+     *  already has pool_max_sockets open.
+     *    @param endpoint of the server
+     *    @param calls to be in flight at the same time on the connection
+     *    @return the connection, it has to be returned with put_connection
+     */
+    static Connection * get_connection(const std::string& endpoint,
+            unsigned int calls);
+
+    /**
+     *  Returns a connection to the pool. Connections with errors are closed,
+     *  as they may be broken.
+     *    @param endpoint of the server
+     *    @param conn the connection
+     *    @param healthy false if the call failed or timed out
+     */
+    static void put_connection(const std::string& endpoint, Connection * conn,
+            bool healthy);
 };
 
 #endif /*ONECLIENT_H_*/
@@ -221,7 +221,7 @@ public:
      * Returns true if the DS contains the SHARED = YES attribute
      * @return true if the DS is shared
      */
-    bool is_shared()
+    bool is_shared() const
     {
         bool shared;
 
@@ -119,6 +119,18 @@ public:
         return static_cast<Datastore *>(PoolSQL::get_ro(oid));
     }
 
+    /**
+     *  Function to get a read only Datastore snapshot shared with other
+     *  readers, see PoolSQL::get_ro_shared
+     *    @param oid Datastore unique id
+     *    @return the shared Datastore, empty if it could not be loaded
+     */
+    std::shared_ptr<const Datastore> get_ro_shared(int oid)
+    {
+        return std::static_pointer_cast<const Datastore>(
+                PoolSQL::get_ro_shared(oid));
+    }
+
     /**
      *  Drops the Datastore data in the data base. The object mutex SHOULD be
      *  locked.
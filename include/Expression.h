@@ -0,0 +1,349 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2019, OpenNebula Project, OpenNebula Systems                */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+#ifndef EXPRESSION_H_
+#define EXPRESSION_H_
+
+#include <string>
+#include <vector>
+
+#include <fnmatch.h>
+
+#include "ObjectXML.h"
+
+/**
+ *  Compiled form of a requirement expression (e.g. SCHED_REQUIREMENTS). The
+ *  expression is parsed once (expr_bool.y) and then evaluated on any object,
+ *  variables are looked up with ObjectXML::search.
+ */
+class BoolExpression
+{
+public:
+    virtual ~BoolExpression(){};
+
+    /**
+     *  Evaluates the expression on the given object
+     *    @param oxml object to get the variable values from
+     *    @return the result of the expression
+     */
+    virtual bool eval(ObjectXML& oxml) const = 0;
+};
+
+/**
+ *  Compiled form of a rank expression (e.g. SCHED_RANK), see BoolExpression
+ */
+class ArithExpression
+{
+public:
+    virtual ~ArithExpression(){};
+
+    /**
+     *  Evaluates the expression on the given object
+     *    @param oxml object to get the variable values from
+     *    @return the result of the expression
+     */
+    virtual float eval(ObjectXML& oxml) const = 0;
+};
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+/* Requirement expression nodes                                               */
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+class BoolConstant : public BoolExpression
+{
+public:
+    BoolConstant(bool _value):value(_value){};
+
+    bool eval(ObjectXML& oxml) const override
+    {
+        return value;
+    }
+
+private:
+    bool value;
+};
+
+/**
+ *  Comparison of a variable with a numeric constant: VAR = 1, VAR != 1,
+ *  VAR > 1, VAR < 1 or VAR @> 1 (any of the VAR values is 1)
+ */
+template<typename T>
+class BoolCompare : public BoolExpression
+{
+public:
+    enum Operator
+    {
+        EQ       = 0,
+        NE       = 1,
+        GT       = 2,
+        LT       = 3,
+        CONTAINS = 4
+    };
+
+    BoolCompare(const char * _name, Operator _op, T _value):
+        name(_name), op(_op), value(_value){};
+
+    bool eval(ObjectXML& oxml) const override
+    {
+        if ( op == CONTAINS )
+        {
+            std::vector<T> vals;
+
+            oxml.search(name.c_str(), vals);
+
+            for (typename std::vector<T>::iterator it = vals.begin();
+                    it != vals.end(); ++it)
+            {
+                if ( value == *it )
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        // The value is set for pseudo-attributes that depend on it
+        T val = value;
+
+        if ( oxml.search(name.c_str(), val) != 0 )
+        {
+            return false;
+        }
+
+        switch (op)
+        {
+            case EQ: return val == value;
+            case NE: return val != value;
+            case GT: return val > value;
+            case LT: return val < value;
+            case CONTAINS: break;
+        }
+
+        return false;
+    }
+
+private:
+    std::string name;
+
+    Operator op;
+
+    T value;
+};
+
+/**
+ *  Comparison of a variable with a string pattern (fnmatch): VAR = "a*",
+ *  VAR != "a*" or VAR @> "a*" (any of the VAR values matches)
+ */
+class BoolMatch : public BoolExpression
+{
+public:
+    enum Operator
+    {
+        EQ       = 0,
+        NE       = 1,
+        CONTAINS = 2
+    };
+
+    BoolMatch(const char * _name, Operator _op, const char * _pattern):
+        name(_name), op(_op), valid(_pattern != 0)
+    {
+        if ( valid )
+        {
+            pattern = _pattern;
+        }
+    };
+
+    bool eval(ObjectXML& oxml) const override
+    {
+        if ( !valid )
+        {
+            return false;
+        }
+
+        if ( op == CONTAINS )
+        {
+            std::vector<std::string> vals;
+
+            oxml.search(name.c_str(), vals);
+
+            for (std::vector<std::string>::iterator it = vals.begin();
+                    it != vals.end(); ++it)
+            {
+                if ( fnmatch(pattern.c_str(), it->c_str(), 0) == 0 )
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        std::string val;
+
+        if ( oxml.search(name.c_str(), val) != 0 )
+        {
+            return false;
+        }
+
+        bool match = fnmatch(pattern.c_str(), val.c_str(), 0) == 0;
+
+        return op == EQ ? match : !match;
+    }
+
+private:
+    std::string name;
+
+    Operator op;
+
+    std::string pattern;
+
+    bool valid;
+};
+
+/**
+ *  Logical operators: EXPR & EXPR, EXPR | EXPR and !EXPR. The node owns its
+ *  operands.
+ */
+class BoolLogical : public BoolExpression
+{
+public:
+    enum Operator
+    {
+        AND = 0,
+        OR  = 1,
+        NOT = 2
+    };
+
+    BoolLogical(Operator _op, BoolExpression * _left, BoolExpression * _right):
+        op(_op), left(_left), right(_right){};
+
+    ~BoolLogical()
+    {
+        delete left;
+        delete right;
+    };
+
+    bool eval(ObjectXML& oxml) const override
+    {
+        switch (op)
+        {
+            case AND: return left->eval(oxml) && right->eval(oxml);
+            case OR:  return left->eval(oxml) || right->eval(oxml);
+            case NOT: return !left->eval(oxml);
+        }
+
+        return false;
+    }
+
+private:
+    Operator op;
+
+    BoolExpression * left;
+
+    BoolExpression * right;
+};
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+/* Rank expression nodes                                                      */
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+class ArithConstant : public ArithExpression
+{
+public:
+    ArithConstant(float _value):value(_value){};
+
+    float eval(ObjectXML& oxml) const override
+    {
+        return value;
+    }
+
+private:
+    float value;
+};
+
+/**
+ *  Value of a variable, 0 if it is not defined
+ */
+class ArithVariable : public ArithExpression
+{
+public:
+    ArithVariable(const char * _name):name(_name){};
+
+    float eval(ObjectXML& oxml) const override
+    {
+        float val = 0;
+
+        oxml.search(name.c_str(), val);
+
+        return val;
+    }
+
+private:
+    std::string name;
+};
+
+/**
+ *  Arithmetic operators: +, -, *, / and unary -. The node owns its operands.
+ */
+class ArithOperation : public ArithExpression
+{
+public:
+    enum Operator
+    {
+        ADD = 0,
+        SUB = 1,
+        MUL = 2,
+        DIV = 3,
+        NEG = 4
+    };
+
+    ArithOperation(Operator _op, ArithExpression * _left,
+            ArithExpression * _right): op(_op), left(_left), right(_right){};
+
+    ~ArithOperation()
+    {
+        delete left;
+        delete right;
+    };
+
+    float eval(ObjectXML& oxml) const override
+    {
+        switch (op)
+        {
+            case ADD: return left->eval(oxml) + right->eval(oxml);
+            case SUB: return left->eval(oxml) - right->eval(oxml);
+            case MUL: return left->eval(oxml) * right->eval(oxml);
+            case DIV: return left->eval(oxml) / right->eval(oxml);
+            case NEG: return - left->eval(oxml);
+        }
+
+        return 0;
+    }
+
+private:
+    Operator op;
+
+    ArithExpression * left;
+
+    ArithExpression * right;
+};
+
+#endif /*EXPRESSION_H_*/
@@ -149,6 +149,25 @@ private:
      */
     int select(SqlDB * db);
 
+    /**
+     *  Rebuilds the history record from its DB body, already read by the VM
+     *  or from the pool cache
+     *    @param body of the record as stored in the DB
+     *    @return 0 on success.
+     */
+    int select(const string& body);
+
+    /**
+     *  Reads the history records of a set of VMs with a single query
+     *    @param db pointer to the database.
+     *    @param vids comma separated list of VM ids
+     *    @param records bodies of the history records of each VM, sorted by
+     *    sequence
+     *    @return 0 on success.
+     */
+    static int select_records(SqlDB * db, const string& vids,
+            map<int, vector<string> >& records);
+
     /**
      *  Updates the history record
      *    @param db pointer to the database.
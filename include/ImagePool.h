@@ -114,6 +114,18 @@ public:
         return static_cast<Image *>(PoolSQL::get(oid));
     };
 
+    /**
+     *  Function to get a read only Image snapshot shared with other readers,
+     *  see PoolSQL::get_ro_shared
+     *    @param oid Image unique id
+     *    @return the shared Image, empty if the Image could not be loaded
+     */
+    std::shared_ptr<const Image> get_ro_shared(int oid)
+    {
+        return std::static_pointer_cast<const Image>(
+                PoolSQL::get_ro_shared(oid));
+    };
+
     /**
      *  Gets an object from the pool (if needed the object is loaded from the
      *  database).
@@ -20,6 +20,7 @@
 #include <string>
 #include <sstream>
 #include <set>
+#include <vector>
 
 #include "SqlDB.h"
 
@@ -48,6 +49,13 @@ public:
      */
     std::string sql;
 
+    /**
+     *  SQL command compressed (zlib and base64) as stored in the log. Empty
+     *  if the record was not loaded from the log or set from a compressed
+     *  command
+     */
+    std::string zsql;
+
     /**
      *  Time when the record has been applied to DB. 0 if not applied
      */
@@ -68,6 +76,31 @@ public:
                 static_cast<Callbackable::Callback>(&LogDBRecord::select_cb));
     }
 
+    /**
+     *  Formats of the SQL command when the record is sent to followers
+     */
+    enum SqlFormat
+    {
+        SQL_PLAIN = 0, /**< SQL command text                 */
+        SQL_ZLIB  = 1  /**< SQL command compressed, as zsql  */
+    };
+
+    /**
+     *  Gets the SQL command compressed to send it to followers. The command
+     *  is compressed only if it was not loaded from the log
+     *    @param data the compressed command, empty for an empty command
+     *    @return 0 on success, -1 otherwise
+     */
+    int get_zsql(std::string& data) const;
+
+    /**
+     *  Sets the SQL command of the record as received from the leader
+     *    @param data the SQL command
+     *    @param format of the data (SqlFormat)
+     *    @return 0 on success, -1 otherwise
+     */
+    int set_sql(const std::string& data, int format);
+
 private:
     /**
      *  SQL callback to load logDBRecord from DB (SELECT commands)
@@ -91,7 +124,8 @@ public:
     // Interface to access Log records
     // -------------------------------------------------------------------------
     /**
-     *  Loads a log record from the database. Memory is allocated by this class
+     *  Loads a log record from the database. Recent records are loaded from
+     *  the tail cache if possible. Memory is allocated by this class
      *  and needs to be freed.
      *    @param index of the associated logDB entry
      *    @param lr logDBrecored to load from the DB
@@ -100,9 +134,27 @@ public:
     int get_log_record(uint64_t index, LogDBRecord& lr);
 
     /**
-     *  Applies the SQL command of the given record to the database. The
-     *  timestamp of the record is updated.
+     *  Gets the term of a log record, it does not need the previous record
+     *  to be in the log
      *    @param index of the log record
+     *    @param term of the record
+     *    @return 0 on success -1 otherwise
+     */
+    int get_log_term(uint64_t index, unsigned int& term);
+
+    /**
+     *  Gets the first index that can be replicated, the log has the records
+     *  from it to the last one and the previous one of each. Lower records
+     *  have been purged or replaced by a snapshot.
+     *    @return the first index, 0 if no record has been purged
+     */
+    uint64_t get_first_index();
+
+    /**
+     *  Applies the SQL commands of the records up to the given index to the
+     *  database. Records are applied in groups, each one in a single DB
+     *  transaction. The timestamp of the records is updated.
+     *    @param commit_index of the last log record to apply
      */
     int apply_log_records(uint64_t commit_index);
 
@@ -128,6 +180,27 @@ public:
             std::ostringstream& sql, time_t timestamp, uint64_t fed_index,
             bool replace);
 
+    /**
+     *  Inserts a batch of consecutive log records in the database. All the
+     *  records are written in a single statement (or transaction), existing
+     *  records are replaced. This method should be used in FOLLOWER mode to
+     *  replicate leader log.
+     *    @param lrs the records to insert, in increasing index order
+     *
+     *    @return 0 on sucess, -1 on failure
+     */
+    int insert_log_records(const std::vector<LogDBRecord *>& lrs);
+
+    /**
+     *  Waits until the log has a record at the given index, used to process
+     *  in order the replicate calls sent in the same window.
+     *    @param index of the record
+     *    @param wait_ms max time to wait in milliseconds
+     *
+     *    @return true if the log has the record
+     */
+    bool wait_log_record(uint64_t index, time_t wait_ms);
+
     /**
      *  Replicate a log record on followers. It will also replicate any missing
      *  previous records
@@ -156,11 +229,54 @@ public:
 
     /**
      *  Purge log records. Delete old records applied to database upto the
-     *  LOG_RETENTION configuration variable.
-     *    @return number of records deleted from DB
+     *  LOG_RETENTION configuration variable. The purge is done in steps, each
+     *  call deletes a chunk of the log (purge_chunk records) so writers are
+     *  not blocked for long. It needs to be called while is_purging().
+     *    @return number of records deleted from DB in this purge so far
      */
     int purge_log();
 
+    /**
+     *  @return true if a purge is in progress, see purge_log
+     */
+    bool is_purging();
+
+    // -------------------------------------------------------------------------
+    // Snapshots, to bring up to date followers that need purged records
+    // -------------------------------------------------------------------------
+    /**
+     *  Writes the DB state up to the last applied record to a file. The file
+     *  has the SQL commands to replace the contents of each replicated table.
+     *  The tables are read in a consistent read transaction, records are
+     *  applied while the file is written. The log, the local tables and the
+     *  raft state of this server are not included.
+     *    @param file path of the snapshot
+     *    @param raft_state name of the raft state attribute
+     *    @param local tables not replicated (e.g. monitoring)
+     *    @param index of the last record included in the snapshot
+     *    @param term of the last record included in the snapshot
+     *    @param fed_index last federated index included, UINT64_MAX if none
+     *
+     *    @return 0 on success, -1 otherwise
+     */
+    int create_snapshot(const std::string& file, const std::string& raft_state,
+            const std::set<std::string>& local, uint64_t& index,
+            unsigned int& term, uint64_t& fed_index);
+
+    /**
+     *  Replaces the DB state with the one in a snapshot file, in a single
+     *  transaction. The file is read in batches of commands as they are
+     *  executed. The log is reset to a record for the snapshot index.
+     *    @param file path of the snapshot
+     *    @param index of the last record included in the snapshot
+     *    @param term of the last record included in the snapshot
+     *    @param fed_index last federated index included, UINT64_MAX if none
+     *
+     *    @return 0 on success, -1 otherwise
+     */
+    int install_snapshot(const std::string& file, uint64_t index,
+            unsigned int term, uint64_t fed_index);
+
     // -------------------------------------------------------------------------
     // SQL interface
     // -------------------------------------------------------------------------
@@ -222,6 +338,31 @@ public:
     {
         return db->fts_available();
     }
+
+    /**
+     *  Transactions are not replicated, they can be only used on the
+     *  underlying DB
+     */
+    int exec_transaction(const std::vector<std::string>& cmds)
+    {
+        return SqlDB::INTERNAL;
+    }
+
+    int exec_transaction(SqlCmdReader& reader)
+    {
+        return SqlDB::INTERNAL;
+    }
+
+    int exec_rd_transaction(const std::vector<std::string>& cmds,
+            const std::vector<Callbackable *>& objs, pthread_mutex_t * ready)
+    {
+        return db->exec_rd_transaction(cmds, objs, ready);
+    }
+
+    int get_tables(std::vector<std::string>& tables)
+    {
+        return db->get_tables(tables);
+    }
     // -------------------------------------------------------------------------
     // Database methods
     // -------------------------------------------------------------------------
@@ -276,6 +417,11 @@ protected:
 private:
     pthread_mutex_t mutex;
 
+    /**
+     *  Signaled when new records are added to the log
+     */
+    pthread_cond_t last_cond;
+
     /**
      *  The Database was started in solo mode (no server_id defined)
      */
@@ -321,6 +467,96 @@ private:
      */
     uint64_t limit_purge;
 
+    // -------------------------------------------------------------------------
+    // Purge in progress, see purge_log
+    // -------------------------------------------------------------------------
+    /**
+     *  True while a purge is in progress
+     */
+    bool purging;
+
+    /**
+     *  Next log index to purge
+     */
+    uint64_t purge_next;
+
+    /**
+     *  Applied records below these indexes are purged (non-federated and
+     *  federated records)
+     */
+    uint64_t purge_end;
+
+    uint64_t fed_purge_end;
+
+    /**
+     *  Records purged in the current purge (non-federated and federated)
+     */
+    uint64_t purged;
+
+    uint64_t fed_purged;
+
+    /**
+     *  Starts a new purge, sets the indexes of the records to purge
+     *    @return true if there are records to purge
+     */
+    bool start_purge();
+
+    /**
+     *  Gets the first record to purge from the given index, so chunks
+     *  without records to purge are skipped
+     *    @param index to start the search
+     *    @return the log index, UINT64_MAX if there are no more records
+     */
+    uint64_t next_purge_index(uint64_t index);
+
+    // -------------------------------------------------------------------------
+    // Tail cache. Ring buffer with the last inserted records, so replica
+    // threads of followers up to date do not need to read them from the DB.
+    // A record is stored in slot index % tail_size. The timestamp is the one
+    // set when the record was inserted.
+    // -------------------------------------------------------------------------
+    struct TailRecord
+    {
+        TailRecord():valid(false), index(0), term(0), timestamp(0),
+            fed_index(UINT64_MAX){};
+
+        bool         valid;
+        uint64_t     index;
+        unsigned int term;
+        std::string  sql;
+        std::string  zsql;
+        time_t       timestamp;
+        uint64_t     fed_index;
+    };
+
+    std::vector<TailRecord> tail;
+
+    /**
+     *  Mutex for the tail cache, it is not held while accessing the DB
+     */
+    pthread_mutex_t tail_mutex;
+
+    /**
+     *  Adds a record to the tail cache, replacing the one in its slot
+     */
+    void tail_add(uint64_t index, unsigned int term, const std::string& sql,
+            const std::string& zsql, time_t ts, uint64_t fed_index);
+
+    /**
+     *  Gets a record and the term of the previous one from the tail cache
+     *    @param index of the record
+     *    @param lr the record
+     *    @return true if both records are in the cache
+     */
+    bool tail_get(uint64_t index, LogDBRecord& lr);
+
+    /**
+     *  Removes records from the tail cache
+     *    @param start_index records with index greater or equal are removed,
+     *    0 clears the cache
+     */
+    void tail_delete(uint64_t start_index);
+
     // -------------------------------------------------------------------------
     // Federated Log
     // -------------------------------------------------------------------------
@@ -361,6 +597,35 @@ private:
      */
     int apply_log_record(LogDBRecord * lr);
 
+    /**
+     *  Applies the SQL commands of a group of consecutive records in a single
+     *  transaction. If the transaction fails the records are applied one by
+     *  one.
+     *    @param lrs the log records
+     */
+    int apply_log_group(const std::vector<LogDBRecord *>& lrs);
+
+    /**
+     *  Max number of records applied in a single transaction
+     */
+    static const unsigned int max_apply_group;
+
+    /**
+     *  Max number of consecutive log indexes examined on each purge step
+     */
+    static const unsigned int purge_chunk;
+
+    /**
+     *  Number of records in the tail cache
+     */
+    static const unsigned int tail_size;
+
+    /**
+     *  Max size (bytes) of the SQL commands executed in each batch when a
+     *  snapshot is installed
+     */
+    static const size_t snapshot_batch;
+
     /**
      *  Inserts or update a log record in the database
      *    @param index of the log entry
@@ -375,6 +640,32 @@ private:
     int insert(uint64_t index, unsigned int term, const std::string& sql,
                time_t ts, uint64_t fi, bool replace);
 
+    /**
+     *  Writes the VALUES tuple of a log record, the SQL command is compressed
+     *  and escaped
+     *    @param index of the log entry
+     *    @param term for the log entry
+     *    @param sql command to modify DB state
+     *    @param ts timestamp of record application to DB state
+     *    @param fi the federated index -1 if none
+     *    @param oss stream to write the tuple to
+     *
+     *    @return 0 on success
+     */
+    int to_values(uint64_t index, unsigned int term, const std::string& sql,
+               time_t ts, uint64_t fi, std::ostringstream& oss);
+
+    /**
+     *  Writes the VALUES tuple of a log record with an already compressed
+     *  SQL command, it is only escaped
+     *    @param zsql compressed command to modify DB state
+     *    (see to_values for the other parameters)
+     *
+     *    @return 0 on success
+     */
+    int to_zvalues(uint64_t index, unsigned int term, const std::string& zsql,
+               time_t ts, uint64_t fi, std::ostringstream& oss);
+
     /**
      *  Inserts a new log record in the database. If the record is successfully
      *  inserted the index is incremented
@@ -437,6 +728,27 @@ public:
         return _logdb->fts_available();
     }
 
+    int exec_transaction(const std::vector<std::string>& cmds)
+    {
+        return SqlDB::INTERNAL;
+    }
+
+    int exec_transaction(SqlCmdReader& reader)
+    {
+        return SqlDB::INTERNAL;
+    }
+
+    int exec_rd_transaction(const std::vector<std::string>& cmds,
+            const std::vector<Callbackable *>& objs, pthread_mutex_t * ready)
+    {
+        return _logdb->exec_rd_transaction(cmds, objs, ready);
+    }
+
+    int get_tables(std::vector<std::string>& tables)
+    {
+        return _logdb->get_tables(tables);
+    }
+
     /**
      *  Returns a pointer to the non-federated version of this database. This
      *  is need for objects that stores its data in both federated and
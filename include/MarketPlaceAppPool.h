@@ -24,7 +24,8 @@ class SqlDB;
 class MarketPlaceAppPool : public PoolSQL
 {
 public:
-    MarketPlaceAppPool(SqlDB * db):PoolSQL(db, MarketPlaceApp::table){};
+    MarketPlaceAppPool(SqlDB * db, bool is_federation_slave):
+        PoolSQL(db, MarketPlaceApp::table, !is_federation_slave){};
 
     ~MarketPlaceAppPool(){};
 
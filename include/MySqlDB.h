@@ -90,6 +90,35 @@ public:
      */
      bool fts_available();
 
+    /**
+     *  Executes the commands in a START TRANSACTION/COMMIT block on a single
+     *  connection of the pool.
+     *    @param cmds the SQL commands
+     *    @return SqlError enum, of the failed command if any
+     */
+    int exec_transaction(const std::vector<std::string>& cmds);
+
+    /**
+     *  Executes the commands of the reader in a START TRANSACTION/COMMIT
+     *  block on a single connection of the pool.
+     *    @param reader of the commands
+     *    @return SqlError enum, of the failed command if any
+     */
+    int exec_transaction(SqlCmdReader& reader);
+
+    /**
+     *  Executes the queries in a transaction WITH CONSISTENT SNAPSHOT on a
+     *  single connection of the pool. Rows are fetched one by one.
+     *    @param cmds the SQL queries
+     *    @param objs callback object of each query
+     *    @param ready mutex unlocked once the snapshot is taken, if not 0
+     *    @return SqlError enum, of the failed query if any
+     */
+    int exec_rd_transaction(const std::vector<std::string>& cmds,
+            const std::vector<Callbackable *>& objs, pthread_mutex_t * ready);
+
+    int get_tables(std::vector<std::string>& tables);
+
 protected:
     /**
      *  Wraps the mysql_query function call
@@ -187,6 +216,16 @@ public:
 
     bool fts_available(){return false;};
 
+    int exec_transaction(const std::vector<std::string>& cmds){return -1;};
+
+    int exec_transaction(SqlCmdReader& reader){return -1;};
+
+    int exec_rd_transaction(const std::vector<std::string>& cmds,
+            const std::vector<Callbackable *>& objs,
+            pthread_mutex_t * ready){return -1;};
+
+    int get_tables(std::vector<std::string>& tables){return -1;};
+
 protected:
     int exec_ext(std::ostringstream& cmd, Callbackable *obj, bool quiet){return -1;};
 };
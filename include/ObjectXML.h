@@ -20,8 +20,11 @@
 
 #include <string>
 #include <vector>
+#include <map>
 #include <sstream>
 
+#include <pthread.h>
+
 #include <libxml/tree.h>
 #include <libxml/parser.h>
 #include <libxml/xpath.h>
@@ -37,7 +40,10 @@ public:
 
     // ---------------------- Constructors ------------------------------------
 
-    ObjectXML():xml(0), ctx(0) {}
+    ObjectXML():xml(0)
+    {
+        pthread_mutex_init(&search_mutex, 0);
+    }
 
     /**
      *  Constructs an object using a XML document
@@ -65,7 +71,7 @@ public:
         xmlNodePtr cur;
         xmlChar *  str_ptr;
 
-        obj = xmlXPathEvalExpression(reinterpret_cast<const xmlChar *>(expr),ctx);
+        obj = eval_xpath(expr);
 
         if (obj == 0)
         {
@@ -196,27 +202,40 @@ public:
     template<typename T>
     void search(const char* name, std::vector<T>& results)
     {
-
         if (name[0] == '/')
         {
             xpaths(results, name);
+            return;
         }
-        else if (num_paths == 0)
-        {
-            results.clear();
-        }
-        else
+
+        std::vector<std::string> values;
+
+        search_values(name, values);
+
+        for (std::vector<std::string>::iterator it = values.begin();
+                it != values.end(); ++it)
         {
-            std::ostringstream  xpath;
+            std::istringstream iss(*it);
+            T val;
 
-            xpath << paths[0] << name;
+            iss >> std::dec >> val;
 
-            for (int i = 1; i < num_paths ; i++)
+            if (!iss.fail())
             {
-                xpath << '|' << paths[i] << name;
+                results.push_back(val);
             }
+        }
+    }
 
-            xpaths(results, xpath.str().c_str());
+    void search(const char* name, std::vector<std::string>& results)
+    {
+        if (name[0] == '/')
+        {
+            xpaths(results, name);
+        }
+        else
+        {
+            search_values(name, results);
         }
     }
 
@@ -287,6 +306,20 @@ public:
      */
     int rename_nodes(const char * xpath_expr, const char * new_name);
 
+    /**
+     *  Merges the elements of a pool document into this one. Elements are
+     *  identified by their ID child and kept sorted by ID:
+     *    - The elements with an ID in ids are removed
+     *    - The ID elements in src are inserted, or replace the existing ones
+     *    - Elements without ID (e.g. DEFAULT_USER_QUOTAS) replace those with
+     *      the same name
+     *    @param src root element of the pool with the new elements, can be 0
+     *    @param ids of the elements to be removed
+     *
+     *    @return 0 on success, -1 if the document is empty
+     */
+    int merge_by_id(const xmlNodePtr src, const std::vector<int>& ids);
+
     // ---------------------------------------------------------
     //  Lex & bison parser for requirements and rank expressions
     // ---------------------------------------------------------
@@ -311,6 +344,99 @@ public:
      */
     int eval_arith(const std::string& expr, int& result, char **errmsg);
 
+    /**
+     *  Gets the statistics of the compiled XPath expression caches, added up
+     *  for all the threads
+     *    @param hits number of evaluations using a cached expression
+     *    @param misses number of evaluations that compiled the expression
+     *    @param size number of expressions in the caches
+     */
+    static void xpath_cache_stats(unsigned long& hits, unsigned long& misses,
+            size_t& size);
+
+    // ---------------------------------------------------------
+    //  Single pass access to the object elements
+    // ---------------------------------------------------------
+
+    /**
+     *  Index of the child elements of a node, built in a single pass over the
+     *  node children. It is used by from_xml functions to read the object
+     *  fields without evaluating a XPath expression on the whole document
+     *  for each field. Indexed nodes belong to the document, they MUST NOT be
+     *  freed and are valid until the document is updated.
+     */
+    class ChildIndex
+    {
+    public:
+        /**
+         *  Indexes the children of the root element of the object
+         */
+        ChildIndex(const ObjectXML& oxml);
+
+        /**
+         *  Indexes the children of a node (e.g. the PERMISSIONS element)
+         */
+        ChildIndex(const xmlNodePtr node);
+
+        /**
+         *  Gets the first child element with the given name
+         *    @param name of the element
+         *    @return the node, 0 if not found
+         */
+        xmlNodePtr node(const char * name) const;
+
+        /**
+         *  Gets all the child elements with the given name
+         *    @param name of the elements
+         *    @param content nodes in document order
+         *    @return the number of nodes found
+         */
+        int nodes(const char * name, std::vector<xmlNodePtr>& content) const;
+
+        /**
+         *  Gets the value of the first child element with the given name, if
+         *  not found or it cannot be converted a default is used.
+         *    @param value of the element
+         *    @param name of the element
+         *    @param def default value if the element is not found
+         *
+         *    @return -1 if default was set
+         */
+        template<typename T>
+        int get(T& value, const char * name, const T& def) const
+        {
+            std::string svalue;
+
+            if ( get(svalue, name, "") != 0 )
+            {
+                value = def;
+                return -1;
+            }
+
+            std::istringstream iss(svalue);
+
+            iss >> std::dec >> value;
+
+            if (iss.fail() == true)
+            {
+                value = def;
+                return -1;
+            }
+
+            return 0;
+        }
+
+        int get(std::string& value, const char * name, const char * def) const;
+
+    private:
+        /**
+         *  Child elements by name, in document order for equal names
+         */
+        std::multimap<std::string, xmlNodePtr> children;
+
+        void index(const xmlNodePtr node);
+    };
+
     /**
      *  Function to write the Object in an output stream
      */
@@ -353,14 +479,47 @@ private:
     xmlDocPtr   xml;
 
     /**
-     *  XPath Context to access Object elements
+     *  Parse a XML document
      */
-    xmlXPathContextPtr ctx;
+    void xml_parse(const std::string &xml_doc);
 
     /**
-     *  Parse a XML documents and initializes XPath contexts
+     *  Evaluates a XPath expression on the object document. Expressions are
+     *  compiled once per thread and cached (up to MAX_XPATH_CACHE expressions
+     *  per thread), and they are evaluated using a per-thread XPath context.
+     *    @param expr the XPath expression
+     *    @return the result, it MUST be freed with xmlXPathFreeObject. 0 if
+     *    the expression is not valid or there is no document.
      */
-    void xml_parse(const std::string &xml_doc);
+    xmlXPathObjectPtr eval_xpath(const char * expr) const;
+
+    /**
+     *  Max number of compiled expressions in the cache of each thread
+     */
+    static const size_t MAX_XPATH_CACHE = 4096;
+
+    /**
+     *  Values of the attributes looked up in the object paths, indexed by
+     *  attribute name. Requirement and rank expressions are evaluated for
+     *  each VM on the same object, so the XPath is only evaluated the first
+     *  time. The table is cleared when the document is updated.
+     */
+    std::map<std::string, std::vector<std::string> > search_cache;
+
+    pthread_mutex_t search_mutex;
+
+    /**
+     *  Gets the values of an attribute in the object paths, from the search
+     *  table if it has been already looked up.
+     *    @param name of the attribute
+     *    @param values of the attribute, appended to the vector
+     */
+    void search_values(const char * name, std::vector<std::string>& values);
+
+    /**
+     *  Clears the search table, called when the document is modified
+     */
+    void clear_search_cache();
 
     /**
      *  Search the Object for a given attribute in a set of object specific
@@ -23,10 +23,12 @@
 
 #include <pthread.h>
 #include <string>
+#include <vector>
 
 using namespace std;
 
 class PoolObjectAuth;
+class PoolSQLCache;
 
 /**
  * PoolObject class. Provides a SQL backend interface for Pool components. Each
@@ -184,6 +186,9 @@ public:
              lock_req_id(-1),
              lock_time(0),
              mutex(0),
+             cache(0),
+             db_body(0),
+             db_records(0),
              table(_table)
     {
     };
@@ -532,7 +537,7 @@ public:
      *  attributes
      *    @param auths to be filled
      */
-    virtual void get_permissions(PoolObjectAuth& auths);
+    virtual void get_permissions(PoolObjectAuth& auths) const;
 
     /**
      * Tries to get the DB lock. This is a mutex requested by external
@@ -584,18 +589,27 @@ protected:
      *    @param vaues the column values
      *    @return 0 on success
      */
-    int select_cb(void *nil, int num, char **values, char **names)
+    int select_cb(void *_body, int num, char **values, char **names)
     {
         if ( (!values[0]) || (num != 1) )
         {
             return -1;
         }
 
+        if ( _body != 0 )
+        {
+            *static_cast<string *>(_body) = values[0];
+        }
+
         return from_xml(values[0]);
     };
 
     /**
-     *  Reads the PoolObjectSQL (identified by its OID) from the database.
+     *  Reads the PoolObjectSQL (identified by its OID) from the database. If
+     *  the pool cache is set the object is rebuilt from the cached body and
+     *  the body read from the DB is stored in the cache. Bodies already read
+     *  by the pool (db_body) are used instead of querying the DB, the same
+     *  applies to db_records for objects with records in other tables.
      *    @param db pointer to the db
      *    @return 0 on success
      */
@@ -608,6 +622,21 @@ protected:
      */
     virtual int select(SqlDB *db, const string& _name, int _uid);
 
+    /**
+     *  Gets the records of the object in other tables, if they were read by
+     *  the pool with the body (db_records) or are stored in the pool cache.
+     *    @param records of the object
+     *    @return true if the records were found, false if they need to be
+     *    read from the DB
+     */
+    bool get_db_records(std::vector<string>& records);
+
+    /**
+     *  Stores the records read from the DB in the pool cache, if set.
+     *    @param records of the object
+     */
+    void cache_db_records(const std::vector<string>& records);
+
     /**
      *  Search oid by its name and owner
      *    @param db pointer to the db
@@ -836,6 +865,24 @@ private:
      */
     pthread_mutex_t * mutex;
 
+    /**
+     *  The pool cache, set by the PoolSQL only when the cache line of the
+     *  object is locked
+     */
+    PoolSQLCache * cache;
+
+    /**
+     *  Body of the object read by the PoolSQL in a batch query, if set it is
+     *  used instead of reading the object from the DB
+     */
+    const string * db_body;
+
+    /**
+     *  Records of the object in other tables (e.g. VM history) read by the
+     *  PoolSQL in a batch query with the body, see PoolSQL::select_records
+     */
+    const std::vector<string> * db_records;
+
     /**
      *  Pointer to the SQL table for the PoolObjectSQL
      */
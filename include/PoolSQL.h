@@ -18,6 +18,9 @@
 #define POOL_SQL_H_
 
 #include <string>
+#include <memory>
+#include <map>
+#include <vector>
 
 #include "SqlDB.h"
 #include "PoolObjectSQL.h"
@@ -41,8 +44,13 @@ public:
      *   @param _db a pointer to the database
      *   @param _table the name of the table supporting the pool (to set the oid
      *   counter). If null the OID counter is not updated.
+     *   @param cache_objects false if the pool objects are updated by other
+     *   servers (e.g. federated tables in a slave zone) and cannot be cached
+     *   @param has_records true if the pool objects keep records in other
+     *   tables, see select_records
      */
-    PoolSQL(SqlDB * _db, const char * _table);
+    PoolSQL(SqlDB * _db, const char * _table, bool cache_objects = true,
+            bool has_records = false);
 
     virtual ~PoolSQL();
 
@@ -74,6 +82,37 @@ public:
      */
     PoolObjectSQL * get_ro(int oid);
 
+    /**
+     *  Gets a read only snapshot of the object. The snapshot is shared by all
+     *  the readers until the object is updated or dropped, so it MUST NOT be
+     *  modified. Use it when the object is only inspected (e.g. permissions
+     *  or state checks) to avoid parsing the object on every access.
+     *   @param oid the object unique identifier
+     *
+     *   @return the shared object, empty in case of failure
+     */
+    std::shared_ptr<const PoolObjectSQL> get_ro_shared(int oid);
+
+    /**
+     *  Gets a set of read only objects from the pool. The objects are read
+     *  from the DB in batches of MAX_BATCH_OIDS (SELECT ... WHERE oid IN).
+     *  Each object needs to be freed with unlock().
+     *   @param oids of the objects
+     *   @param objects read, objects that could not be loaded are skipped
+     */
+    void get_ro_many(const std::vector<int>& oids,
+            std::vector<PoolObjectSQL *>& objects);
+
+    /**
+     *  Loads the DB body of a set of objects in the pool cache, using batched
+     *  queries. Following get() or get_ro() calls for these objects do not
+     *  need to query the DB unless they are updated in the meantime. Use it
+     *  before iterating over a set of objects that need to be locked one at a
+     *  time. Objects in use by other threads are not loaded.
+     *   @param oids of the objects
+     */
+    void prefetch(const std::vector<int>& oids);
+
     /**
      *  Check if there is an object with the same for a given user
      *    @param name of object
@@ -135,7 +174,13 @@ public:
     virtual int update(
         PoolObjectSQL * objsql)
     {
-        return objsql->update(db);;
+        cache.invalidate(objsql->oid);
+
+        int rc = objsql->update(db);
+
+        record_change(objsql->oid);
+
+        return rc;
     };
 
     /**
@@ -147,8 +192,12 @@ public:
      */
     virtual int drop(PoolObjectSQL * objsql, string& error_msg)
     {
+        cache.invalidate(objsql->oid);
+
         int rc  = objsql->drop(db);
 
+        record_change(objsql->oid);
+
         if ( rc != 0 )
         {
             error_msg = "SQL DB error";
@@ -203,6 +252,36 @@ public:
         return dump(oss, where, limit, desc);
     }
 
+    // -------------------------------------------------------------------------
+    // Change feed of the pool
+    // -------------------------------------------------------------------------
+
+    /**
+     *  Gets the objects allocated, updated or dropped since a version of the
+     *  pool. Changes are only tracked while this oned is the only writer of
+     *  the pool (see PoolSQLCache::enable), and only the last MAX_CHANGES
+     *  changed objects are kept.
+     *    @param version of the pool returned by a previous call, it is set to
+     *    the current version of the pool ("" if changes are not tracked).
+     *    Objects changed after it are always included in the next call.
+     *    @param oids of the objects changed since version
+     *    @return 0 on success, -1 if the changes since version are not known
+     *    and the whole pool needs to be read
+     */
+    int get_changes(string& version, vector<int>& oids);
+
+    /**
+     *  Gets the statistics of the object cache of the pool
+     *    @param hits number of accesses served from the cache
+     *    @param misses number of accesses that read the DB
+     *    @param objects number of cached objects
+     */
+    void get_cache_stats(unsigned long& hits, unsigned long& misses,
+            unsigned long& objects)
+    {
+        cache.get_stats(hits, misses, objects);
+    }
+
     // -------------------------------------------------------------------------
     // Function to generate dump filters
     // -------------------------------------------------------------------------
@@ -284,6 +363,38 @@ public:
      }
 protected:
 
+    /**
+     *  Invalidates the cached body and records of an object. It MUST be
+     *  called before writing the object records in other tables.
+     *    @param oid of the object
+     */
+    void invalidate_cache(int oid)
+    {
+        cache.invalidate(oid);
+    };
+
+    /**
+     *  Reads the records that a set of objects keep in other tables (e.g. the
+     *  VM history) with a single query. They are passed to the objects built
+     *  by select_many (db_records) and cached with their bodies. Pools with
+     *  records (has_records) MUST implement this function.
+     *    @param oids comma separated list of object ids
+     *    @param records of each object, objects without records are omitted
+     *    @return 0 on success
+     */
+    virtual int select_records(const string& oids,
+            std::map<int, std::vector<string> >& records)
+    {
+        return 0;
+    };
+
+    /**
+     *  Adds an object to the change feed of the pool. It MUST be called after
+     *  the object is written to the DB.
+     *    @param oid of the object
+     */
+    void record_change(int oid);
+
     /**
      *  Gets an object from the pool (if needed the object is loaded from the
      *  database).
@@ -387,11 +498,87 @@ private:
     string table;
 
     /**
-     *  The pool cache is implemented with a Map of SQL object pointers,
-     *  using the OID as key.
+     *  The pool cache stores the object locks and the DB body of the most
+     *  recently used objects, using the OID as key.
      */
     PoolSQLCache cache;
 
+    /**
+     *  OIDs are assigned from a block [next_oid, block_oid] reserved by this
+     *  pool. The end of the block is stored as last_oid in pool_control
+     *  before any OID of the block is used, so no OID is reused after a crash
+     *  (unused OIDs of the block are skipped). Blocks are only reserved while
+     *  this oned is the only writer of the pool, see PoolSQLCache::enable.
+     */
+    static const int OID_BLOCK_SIZE = 100;
+
+    int next_oid;
+
+    int block_oid;
+
+    /**
+     *  Cache generation when the block was reserved, the block is discarded
+     *  if it changes (e.g. this server is no longer the zone leader)
+     */
+    unsigned int block_generation;
+
+    /**
+     *  Gets the next OID to allocate an object, reserving a new OID block if
+     *  needed. The pool MUST be locked.
+     *    @return the OID or -1 if it could not be stored in pool_control
+     */
+    int next_lastOID();
+
+    /**
+     *  Returns the last OID given by next_lastOID, used when the object could
+     *  not be inserted. The pool MUST be locked.
+     *    @param oid the OID that was not used
+     */
+    void release_lastOID(int oid);
+
+    /**
+     *  Change feed. Each change gets a new version, the last version of each
+     *  object is stored in changes and indexed by version in changes_log.
+     *  Versions are reported as <epoch>.<cache generation>.<version>, the
+     *  epoch and generation invalidate versions of other oned processes or
+     *  of a previous leader term.
+     */
+    static const size_t MAX_CHANGES = 100000;
+
+    pthread_mutex_t changes_mutex;
+
+    time_t changes_epoch;
+
+    unsigned long long changes_version;
+
+    /**
+     *  Oldest version that can be used to get the changes, older changes
+     *  have been removed from the feed
+     */
+    unsigned long long changes_min;
+
+    map<int, unsigned long long> changes;
+
+    map<unsigned long long, int> changes_log;
+
+    /**
+     *  Max number of objects read in a single query by get_ro_many and
+     *  prefetch
+     */
+    static const unsigned int MAX_BATCH_OIDS = 500;
+
+    /**
+     *  Reads a set of objects in batches, with their records. Objects cached
+     *  with their records are not read. No cache line is locked during the
+     *  query. The bodies are cached afterwards if the objects were not
+     *  locked by a writer meanwhile (see PoolSQLCache::get_ticket).
+     *   @param oids of the objects
+     *   @param objects if not null, the read only objects are built from the
+     *   bodies. Otherwise only the bodies of objects not in use are cached.
+     */
+    void select_many(const std::vector<int>& oids,
+            std::vector<PoolObjectSQL *> * objects);
+
     /**
      *  Factory method, must return an ObjectSQL pointer to an allocated pool
      *  specific object.
@@ -19,39 +19,192 @@
 
 #include <map>
 #include <string>
+#include <vector>
 #include <queue>
+#include <atomic>
+#include <memory>
 #include <pthread.h>
 
 #include "PoolObjectSQL.h"
 
 /**
- *  This class stores the active reference to pool objects. It can also
- *  cache to not reload object state from the DB.
+ *  This class stores the active reference to pool objects. It also caches
+ *  the DB representation (body) of the objects so they are not reloaded from
+ *  the DB on every access.
  *
- *  Access to the cache needs to happen in a critical section.
+ *  Read-only accesses can also share a single immutable instance of the object
+ *  built from the cached body, see PoolSQL::get_ro_shared.
+ *
+ *  A cached body (or instance) is only written by a thread holding the cache
+ *  line lock, and it is invalidated before the object is updated or dropped
+ *  in the DB. Lines are evicted following a CLOCK (second chance) policy.
+ *
+ *  The cache lines are distributed in shards by oid. Access to each shard
+ *  needs to happen in a critical section.
  */
 class PoolSQLCache
 {
 public:
 
-    PoolSQLCache();
+    PoolSQLCache(const std::string& table, bool cache_objects,
+            bool has_records);
 
-    virtual ~PoolSQLCache()
-    {
-        pthread_mutex_destroy(&mutex);
-    };
+    virtual ~PoolSQLCache(){};
 
     /**
      *  Allocates a new cache line to hold an active pool object. If the line
-     *  does not exist it is created. Any active reference is deallocated to
-     *  load a fresh copy of the object.
+     *  does not exist it is created.
      *
-     *  The cache line is locked to sync access to the given object.
+     *  The cache line is locked to sync access to the given object. The shared
+     *  read-only instance of the object, if any, is released.
      *
      *  @param oid of the object
      */
     pthread_mutex_t * lock_line(int oid);
 
+    /**
+     *  Locks the cache line of an object only if it is not in use. It is used
+     *  by read-only accesses to populate the cache.
+     *
+     *  @param oid of the object
+     *  @return the locked cache line mutex, 0 if the line is in use
+     */
+    pthread_mutex_t * trylock_line(int oid);
+
+    /**
+     *  Gets the cached body of an object.
+     *    @param oid of the object
+     *    @param body of the object as stored in the DB
+     *
+     *    @return true if the body was found in the cache
+     */
+    bool get(int oid, std::string& body);
+
+    /**
+     *  Gets the cached body of an object together with its records, see
+     *  set_records.
+     *    @param oid of the object
+     *    @param body of the object as stored in the DB
+     *    @param records of the object as stored in the DB
+     *
+     *    @return true if both the body and the records were found
+     */
+    bool get(int oid, std::string& body, std::vector<std::string>& records);
+
+    /**
+     *  Stores the body of an object in the cache. The cache line of the
+     *  object MUST be locked.
+     *    @param oid of the object
+     *    @param body of the object as read from the DB
+     */
+    void set(int oid, const std::string& body);
+
+    /**
+     *  Gets a ticket to cache a body read from the DB without holding the
+     *  cache line lock (see set with ticket). The line MUST NOT be locked by
+     *  the caller.
+     *    @param oid of the object
+     *    @param ticket to cache the body
+     *
+     *    @return false if the body cannot be cached, the line is in use
+     */
+    bool get_ticket(int oid, unsigned long& ticket);
+
+    /**
+     *  Stores the body of an object read without holding the cache line lock.
+     *  The body is only stored if no writer locked the line since the ticket
+     *  was issued, i.e. it is not older than the DB.
+     *    @param oid of the object
+     *    @param body of the object as read from the DB
+     *    @param ticket issued before reading the body
+     */
+    void set(int oid, const std::string& body, unsigned long ticket);
+
+    /**
+     *  Gets the cached records of an object. The cache line of the object
+     *  MUST be locked.
+     *    @param oid of the object
+     *    @param records of the object as stored in the DB
+     *
+     *    @return true if the records were found in the cache
+     */
+    bool get_records(int oid, std::vector<std::string>& records);
+
+    /**
+     *  Stores the records that the object keeps in other tables (e.g. the VM
+     *  history) along with its cached body. They are discarded when a new
+     *  body is stored or the line is invalidated. The cache line of the
+     *  object MUST be locked.
+     *    @param oid of the object
+     *    @param records of the object as read from the DB
+     */
+    void set_records(int oid, const std::vector<std::string>& records);
+
+    /**
+     *  Stores the records of an object read without holding the cache line
+     *  lock, see set with ticket.
+     *    @param oid of the object
+     *    @param records of the object as read from the DB
+     *    @param ticket issued before reading the body and the records
+     */
+    void set_records(int oid, const std::vector<std::string>& records,
+            unsigned long ticket);
+
+    /**
+     *  Gets the shared read-only instance of an object.
+     *    @param oid of the object
+     *    @param object the shared instance
+     *
+     *    @return true if the instance was found in the cache
+     */
+    bool get(int oid, std::shared_ptr<const PoolObjectSQL>& object);
+
+    /**
+     *  Stores a read-only instance of the object to be shared by readers until
+     *  the object is locked by a writer or invalidated. The cache line of the
+     *  object MUST be locked.
+     *    @param oid of the object
+     *    @param object built from the cached body
+     */
+    void set(int oid, const std::shared_ptr<const PoolObjectSQL>& object);
+
+    /**
+     *  Invalidates the cached body and records of an object. This function
+     *  needs to be called before updating or dropping the object in the DB.
+     *    @param oid of the object
+     */
+    void invalidate(int oid);
+
+    /**
+     *  Enables (or disables) object caching for all the pools. Cached bodies
+     *  are only consistent with the DB when this oned is its only writer, i.e.
+     *  in solo mode or as zone leader. Every call discards the cached objects.
+     *    @param enable true to use cached objects
+     */
+    static void enable(bool enable);
+
+    /**
+     *  Gets the cache statistics, aggregated for all the shards
+     *    @param hits number of accesses served from the cache
+     *    @param misses number of accesses that read the DB
+     *    @param objects number of cache lines
+     */
+    void get_stats(unsigned long& hits, unsigned long& misses,
+            unsigned long& objects);
+
+    /**
+     *  Gets the current cache generation.
+     *    @param _generation of the cache
+     *    @return true if the pool objects can be cached, i.e. this oned is the
+     *    only writer of the pool
+     */
+    bool get_generation(unsigned int& _generation) const
+    {
+        _generation = generation;
+
+        return cache_objects && enabled;
+    }
+
 private:
     /**
      *  This class represents a cache line. It stores a reference to the pool
@@ -59,7 +212,9 @@ private:
      */
     struct CacheLine
     {
-        CacheLine():active(0)
+        CacheLine(unsigned long _stamp):active(0), cached(false),
+            records_cached(false), referenced(false), generation(0),
+            stamp(_stamp)
         {
             pthread_mutex_init(&mutex, 0);
         };
@@ -93,38 +248,160 @@ private:
          *  Number of threads waiting on the line mutex
          */
         int active;
+
+        /**
+         *  Body of the object as stored in the DB, valid if cached is true
+         */
+        std::string body;
+
+        bool cached;
+
+        /**
+         *  Records of the object in other tables, valid if records_cached
+         *  is true. They belong to the cached body.
+         */
+        std::vector<std::string> records;
+
+        bool records_cached;
+
+        /**
+         *  Read-only instance of the object built from body, it is released
+         *  when the line is invalidated or deleted
+         */
+        std::shared_ptr<const PoolObjectSQL> object;
+
+        /**
+         *  CLOCK reference bit, set on each access to the cached body
+         */
+        bool referenced;
+
+        /**
+         *  Cache generation when the body was stored
+         */
+        unsigned int generation;
+
+        /**
+         *  Shard sequence when the line was created or last locked by a
+         *  writer, see get_ticket
+         */
+        unsigned long stamp;
     };
 
     /**
-     *  Max number of references in the cache.
+     *  A shard of the cache. Each shard stores the lines of a subset of the
+     *  objects (oid % NUM_SHARDS) and has its own lock, so accesses and line
+     *  reclamation do not block objects in other shards.
+     */
+    struct CacheShard
+    {
+        CacheShard():accesses(0), hits(0), misses(0), seq(0)
+        {
+            pthread_mutex_init(&mutex, 0);
+        };
+
+        ~CacheShard();
+
+        void lock()
+        {
+            pthread_mutex_lock(&mutex);
+        };
+
+        void unlock()
+        {
+            pthread_mutex_unlock(&mutex);
+        }
+
+        /**
+         *  Gets the cache line for the object, it is created if it does not
+         *  exist. The shard mutex MUST be locked.
+         */
+        CacheLine * get_line(int oid);
+
+        /**
+         *  Flushes the cache lines every MAX_ELEMENTS accesses if the shard is
+         *  full. The shard mutex MUST be locked.
+         *    @return true if the shard was flushed
+         */
+        bool check_flush();
+
+        /**
+         *  Deletes the cache lines that are not in use and have not been
+         *  referenced since the last flush.
+         */
+        void flush_cache_lines();
+
+        /**
+         *  Controls concurrent access to the lines map.
+         */
+        pthread_mutex_t mutex;
+
+        /**
+         *  Cache of pool objects indexed by their oid
+         */
+        std::map<int, CacheLine *> lines;
+
+        /**
+         *  Number of accesses since the last flush, and cache statistics
+         */
+        unsigned int accesses;
+
+        unsigned long hits;
+
+        unsigned long misses;
+
+        /**
+         *  Incremented each time a writer locks a line of the shard
+         */
+        unsigned long seq;
+    };
+
+    /**
+     *  Number of shards in the cache
+     */
+    static const unsigned int NUM_SHARDS = 32;
+
+    /**
+     *  Max number of references in each cache shard.
      */
     static unsigned int MAX_ELEMENTS;
 
     /**
-     *  Cache of pool objects indexed by their oid
+     *  Global cache state, see enable()
      */
-    std::map<int, CacheLine *> cache;
+    static std::atomic<bool> enabled;
+
+    static std::atomic<unsigned int> generation;
 
     /**
-     *  Deletes all cache lines if they are not in use.
+     *  Name of the pool table, used for logging
      */
-    void flush_cache_lines();
+    std::string table;
 
     /**
-     *  Controls concurrent access to the cache map.
+     *  Objects of this pool can be cached (i.e. not updated by federation
+     *  replication)
      */
-    pthread_mutex_t mutex;
+    bool cache_objects;
 
-    void lock()
-    {
-        pthread_mutex_lock(&mutex);
-    };
+    /**
+     *  Objects of this pool keep records in other tables that need to be
+     *  cached with the body (see set_records). Otherwise the body alone is
+     *  the cached object.
+     */
+    bool has_records;
+
+    CacheShard shards[NUM_SHARDS];
 
-    void unlock()
+    CacheShard& get_shard(int oid)
     {
-        pthread_mutex_unlock(&mutex);
+        return shards[static_cast<unsigned int>(oid) % NUM_SHARDS];
     }
+
+    /**
+     *  Logs the cache statistics, aggregated for all the shards. It is called
+     *  each time a shard is flushed.
+     */
+    void log_stats();
 };
 
 #endif /*POOL_SQL_CACHE_H_*/
-
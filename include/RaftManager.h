@@ -23,6 +23,8 @@
 #include "Template.h"
 #include "ExecuteHook.h"
 
+#include <vector>
+
 extern "C" void * raft_manager_loop(void *arg);
 
 extern "C" void * reconciling_thread(void *arg);
@@ -54,10 +56,14 @@ public:
      *   @param bcast heartbeat broadcast timeout
      *   @param election timeout
      *   @param xmlrpc timeout for RAFT related xmlrpc API calls
+     *   @param batch_records max number of records sent in a replicate call
+     *   @param batch_size max size of the records sent in a replicate call
+     *   @param window max number of replicate calls in flight to a follower
      **/
     RaftManager(int server_id, const VectorAttribute * leader_hook_mad,
         const VectorAttribute * follower_hook_mad, time_t log_purge,
         long long bcast, long long election, time_t xmlrpc,
+        unsigned int batch_records, size_t batch_size, unsigned int window,
         const string& remotes_location);
 
     ~RaftManager()
@@ -68,25 +74,60 @@ public:
         pthread_mutex_destroy(&mutex);
     };
 
+    /**
+     *  Version of the replication protocol of this server. Followers report
+     *  it in the replies to the replicate calls, servers that do not report
+     *  it (version 0) only get one record per call as plain SQL:
+     *    1. Batches of records (extra records array) and compressed SQL
+     *    2. Windows of calls, the follower waits for the record previous to
+     *       the batch if it is in flight (max wait time parameter)
+     */
+    static const int REPLICA_VERSION;
+
     // -------------------------------------------------------------------------
     // Raft associated actions (synchronous)
     // -------------------------------------------------------------------------
     /**
-     *  Follower successfully replicated a log entry:
+     *  Follower successfully replicated a batch of log entries, from its next
+     *  entry up to last_index:
      *    - Increment next entry to send to follower
      *    - Update match entry on follower
      *    - Evaluate majority to apply changes to DB
+     *    @param follower_id of the server
+     *    @param last_index of the batch replicated
      */
-    void replicate_success(int follower_id);
+    void replicate_success(int follower_id, uint64_t last_index);
 
     /**
      *  Follower failed to replicate a log entry because an inconsistency was
      *  detected (same index, different term):
      *    - Decrease follower next_index
      *    - Retry (do not wait for replica events)
+     *  Only the first call of a replication window needs to be considered, as
+     *  next_index is not advanced past the first failed call.
      */
     void replicate_failure(int follower_id);
 
+    /**
+     *  Follower successfully installed a snapshot of the DB state, up to
+     *  index. Replication continues with the next record.
+     *    @param follower_id of the server
+     *    @param index of the last record included in the snapshot
+     */
+    void snapshot_success(int follower_id, uint64_t index);
+
+    /**
+     *  Writes a snapshot of the DB state to a file, to send it to a follower
+     *  that needs records already purged from the log.
+     *    @param file path of the snapshot
+     *    @param index of the last record included in the snapshot
+     *    @param term of the last record included in the snapshot
+     *    @param fed_index last federated index included in the snapshot
+     *    @return 0 on success, -1 otherwise
+     */
+    int create_snapshot(const std::string& file, uint64_t& index,
+            unsigned int& term, uint64_t& fed_index);
+
     /**
      *  Triggers a REPLICATE event, it will notify the replica threads to
      *  send the log to the followers
@@ -245,6 +286,42 @@ public:
         return _index;
     }
 
+    /**
+     *  @param rindex of a log record
+     *  @return true if the record can be sent to the followers
+     */
+    bool is_replicable(uint64_t rindex)
+    {
+        return requests.is_replicable(rindex);
+    }
+
+    /**
+     *  Limits of the log record batches sent in a replicate call
+     *    @param records max number of records
+     *    @param size max size of the SQL commands of the records
+     */
+    void get_batch_limits(unsigned int& records, size_t& size) const
+    {
+        records = batch_records;
+        size    = batch_size;
+    }
+
+    /**
+     *  Gets the version of the replication protocol of a follower, as
+     *  reported in the last successful replicate call
+     *    @param follower_id of the server
+     *    @return the version, 0 if the follower has not reported it
+     */
+    int get_replica_version(int follower_id);
+
+    /**
+     *  @return max number of replicate calls in flight to a follower
+     */
+    unsigned int get_replica_window() const
+    {
+        return replica_window;
+    }
+
     /**
      * Gets the endpoint for xml-rpc calls of the current leader
      *   @param endpoint
@@ -265,8 +342,115 @@ public:
      *    @return -1 if a XMl-RPC (network) error occurs, 0 otherwise
      */
 	int xmlrpc_replicate_log(int follower_id, LogDBRecord * lr, bool& success,
+			unsigned int& ft, std::string& error)
+    {
+        std::vector<LogDBRecord *> lrs(1, lr);
+
+        return xmlrpc_replicate_log(follower_id, lrs, success, ft, error);
+    }
+
+    /**
+     *  Result of a replicate xml-rpc call
+     */
+    struct ReplicaResult
+    {
+        ReplicaResult():rc(-1), success(false), fterm(0){};
+
+        /**
+         *  -1 if a XMl-RPC (network) error occurs, 0 otherwise
+         */
+        int rc;
+
+        /**
+         *  Success of the xml-rpc method
+         */
+        bool success;
+
+        /**
+         *  Term in the follower as returned by the replicate call
+         */
+        unsigned int fterm;
+
+        /**
+         *  Describing the error if any
+         */
+        std::string error;
+    };
+
+    /**
+     *  Calls the follower xml-rpc method to replicate a batch of consecutive
+     *  records. The first record is sent as in a single record call, the
+     *  rest are added as an extra array parameter. The SQL commands are sent
+     *  compressed, the format is set in the last parameter. Followers that
+     *  do not support it (see REPLICA_VERSION) only accept one plain record.
+	 *    @param follower_id to make the call
+     *    @param lrs the records to replicate, in increasing index order
+     *    @param success of the xml-rpc method
+     *    @param ft term in the follower as returned by the replicate call
+	 *    @param error describing error if any
+     *    @return -1 if a XMl-RPC (network) error occurs, 0 otherwise
+     */
+	int xmlrpc_replicate_log(int follower_id,
+            const std::vector<LogDBRecord *>& lrs, bool& success,
 			unsigned int& ft, std::string& error);
 
+    /**
+     *  Batches of records replicated to a follower in a window of calls,
+     *  see xmlrpc_replicate_log
+     */
+    class ReplicaBatches
+    {
+    public:
+        virtual ~ReplicaBatches(){};
+
+        /**
+         *  Gets the next batch to replicate, it follows the previous one
+         *    @return the records of the batch in increasing index order, 0
+         *    if there are no more batches. They are not freed by the caller.
+         */
+        virtual const std::vector<LogDBRecord *> * next_batch() = 0;
+
+        /**
+         *  Processes the result of the oldest batch in flight
+         *    @param lrs the records of the batch
+         *    @param rr result of the replicate call
+         *    @return false to stop replicating batches
+         */
+        virtual bool batch_result(const std::vector<LogDBRecord *>& lrs,
+                const ReplicaResult& rr) = 0;
+    };
+
+    /**
+     *  Calls the follower xml-rpc method once for each batch of records,
+     *  with up to the replica window calls in flight (sliding window). A new
+     *  batch is sent as soon as the oldest one is replied. The follower
+     *  waits for the previous records of the window (see REPLICA_VERSION).
+	 *    @param follower_id to make the calls
+     *    @param batches to replicate
+     *    @return -1 if a XMl-RPC (network) error occurs in any call, 0
+     *    otherwise
+     */
+	int xmlrpc_replicate_log(int follower_id, ReplicaBatches& batches);
+
+    /**
+     *  Calls the follower xml-rpc method to send a chunk of a snapshot
+	 *    @param follower_id to make the call
+     *    @param index of the last record included in the snapshot
+     *    @param sterm term of the last record included in the snapshot
+     *    @param fed_index last federated index included in the snapshot
+     *    @param offset of the chunk in the snapshot file
+     *    @param data of the chunk (compressed)
+     *    @param done true for the last chunk, the follower installs the
+     *    snapshot
+     *    @param success of the xml-rpc method
+     *    @param ft term in the follower as returned by the snapshot call
+	 *    @param error describing error if any
+     *    @return -1 if a XMl-RPC (network) error occurs, 0 otherwise
+     */
+    int xmlrpc_snapshot(int follower_id, uint64_t index, unsigned int sterm,
+            uint64_t fed_index, uint64_t offset, const std::string& data,
+            bool done, bool& success, unsigned int& ft, std::string& error);
+
     /**
      *  Calls the request vote xml-rpc method
 	 *    @param follower_id to make the call
@@ -400,6 +584,18 @@ private:
 
 	struct timespec broadcast_timeout;
 
+    //--------------------------------------------------------------------------
+    //  Replication batches
+    //    - batch_records. Max number of records sent in a replicate call
+    //    - batch_size. Max size of the records sent in a replicate call
+    //    - replica_window. Max number of replicate calls in flight
+    //--------------------------------------------------------------------------
+    unsigned int batch_records;
+
+    size_t batch_size;
+
+    unsigned int replica_window;
+
     //--------------------------------------------------------------------------
     // Volatile log index variables
     //   - commit, highest log known to be committed
@@ -410,6 +606,7 @@ private:
     //   - next, next log to send to each follower <follower, next>
     //   - match, highest log replicated in this server <follower, match>
 	//   - servers, list of servers in zone and xml-rpc edp <follower, edp>
+    //   - versions, replication protocol of each follower <follower, version>
     // -------------------------------------------------------------------------
     RaftReplicaManager replica_manager;
 
@@ -423,6 +620,8 @@ private:
 
     std::map<int, std::string>  servers;
 
+    std::map<int, int> versions;
+
     // -------------------------------------------------------------------------
     // Hooks
     // -------------------------------------------------------------------------
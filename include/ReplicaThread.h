@@ -18,6 +18,8 @@
 #define REPLICA_THREAD_H_
 
 #include <pthread.h>
+#include <stdint.h>
+#include <vector>
 
 extern "C" void * replication_thread(void *arg);
 
@@ -107,6 +109,7 @@ private:
 // followers
 // -----------------------------------------------------------------------------
 class LogDB;
+class LogDBRecord;
 class RaftManager;
 
 class RaftReplicaThread : public ReplicaThread
@@ -117,11 +120,38 @@ public:
     virtual ~RaftReplicaThread(){};
 
 private:
+    /**
+     *  Batches of records in flight to the follower
+     */
+    class ReplicaWindow;
+
     /**
      * Specific logic for the replicate process
      */
     int replicate();
 
+    /**
+     *  Loads a batch of consecutive records within the batch limits. The first
+     *  record is always loaded.
+     *    @param index of the first record
+     *    @param last_index of the log
+     *    @param max_records in the batch
+     *    @param max_size of the SQL commands of the batch
+     *    @param lrs the records, memory is allocated and needs to be freed
+     *    @return 0 on success, -1 if the first record cannot be loaded
+     */
+    int load_batch(uint64_t index, uint64_t last_index,
+            unsigned int max_records, size_t max_size,
+            std::vector<LogDBRecord *>& lrs);
+
+    /**
+     *  Sends a snapshot of the DB state to the follower, when the records it
+     *  needs have been purged from the log. The snapshot is sent in chunks of
+     *  the batch size.
+     *    @return 0 on success, -1 otherwise
+     */
+    int send_snapshot();
+
     /**
      * Pointers to other components
      */
@@ -382,4 +382,113 @@ public:
             xmlrpc_c::paramList const& paramList, RequestAttributes& att) override;
 };
 
+/* ------------------------------------------------------------------------- */
+/* ------------------------------------------------------------------------- */
+/* ------------------------------------------------------------------------- */
+
+/**
+ *  Returns the objects of a pool changed since a given version of the pool
+ *  (see PoolSQL::get_changes). Clients keep a copy of the pool and apply the
+ *  changes. The response is:
+ *    <POOL_DELTA>
+ *      <VERSION>: version of the pool to use in the next call
+ *      <FULL>: 1 if the whole pool is included, the copy must be replaced
+ *      <CHANGED>: IDs of the changed objects, those not included in the pool
+ *      have been deleted (or no longer match the pool filter)
+ *      <..._POOL>: the changed objects
+ *    </POOL_DELTA>
+ */
+class RequestManagerPoolInfoDelta : public RequestManagerPoolInfoFilter
+{
+protected:
+    RequestManagerPoolInfoDelta(const string& method_name,
+                                const string& help)
+        :RequestManagerPoolInfoFilter(method_name, help, "A:ss"){};
+
+    void request_execute(
+            xmlrpc_c::paramList const& paramList, RequestAttributes& att) override;
+
+    /**
+     *  Builds the where filter of the objects the user can access
+     *    @param att the XML-RPC Attributes with user information
+     *    @param and_clause filter of the pool objects
+     *    @param where_string will store the resulting SQL filter
+     */
+    virtual void delta_filter(RequestAttributes& att, const string& and_clause,
+            string& where_string)
+    {
+        where_filter(att, ALL, -1, -1, and_clause, "", false, false, false,
+                where_string);
+    };
+
+    /**
+     *  Filter of the objects included in the pool (e.g. VM state)
+     */
+    string and_clause;
+
+    /**
+     *  Max number of changed objects sent in a delta, the whole pool is sent
+     *  if more objects have been changed
+     */
+    static const size_t MAX_DELTA_OIDS = 5000;
+};
+
+/* ------------------------------------------------------------------------- */
+/* ------------------------------------------------------------------------- */
+
+class VirtualMachinePoolInfoDelta : public RequestManagerPoolInfoDelta
+{
+public:
+    VirtualMachinePoolInfoDelta();
+};
+
+/* ------------------------------------------------------------------------- */
+/* ------------------------------------------------------------------------- */
+
+class HostPoolInfoDelta : public RequestManagerPoolInfoDelta
+{
+public:
+    HostPoolInfoDelta();
+};
+
+/* ------------------------------------------------------------------------- */
+/* ------------------------------------------------------------------------- */
+
+class DatastorePoolInfoDelta : public RequestManagerPoolInfoDelta
+{
+public:
+    DatastorePoolInfoDelta();
+};
+
+/* ------------------------------------------------------------------------- */
+/* ------------------------------------------------------------------------- */
+
+class VirtualNetworkPoolInfoDelta : public RequestManagerPoolInfoDelta
+{
+public:
+    VirtualNetworkPoolInfoDelta();
+
+protected:
+    void delta_filter(RequestAttributes& att, const string& and_clause,
+            string& where_string) override;
+};
+
+/* ------------------------------------------------------------------------- */
+/* ------------------------------------------------------------------------- */
+
+class UserPoolInfoDelta : public RequestManagerPoolInfoDelta
+{
+public:
+    UserPoolInfoDelta();
+};
+
+/* ------------------------------------------------------------------------- */
+/* ------------------------------------------------------------------------- */
+
+class ClusterPoolInfoDelta : public RequestManagerPoolInfoDelta
+{
+public:
+    ClusterPoolInfoDelta();
+};
+
 #endif
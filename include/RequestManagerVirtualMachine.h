@@ -141,7 +141,6 @@ public:
 
     ~VirtualMachineDeploy() = default;
 
-protected:
     void request_execute(xmlrpc_c::paramList const& _paramList,
             RequestAttributes& att) override;
 };
@@ -162,9 +161,46 @@ public:
 
     ~VirtualMachineMigrate() = default;
 
+    void request_execute(xmlrpc_c::paramList const& _paramList,
+            RequestAttributes& att) override;
+};
+
+/* ------------------------------------------------------------------------- */
+/* ------------------------------------------------------------------------- */
+
+/**
+ *  Deploys or migrates a list of VMs in a single call (used by the scheduler).
+ *  Each element of the list is an array:
+ *    [VM ID, HOST ID, SYSTEM DS ID, EXTRA TEMPLATE, MIGRATE, LIVE, CLEAR]
+ *  MIGRATE selects one.vm.migrate instead of one.vm.deploy, and CLEAR removes
+ *  SCHED_MESSAGE from the user template of the VMs successfully dispatched.
+ *  Each VM is authorized and processed as in the single VM calls, the
+ *  result of each one is returned as:
+ *    <DEPLOY_RESULTS>
+ *      <VM><ID/><SUCCESS/><ERROR/></VM>
+ *    </DEPLOY_RESULTS>
+ */
+class VirtualMachineDeployMulti : public RequestManagerVirtualMachine
+{
+public:
+    VirtualMachineDeployMulti():
+        RequestManagerVirtualMachine("one.vm.deploymulti",
+                                     "Deploys a list of virtual machines",
+                                     "A:sA")
+    {
+        vm_action = VMActions::DEPLOY_ACTION;
+    }
+
+    ~VirtualMachineDeployMulti() = default;
+
 protected:
     void request_execute(xmlrpc_c::paramList const& _paramList,
             RequestAttributes& att) override;
+
+private:
+    VirtualMachineDeploy  deploy;
+
+    VirtualMachineMigrate migrate;
 };
 
 /* ------------------------------------------------------------------------- */
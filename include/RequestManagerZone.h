@@ -104,9 +104,14 @@ public:
 class ZoneReplicateLog : public RequestManagerZone
 {
 public:
+    /**
+     *  Optional parameters (RaftManager::REPLICA_VERSION >= 1): array of the
+     *  records that follow the first one, and format of the SQL commands.
+     *  Version 2 adds the max time (ms) to wait for the previous record
+     */
     ZoneReplicateLog():
         RequestManagerZone("one.zone.replicate", "Replicate a log record",
-                "A:siiiiiiis")
+                "A:siiiiiiis,A:siiiiiiisAi,A:siiiiiiisAii")
     {
         log_method_call = false;
         leader_only     = false;
@@ -114,6 +119,35 @@ public:
 
     ~ZoneReplicateLog(){};
 
+    void request_execute(xmlrpc_c::paramList const& _paramList,
+                         RequestAttributes& att) override;
+
+private:
+    /**
+     *  Success response of the replicate calls, it includes the replication
+     *  protocol version of this server (RaftManager::REPLICA_VERSION)
+     *    @param term of this server
+     *    @param att the specific request attributes
+     */
+    void replica_response(unsigned int term, RequestAttributes& att);
+};
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+class ZoneSnapshot : public RequestManagerZone
+{
+public:
+    ZoneSnapshot():
+        RequestManagerZone("one.zone.snapshot",
+                "Receive a snapshot of the DB state", "A:siiiiiisb")
+    {
+        log_method_call = false;
+        leader_only     = false;
+    };
+
+    ~ZoneSnapshot(){};
+
     void request_execute(xmlrpc_c::paramList const& _paramList,
                          RequestAttributes& att) override;
 };
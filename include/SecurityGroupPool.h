@@ -89,7 +89,7 @@ public:
      */
     int update(SecurityGroup * securitygroup)
     {
-        return securitygroup->update(db);
+        return PoolSQL::update(securitygroup);
     }
 
     /**
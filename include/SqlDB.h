@@ -18,8 +18,30 @@
 #define SQL_DB_H_
 
 #include <sstream>
+#include <string>
+#include <vector>
+
+#include <pthread.h>
+
 #include "Callbackable.h"
 
+/**
+ *  Provides the commands of a transaction in batches, so they do not need to
+ *  be in memory at once. See SqlDB::exec_transaction(SqlCmdReader&)
+ */
+class SqlCmdReader
+{
+public:
+    virtual ~SqlCmdReader(){};
+
+    /**
+     *  Gets the next batch of commands
+     *    @param cmds of the batch, empty if there are no more commands
+     *    @return 0 on success, -1 otherwise
+     */
+    virtual int next(std::vector<std::string>& cmds) = 0;
+};
+
 /**
  * SqlDB class.Provides an abstract interface to implement a SQL backend
  */
@@ -85,6 +107,41 @@ public:
         return exec_ext(cmd, obj, false);
     }
 
+    /**
+     *  Executes a list of SQL commands in a single transaction, without
+     *  replication. If any command fails the transaction is rolled back.
+     *    @param cmds the SQL commands
+     *    @return SqlError enum, of the failed command if any
+     */
+    virtual int exec_transaction(const std::vector<std::string>& cmds) = 0;
+
+    /**
+     *  Executes the SQL commands of a reader in a single transaction, without
+     *  replication. If any command fails the transaction is rolled back.
+     *    @param reader of the commands, they are executed batch by batch
+     *    @return SqlError enum, of the failed command if any
+     */
+    virtual int exec_transaction(SqlCmdReader& reader) = 0;
+
+    /**
+     *  Executes a list of queries on a consistent view of the DB, the one at
+     *  the start of the call. Writes made during the queries are not seen.
+     *    @param cmds the SQL queries
+     *    @param objs callback object of each query
+     *    @param ready mutex unlocked once the view is taken (if not 0), so
+     *    the caller can hold its writers just until then
+     *    @return SqlError enum, of the failed query if any
+     */
+    virtual int exec_rd_transaction(const std::vector<std::string>& cmds,
+            const std::vector<Callbackable *>& objs, pthread_mutex_t * ready) = 0;
+
+    /**
+     *  Gets the names of the tables in the database
+     *    @param tables the table names
+     *    @return 0 on success
+     */
+    virtual int get_tables(std::vector<std::string>& tables) = 0;
+
    /**
      *  This function returns a legal SQL string that can be used in an SQL
      *  statement.
@@ -45,7 +45,7 @@ class SqliteDB : public SqlDB
 {
 public:
 
-    SqliteDB(const string& db_name);
+    SqliteDB(const string& _db_name);
 
     ~SqliteDB();
 
@@ -83,6 +83,39 @@ public:
     {
         return false;
     }
+
+    /**
+     *  Executes the commands in a BEGIN/COMMIT block, the DB is locked during
+     *  the transaction.
+     *    @param cmds the SQL commands
+     *    @return SqlError enum, of the failed command if any
+     */
+    int exec_transaction(const std::vector<std::string>& cmds) override;
+
+    /**
+     *  Executes the commands of the reader in a BEGIN/COMMIT block, the DB is
+     *  locked during the transaction.
+     *    @param reader of the commands
+     *    @return SqlError enum, of the failed command if any
+     */
+    int exec_transaction(SqlCmdReader& reader) override;
+
+    /**
+     *  Executes the queries on a read view of the DB taken in a second
+     *  connection, so writes are not blocked while they run. In WAL mode the
+     *  view is a read transaction, otherwise it is an in memory copy of the
+     *  DB (the DB is locked just for the copy).
+     *    @param cmds the SQL queries
+     *    @param objs callback object of each query
+     *    @param ready mutex unlocked once the view is taken, if not 0
+     *    @return SqlError enum, of the failed query if any
+     */
+    int exec_rd_transaction(const std::vector<std::string>& cmds,
+            const std::vector<Callbackable *>& objs,
+            pthread_mutex_t * ready) override;
+
+    int get_tables(std::vector<std::string>& tables) override;
+
 protected:
     /**
      *  Wraps the sqlite3_exec function call, and locks the DB mutex.
@@ -105,6 +138,16 @@ private:
      */
     sqlite3 *           db;
 
+    /**
+     *  Database file, to open read connections
+     */
+    string              db_name;
+
+    /**
+     *  The database uses WAL journal mode, readers do not block writers
+     */
+    bool                wal;
+
     /**
      *  LIMIT for DELETE and UPDATE queries is enabled
      */
@@ -149,6 +192,28 @@ public:
 
     bool fts_available() override { return false; }
 
+    int exec_transaction(const std::vector<std::string>& cmds) override
+    {
+        return -1;
+    }
+
+    int exec_transaction(SqlCmdReader& reader) override
+    {
+        return -1;
+    }
+
+    int exec_rd_transaction(const std::vector<std::string>& cmds,
+            const std::vector<Callbackable *>& objs,
+            pthread_mutex_t * ready) override
+    {
+        return -1;
+    }
+
+    int get_tables(std::vector<std::string>& tables) override
+    {
+        return -1;
+    }
+
 protected:
     int exec_ext(std::ostringstream& cmd, Callbackable *obj, bool quiet) override
     {
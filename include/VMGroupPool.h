@@ -83,7 +83,7 @@ public:
      */
     int update(VMGroup * vmgroup)
     {
-        return vmgroup->update(db);
+        return PoolSQL::update(vmgroup);
     };
 
     /**
@@ -949,6 +949,16 @@ public:
         user_obj_template->get(name, value);
     }
 
+    /**
+     *  Removes an attribute from the user template
+     *    @param name of the attribute
+     *    @return the number of attributes removed
+     */
+    int remove_user_template_attribute(const string& name)
+    {
+        return user_obj_template->erase(name);
+    }
+
     /**
      *  Sets an error message with timestamp in the template
      *    @param message Message string
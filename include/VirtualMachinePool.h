@@ -93,6 +93,18 @@ public:
         return static_cast<VirtualMachine *>(PoolSQL::get_ro(oid));
     };
 
+    /**
+     *  Function to get a read only VM snapshot shared with other readers, see
+     *  PoolSQL::get_ro_shared
+     *    @param oid VM unique id
+     *    @return the shared VM, empty if the VM could not be loaded
+     */
+    std::shared_ptr<const VirtualMachine> get_ro_shared(int oid)
+    {
+        return std::static_pointer_cast<const VirtualMachine>(
+                PoolSQL::get_ro_shared(oid));
+    };
+
     /**
      *  Function to get a VM from the pool, string version for VM ID
      */
@@ -193,6 +205,8 @@ public:
     int insert_history(
         VirtualMachine * vm)
     {
+        invalidate_cache(vm->get_oid());
+
         return vm->insert_history(db);
     }
 
@@ -204,6 +218,8 @@ public:
     int update_history(
         VirtualMachine * vm)
     {
+        invalidate_cache(vm->get_oid());
+
         return vm->update_history(db);
     }
 
@@ -215,6 +231,8 @@ public:
     int update_previous_history(
         VirtualMachine * vm)
     {
+        invalidate_cache(vm->get_oid());
+
         return vm->update_previous_history(db);
     }
 
@@ -430,6 +448,18 @@ private:
         return new VirtualMachine(-1,-1,-1,"","",0,0);
     };
 
+    /**
+     *  Reads the history records of a set of VMs
+     *    @param oids comma separated list of VM ids
+     *    @param records history bodies of each VM, sorted by sequence
+     *    @return 0 on success
+     */
+    int select_records(const string& oids,
+            std::map<int, std::vector<string> >& records) override
+    {
+        return History::select_records(db, oids, records);
+    };
+
     /**
      * Size, in seconds, of the historical monitoring information
      */
@@ -209,7 +209,7 @@ public:
      *  reservations.
      *    @param auths to be filled
      */
-    void get_permissions(PoolObjectAuth& auths) override;
+    void get_permissions(PoolObjectAuth& auths) const override;
 
     // *************************************************************************
     // Address Range management interface
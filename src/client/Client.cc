@@ -22,6 +22,8 @@
 #include <stdlib.h>
 #include <stdexcept>
 #include <set>
+#include <deque>
+#include <algorithm>
 #include <sstream>
 
 #include <unistd.h>
@@ -29,6 +31,26 @@
 
 Client * Client::_client = 0;
 
+pthread_mutex_t Client::oneauth_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+string Client::oneauth_file;
+
+string Client::oneauth_secret;
+
+struct stat Client::oneauth_stat;
+
+std::map<std::string, Client::Endpoint> Client::pool;
+
+pthread_mutex_t Client::pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+pthread_cond_t Client::pool_cond = PTHREAD_COND_INITIALIZER;
+
+unsigned int Client::pool_size = 4;
+
+unsigned int Client::pool_max_sockets = 8;
+
+time_t Client::pool_idle_timeout = 10;
+
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
@@ -42,7 +64,7 @@ Client::Client(const string& secret, const string& endpoint,
     {
         one_auth = secret;
     }
-    else if (read_oneauth(one_auth, error) != 0 )
+    else if (get_oneauth(one_auth, error) != 0 )
     {
         NebulaLog::log("XMLRPC", Log::ERROR, error);
         throw runtime_error(error);
@@ -69,15 +91,17 @@ Client::Client(const string& secret, const string& endpoint,
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
-int Client::read_oneauth(string &secret, string& error_msg)
+int Client::oneauth_path(string& path, string& error_msg)
 {
-    string   one_auth_file;
-    ifstream file;
     int rc;
 
     const char * one_auth_env = getenv("ONE_AUTH");
 
-    if (!one_auth_env) //No $ONE_AUTH, read $HOME/.one/one_auth
+    if (one_auth_env)
+    {
+        path = one_auth_env;
+    }
+    else //No $ONE_AUTH, read $HOME/.one/one_auth
     {
         struct passwd pw_ent;
         struct passwd * result;
@@ -101,13 +125,27 @@ int Client::read_oneauth(string &secret, string& error_msg)
             return -1;
         }
 
-        one_auth_file = pw_ent.pw_dir;
-        one_auth_file += "/.one/one_auth";
+        path = pw_ent.pw_dir;
+        path += "/.one/one_auth";
+    }
+
+    return 0;
+}
 
-        one_auth_env = one_auth_file.c_str();
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int Client::read_oneauth(string &secret, string& error_msg)
+{
+    string   one_auth_file;
+    ifstream file;
+
+    if ( oneauth_path(one_auth_file, error_msg) != 0 )
+    {
+        return -1;
     }
 
-    file.open(one_auth_env);
+    file.open(one_auth_file.c_str());
 
     if (!file.good())
     {
@@ -133,6 +171,56 @@ int Client::read_oneauth(string &secret, string& error_msg)
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+int Client::get_oneauth(string &secret, string& error_msg)
+{
+    struct stat st;
+
+    pthread_mutex_lock(&oneauth_mutex);
+
+    if ( oneauth_file.empty() && oneauth_path(oneauth_file, error_msg) != 0 )
+    {
+        pthread_mutex_unlock(&oneauth_mutex);
+        return -1;
+    }
+
+    if ( stat(oneauth_file.c_str(), &st) != 0 )
+    {
+        error_msg = "Could not open file " + oneauth_file;
+
+        pthread_mutex_unlock(&oneauth_mutex);
+        return -1;
+    }
+
+    if ( !oneauth_secret.empty() &&
+         st.st_dev == oneauth_stat.st_dev &&
+         st.st_ino == oneauth_stat.st_ino &&
+         st.st_size == oneauth_stat.st_size &&
+         st.st_mtim.tv_sec == oneauth_stat.st_mtim.tv_sec &&
+         st.st_mtim.tv_nsec == oneauth_stat.st_mtim.tv_nsec )
+    {
+        secret = oneauth_secret;
+
+        pthread_mutex_unlock(&oneauth_mutex);
+
+        return 0;
+    }
+
+    int rc = read_oneauth(secret, error_msg);
+
+    if ( rc == 0 )
+    {
+        oneauth_secret = secret;
+        oneauth_stat   = st;
+    }
+
+    pthread_mutex_unlock(&oneauth_mutex);
+
+    return rc;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 void Client::call(const std::string &method, const std::string format,
     xmlrpc_c::value * const result, ...)
 {
@@ -148,6 +236,8 @@ void Client::call(const std::string &method, const std::string format,
     std::set<int> * vval;
     std::set<int>::iterator it;
 
+    std::vector<xmlrpc_c::value> * aval;
+
     const char* pval;
     vector<xmlrpc_c::value> x_vval;
 
@@ -190,6 +280,13 @@ void Client::call(const std::string &method, const std::string format,
                 plist.add(xmlrpc_c::value_array(x_vval));
                 break;
 
+            case 'A':
+                aval = static_cast<std::vector<xmlrpc_c::value> *>(va_arg(args,
+                    std::vector<xmlrpc_c::value> *));
+
+                plist.add(xmlrpc_c::value_array(*aval));
+                break;
+
             default:
                 break;
          }
@@ -226,7 +323,7 @@ void Client::call(const std::string& method, const xmlrpc_c::paramList& plist,
     {
         xmlrpc_c::fault failure = rpc->getFault();
 
-        girerr::error(failure.getDescription());
+        throw ClientFault(failure.getCode(), failure.getDescription());
     }
 };
 
@@ -235,67 +332,557 @@ void Client::call(const std::string& method, const xmlrpc_c::paramList& plist,
 
 int Client::call(const std::string& endpoint, const std::string& method,
         const xmlrpc_c::paramList& plist, unsigned int _timeout,
-        xmlrpc_c::value * const result, std::string& error)
+        xmlrpc_c::value * const result, std::string& error, bool pooled)
 {
 // Transport timeouts are not reliably implemented, interrupt flag and async
 // client performs better.
 //    xmlrpc_c::clientXmlTransport_curl transport(
 //        xmlrpc_c::clientXmlTransport_curl::constrOpt().timeout(_timeout));
-    xmlrpc_c::clientXmlTransport_curl transport;
-
-    xmlrpc_c::carriageParm_curl0  carriage(endpoint);
+    Connection * conn;
 
-    xmlrpc_c::client_xml client(&transport);
-    xmlrpc_c::rpcPtr     rpc_client(method, plist);
+    if ( pooled )
+    {
+        conn = get_connection(endpoint, 1);
+    }
+    else
+    {
+        conn = new Connection;
+    }
 
     int xml_rc   = 0;
     int int_flag = 0;
 
-    try
+    // The rpc has to be destroyed before the connection is returned (and
+    // maybe deleted)
     {
-        rpc_client->start(&client, &carriage);
+        xmlrpc_c::carriageParm_curl0  carriage(endpoint);
 
-        client.setInterrupt(&int_flag);
+        xmlrpc_c::client_xml& client = conn->client;
+        xmlrpc_c::rpcPtr      rpc_client(method, plist);
 
-        if ( _timeout == 0 )
+        try
         {
-            client.finishAsync(xmlrpc_c::timeout());
+            client.setInterrupt(&int_flag);
+
+            rpc_client->start(&client, &carriage);
+
+            if ( _timeout == 0 )
+            {
+                client.finishAsync(xmlrpc_c::timeout());
+            }
+            else
+            {
+                client.finishAsync(_timeout);
+            }
+
+            if ( rpc_client->isFinished() )
+            {
+                if ( rpc_client->isSuccessful() )
+                {
+                    *result = rpc_client->getResult();
+                }
+                else //RPC failed
+                {
+                    xmlrpc_c::fault failure = rpc_client->getFault();
+
+                    error  = failure.getDescription();
+                    xml_rc = -1;
+                }
+            }
+            else //rpc not finished. Interrupt it
+            {
+                int_flag = 1;
+
+                error  = "RPC call timed out and aborted";
+                xml_rc = -1;
+
+                client.finishAsync(xmlrpc_c::timeout());
+            }
         }
-        else
+        catch (exception const& e)
         {
-            client.finishAsync(_timeout);
+            error  = e.what();
+            xml_rc = -1;
         }
+    }
+
+    if ( pooled )
+    {
+        put_connection(endpoint, conn, xml_rc == 0 && int_flag == 0);
+    }
+    else
+    {
+        delete conn;
+    }
+
+    return xml_rc;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+class CallWindow;
+
+/**
+ *  RPC of a call window, the window is notified when it completes
+ */
+class WindowRpc : public xmlrpc_c::rpc
+{
+public:
+    WindowRpc(const std::string& method, const xmlrpc_c::paramList& plist,
+            CallWindow * _cw):xmlrpc_c::rpc(method, plist), cw(_cw){};
+
+    void notifyComplete() override;
+
+private:
+    CallWindow * cw;
+};
+
+/**
+ *  Calls in flight of a sequence, oldest first. New calls are made from the
+ *  completion notifications, while the client processes the replies.
+ */
+class CallWindow
+{
+public:
+    CallWindow(const std::string& _method, const std::string& endpoint,
+            Client::CallSequence& _calls, unsigned int _window,
+            xmlrpc_c::client_xml& _client, int * _int_flag):method(_method),
+        carriage(endpoint), calls(_calls), window(_window), client(_client),
+        int_flag(_int_flag), done(false), stopped(false), busy(false),
+        again(false), rc(0)
+    {};
+
+    /**
+     *  Processes the replies of the finished calls, in order, and makes new
+     *  calls up to the window
+     */
+    void complete();
+
+    /**
+     *  Stops the sequence, the oldest call in flight fails with the error
+     */
+    void abort(const std::string& error);
+
+    /**
+     *  @param timeout (ms) of each call
+     *  @return time (ms) left for the oldest call in flight, 0 if timed out
+     */
+    unsigned int time_left(unsigned int timeout) const;
+
+    bool in_flight() const
+    {
+        return !stopped && !inflight.empty();
+    };
+
+    int get_rc() const
+    {
+        return rc;
+    };
+
+private:
+    std::string method;
+
+    xmlrpc_c::carriageParm_curl0 carriage;
+
+    Client::CallSequence& calls;
+
+    unsigned int window;
+
+    xmlrpc_c::client_xml& client;
+
+    int * int_flag;
+
+    /**
+     *  Calls in flight and the time they were made
+     */
+    std::deque<std::pair<xmlrpc_c::rpcPtr, struct timespec> > inflight;
+
+    bool done;
+
+    bool stopped;
+
+    /**
+     *  A call may complete while another one is being made, the replies
+     *  are then processed by the outer complete() call
+     */
+    bool busy;
+
+    bool again;
 
-        if ( rpc_client->isFinished() )
+    int rc;
+};
+
+/* -------------------------------------------------------------------------- */
+
+void WindowRpc::notifyComplete()
+{
+    cw->complete();
+}
+
+/* -------------------------------------------------------------------------- */
+
+void CallWindow::complete()
+{
+    if ( busy )
+    {
+        again = true;
+        return;
+    }
+
+    busy = true;
+
+    do
+    {
+        again = false;
+
+        while ( !stopped && !inflight.empty() &&
+                inflight.front().first->isFinished() )
         {
-            if ( rpc_client->isSuccessful() )
+            xmlrpc_c::rpcPtr rpc = inflight.front().first;
+
+            xmlrpc_c::value result;
+            std::string     error;
+
+            int call_rc = 0;
+
+            inflight.pop_front();
+
+            if ( rpc->isSuccessful() )
             {
-                *result = rpc_client->getResult();
+                result = rpc->getResult();
             }
-            else //RPC failed
+            else
             {
-                xmlrpc_c::fault failure = rpc_client->getFault();
+                xmlrpc_c::fault failure = rpc->getFault();
 
-                error  = failure.getDescription();
-                xml_rc = -1;
+                error   = failure.getDescription();
+                call_rc = -1;
+                rc      = -1;
+            }
+
+            if ( !calls.reply(call_rc, result, error) )
+            {
+                stopped = true;
+
+                if ( !inflight.empty() )
+                {
+                    *int_flag = 1; //Interrupt the calls in flight
+                }
             }
         }
-        else //rpc not finished. Interrupt it
+
+        while ( !stopped && !done && inflight.size() < window )
+        {
+            xmlrpc_c::paramList plist;
+
+            if ( !calls.next_call(plist) )
+            {
+                done = true;
+                break;
+            }
+
+            struct timespec now;
+
+            clock_gettime(CLOCK_MONOTONIC, &now);
+
+            xmlrpc_c::rpcPtr rpc(new WindowRpc(method, plist, this));
+
+            inflight.push_back(std::make_pair(rpc, now));
+
+            rpc->start(&client, &carriage);
+        }
+    } while ( again && !stopped );
+
+    busy = false;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void CallWindow::abort(const std::string& error)
+{
+    if ( stopped )
+    {
+        return;
+    }
+
+    stopped = true;
+
+    rc = -1;
+
+    if ( !inflight.empty() )
+    {
+        calls.reply(-1, xmlrpc_c::value(), error);
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+unsigned int CallWindow::time_left(unsigned int timeout) const
+{
+    struct timespec now;
+
+    if ( inflight.empty() )
+    {
+        return timeout;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    const struct timespec& started = inflight.front().second;
+
+    long long elapsed = (now.tv_sec - started.tv_sec) * 1000LL +
+        (now.tv_nsec - started.tv_nsec) / 1000000;
+
+    if ( elapsed >= timeout )
+    {
+        return 0;
+    }
+
+    return timeout - elapsed;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int Client::call(const std::string& endpoint, const std::string& method,
+        CallSequence& calls, unsigned int window, unsigned int _timeout,
+        bool pooled)
+{
+    Connection * conn;
+
+    // A pooled connection cannot have more calls in flight than the sockets
+    // allowed for the server
+    if ( pooled && window > pool_max_sockets )
+    {
+        window = pool_max_sockets;
+    }
+
+    if ( window == 0 )
+    {
+        window = 1;
+    }
+
+    if ( pooled )
+    {
+        conn = get_connection(endpoint, window);
+    }
+    else
+    {
+        conn = new Connection;
+
+        conn->sockets = window;
+    }
+
+    int xml_rc   = 0;
+    int int_flag = 0;
+
+    // The rpcs have to be destroyed before the connection is returned (and
+    // maybe deleted)
+    {
+        xmlrpc_c::client_xml& client = conn->client;
+
+        CallWindow cw(method, endpoint, calls, window, client, &int_flag);
+
+        try
+        {
+            client.setInterrupt(&int_flag);
+
+            cw.complete();
+
+            while ( cw.in_flight() )
+            {
+                if ( _timeout == 0 )
+                {
+                    client.finishAsync(xmlrpc_c::timeout());
+                    continue;
+                }
+
+                unsigned int left = cw.time_left(_timeout);
+
+                if ( left == 0 ) //oldest rpc not finished. Interrupt them
+                {
+                    int_flag = 1;
+
+                    cw.abort("RPC call timed out and aborted");
+
+                    break;
+                }
+
+                client.finishAsync(left);
+            }
+
+            if ( int_flag == 1 )
+            {
+                client.finishAsync(xmlrpc_c::timeout());
+            }
+        }
+        catch (exception const& e)
         {
             int_flag = 1;
 
-            error  = "RPC call timed out and aborted";
-            xml_rc = -1;
+            cw.abort(e.what());
 
-            client.finishAsync(xmlrpc_c::timeout());
+            try
+            {
+                client.finishAsync(xmlrpc_c::timeout());
+            }
+            catch (exception const& ex) {}
         }
+
+        xml_rc = cw.get_rc();
     }
-    catch (exception const& e)
+
+    if ( pooled )
     {
-		error  = e.what();
-        xml_rc = -1;
+        put_connection(endpoint, conn, xml_rc == 0 && int_flag == 0);
+    }
+    else
+    {
+        delete conn;
     }
 
     return xml_rc;
 }
 
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void Client::set_pool(unsigned int size, unsigned int max_sockets,
+        time_t idle_timeout)
+{
+    pthread_mutex_lock(&pool_mutex);
+
+    pool_size         = size;
+    pool_max_sockets  = max_sockets > 0 ? max_sockets : 1;
+    pool_idle_timeout = idle_timeout;
+
+    pthread_mutex_unlock(&pool_mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+Client::Connection * Client::get_connection(const std::string& endpoint,
+        unsigned int calls)
+{
+    Connection * conn = 0;
+
+    std::vector<Connection *> expired;
+    std::vector<Connection *>::iterator it;
+
+    time_t the_time = time(0);
+
+    pthread_mutex_lock(&pool_mutex);
+
+    Endpoint& ep = pool[endpoint];
+
+    // Callers do not put more calls than the limit on a connection, see the
+    // window version of call()
+    unsigned int sockets = std::min(calls, pool_max_sockets);
+
+    while ( true )
+    {
+        while ( !ep.idle.empty() && conn == 0 )
+        {
+            Connection * c = ep.idle.back();
+
+            ep.idle.pop_back();
+
+            if ( the_time - c->last_used < pool_idle_timeout )
+            {
+                conn = c;
+            }
+            else
+            {
+                ep.sockets -= c->sockets;
+
+                expired.push_back(c);
+            }
+        }
+
+        if ( conn != 0 )
+        {
+            if ( sockets <= conn->sockets )
+            {
+                break;
+            }
+            else if ( ep.sockets + sockets - conn->sockets <= pool_max_sockets )
+            {
+                ep.sockets += sockets - conn->sockets;
+
+                conn->sockets = sockets;
+
+                break;
+            }
+
+            // Close it to make room for a connection with more sockets
+            ep.sockets -= conn->sockets;
+
+            expired.push_back(conn);
+
+            conn = 0;
+        }
+        else if ( ep.sockets + sockets <= pool_max_sockets )
+        {
+            ep.sockets += sockets;
+
+            break;
+        }
+        else if ( ep.idle.empty() )
+        {
+            pthread_cond_wait(&pool_cond, &pool_mutex);
+
+            the_time = time(0);
+        }
+    }
+
+    pthread_mutex_unlock(&pool_mutex);
+
+    // Close expired connections out of the lock
+    for ( it = expired.begin() ; it != expired.end() ; ++it )
+    {
+        delete *it;
+    }
+
+    if ( conn == 0 )
+    {
+        conn = new Connection;
+
+        conn->sockets = sockets;
+    }
+
+    return conn;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void Client::put_connection(const std::string& endpoint, Connection * conn,
+        bool healthy)
+{
+    conn->client.setInterrupt(0);
+
+    conn->last_used = time(0);
+
+    pthread_mutex_lock(&pool_mutex);
+
+    Endpoint& ep = pool[endpoint];
+
+    if ( healthy && ep.idle.size() < pool_size )
+    {
+        ep.idle.push_back(conn);
+        conn = 0;
+    }
+    else
+    {
+        ep.sockets -= conn->sockets;
+    }
+
+    pthread_cond_broadcast(&pool_cond);
+
+    pthread_mutex_unlock(&pool_mutex);
+
+    delete conn;
+}
+
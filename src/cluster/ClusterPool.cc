@@ -144,8 +144,6 @@ int ClusterPool::drop(PoolObjectSQL * objsql, string& error_msg)
 {
     Cluster * cluster = static_cast<Cluster*>(objsql);
 
-    int rc;
-
     // Return error if the cluster is a default one.
     if( cluster->get_oid() < 100 )
     {
@@ -161,15 +159,7 @@ int ClusterPool::drop(PoolObjectSQL * objsql, string& error_msg)
         return -3;
     }
 
-    rc = cluster->drop(db);
-
-    if( rc != 0 )
-    {
-        error_msg = "SQL DB error";
-        rc = -1;
-    }
-
-    return rc;
+    return PoolSQL::drop(objsql, error_msg);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -256,8 +256,6 @@ int DatastorePool::drop(PoolObjectSQL * objsql, string& error_msg)
 {
     Datastore * datastore = static_cast<Datastore*>(objsql);
 
-    int rc;
-
     if( datastore->images_size() > 0 )
     {
         ostringstream oss;
@@ -268,15 +266,7 @@ int DatastorePool::drop(PoolObjectSQL * objsql, string& error_msg)
         return -3;
     }
 
-    rc = datastore->drop(db);
-
-    if( rc != 0 )
-    {
-        error_msg = "SQL DB error";
-        rc = -1;
-    }
-
-    return rc;
+    return PoolSQL::drop(objsql, error_msg);
 }
 
 /* -------------------------------------------------------------------------- */
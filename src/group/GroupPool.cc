@@ -38,7 +38,7 @@ const int    GroupPool::USERS_ID      = 1;
 /* -------------------------------------------------------------------------- */
 
 GroupPool::GroupPool(SqlDB * db, bool is_slave,
-        vector<const SingleAttribute *>& restricted_attrs):PoolSQL(db, Group::table)
+        vector<const SingleAttribute *>& restricted_attrs):PoolSQL(db, Group::table, !is_slave)
 {
     ostringstream oss;
     string        error_str;
@@ -165,7 +165,11 @@ int GroupPool::update(PoolObjectSQL * objsql)
 
 int GroupPool::update_quotas(Group * group)
 {
-    return group->update_quotas(db);
+    int rc = group->update_quotas(db);
+
+    record_change(group->get_oid());
+
+    return rc;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -175,8 +179,6 @@ int GroupPool::drop(PoolObjectSQL * objsql, string& error_msg)
 {
     Group * group = static_cast<Group*>(objsql);
 
-    int rc;
-
     if (Nebula::instance().is_federation_slave())
     {
         NebulaLog::log("ONE",Log::ERROR,
@@ -204,15 +206,7 @@ int GroupPool::drop(PoolObjectSQL * objsql, string& error_msg)
         return -3;
     }
 
-    rc = group->drop(db);
-
-    if( rc != 0 )
-    {
-        error_msg = "SQL DB error";
-        rc = -1;
-    }
-
-    return rc;
+    return PoolSQL::drop(objsql, error_msg);
 }
 
 /* -------------------------------------------------------------------------- */
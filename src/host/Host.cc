@@ -665,7 +665,7 @@ string& Host::to_xml(string& xml) const
 
 int Host::from_xml(const string& xml)
 {
-    vector<xmlNodePtr> content;
+    xmlNodePtr node;
 
     int int_state;
     int int_prev_state;
@@ -674,19 +674,22 @@ int Host::from_xml(const string& xml)
     // Initialize the internal XML object
     update_from_str(xml);
 
+    // Index the Host elements, fields are read in a single pass
+    ObjectXML::ChildIndex host_xml(*this);
+
     // Get class base attributes
-    rc += xpath(oid, "/HOST/ID", -1);
-    rc += xpath(name, "/HOST/NAME", "not_found");
-    rc += xpath(int_state, "/HOST/STATE", 0);
-    rc += xpath(int_prev_state, "/HOST/PREV_STATE", 0);
+    rc += host_xml.get(oid, "ID", -1);
+    rc += host_xml.get(name, "NAME", "not_found");
+    rc += host_xml.get(int_state, "STATE", 0);
+    rc += host_xml.get(int_prev_state, "PREV_STATE", 0);
 
-    rc += xpath(im_mad_name, "/HOST/IM_MAD", "not_found");
-    rc += xpath(vmm_mad_name, "/HOST/VM_MAD", "not_found");
+    rc += host_xml.get(im_mad_name, "IM_MAD", "not_found");
+    rc += host_xml.get(vmm_mad_name, "VM_MAD", "not_found");
 
-    rc += xpath<time_t>(last_monitored, "/HOST/LAST_MON_TIME", 0);
+    rc += host_xml.get<time_t>(last_monitored, "LAST_MON_TIME", 0);
 
-    rc += xpath(cluster_id, "/HOST/CLUSTER_ID", -1);
-    rc += xpath(cluster,    "/HOST/CLUSTER",    "not_found");
+    rc += host_xml.get(cluster_id, "CLUSTER_ID", -1);
+    rc += host_xml.get(cluster,    "CLUSTER",    "not_found");
 
     state = static_cast<HostState>( int_state );
     prev_state = static_cast<HostState>( int_prev_state );
@@ -697,33 +700,25 @@ int Host::from_xml(const string& xml)
 
     // ------------ Host Share ---------------
 
-    ObjectXML::get_nodes("/HOST/HOST_SHARE", content);
+    node = host_xml.node("HOST_SHARE");
 
-    if (content.empty())
+    if (node == 0)
     {
         return -1;
     }
 
-    rc += host_share.from_xml_node(content[0]);
-
-    ObjectXML::free_nodes(content);
-
-    content.clear();
+    rc += host_share.from_xml_node(node);
 
     // ------------ Host Template ---------------
 
-    ObjectXML::get_nodes("/HOST/TEMPLATE", content);
+    node = host_xml.node("TEMPLATE");
 
-    if (content.empty())
+    if (node == 0)
     {
         return -1;
     }
 
-    rc += obj_template->from_xml_node(content[0]);
-
-    ObjectXML::free_nodes(content);
-
-    content.clear();
+    rc += obj_template->from_xml_node(node);
 
     // ------------ VMS collection ---------------
     rc += vm_collection.from_xml(this, "/HOST/");
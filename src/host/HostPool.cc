@@ -164,7 +164,7 @@ int HostPool::update(PoolObjectSQL * objsql)
 
     host->set_prev_state();
 
-    return host->update(db);
+    return PoolSQL::update(host);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -1796,46 +1796,47 @@ int HostShare::from_xml_node(const xmlNodePtr node)
     vector<xmlNodePtr> content;
     int rc = 0;
 
+    xmlNodePtr share_node;
+
     // Initialize the internal XML object
     ObjectXML::update_from_node(node);
 
-    rc += xpath<long long>(disk_usage, "/HOST_SHARE/DISK_USAGE", -1);
-    rc += xpath<long long>(mem_usage,  "/HOST_SHARE/MEM_USAGE",  -1);
-    rc += xpath<long long>(cpu_usage,  "/HOST_SHARE/CPU_USAGE",  -1);
+    // Index the HOST_SHARE elements, fields are read in a single pass
+    ObjectXML::ChildIndex share_xml(*this);
+
+    rc += share_xml.get<long long>(disk_usage, "DISK_USAGE", -1);
+    rc += share_xml.get<long long>(mem_usage,  "MEM_USAGE",  -1);
+    rc += share_xml.get<long long>(cpu_usage,  "CPU_USAGE",  -1);
 
-    rc += xpath<long long>(total_mem ,  "/HOST_SHARE/TOTAL_MEM", -1);
-    rc += xpath<long long>(total_cpu,   "/HOST_SHARE/TOTAL_CPU", -1);
+    rc += share_xml.get<long long>(total_mem ,  "TOTAL_MEM", -1);
+    rc += share_xml.get<long long>(total_cpu,   "TOTAL_CPU", -1);
 
-    rc += xpath<long long>(max_disk,   "/HOST_SHARE/MAX_DISK",   -1);
-    rc += xpath<long long>(max_mem ,   "/HOST_SHARE/MAX_MEM",    -1);
-    rc += xpath<long long>(max_cpu ,   "/HOST_SHARE/MAX_CPU",    -1);
+    rc += share_xml.get<long long>(max_disk,   "MAX_DISK",   -1);
+    rc += share_xml.get<long long>(max_mem ,   "MAX_MEM",    -1);
+    rc += share_xml.get<long long>(max_cpu ,   "MAX_CPU",    -1);
 
-    rc += xpath<long long>(free_disk,  "/HOST_SHARE/FREE_DISK",  -1);
-    rc += xpath<long long>(free_mem ,  "/HOST_SHARE/FREE_MEM",   -1);
-    rc += xpath<long long>(free_cpu ,  "/HOST_SHARE/FREE_CPU",   -1);
+    rc += share_xml.get<long long>(free_disk,  "FREE_DISK",  -1);
+    rc += share_xml.get<long long>(free_mem ,  "FREE_MEM",   -1);
+    rc += share_xml.get<long long>(free_cpu ,  "FREE_CPU",   -1);
 
-    rc += xpath<long long>(used_disk,  "/HOST_SHARE/USED_DISK",  -1);
-    rc += xpath<long long>(used_mem ,  "/HOST_SHARE/USED_MEM",   -1);
-    rc += xpath<long long>(used_cpu ,  "/HOST_SHARE/USED_CPU",   -1);
+    rc += share_xml.get<long long>(used_disk,  "USED_DISK",  -1);
+    rc += share_xml.get<long long>(used_mem ,  "USED_MEM",   -1);
+    rc += share_xml.get<long long>(used_cpu ,  "USED_CPU",   -1);
 
-    rc += xpath<long long>(running_vms,"/HOST_SHARE/RUNNING_VMS",-1);
+    rc += share_xml.get<long long>(running_vms,"RUNNING_VMS",-1);
 
-    xpath<unsigned int>(vms_thread, "/HOST_SHARE/VMS_THREAD", 1);
+    share_xml.get<unsigned int>(vms_thread, "VMS_THREAD", 1);
 
     // ------------ Datastores ---------------
 
-    ObjectXML::get_nodes("/HOST_SHARE/DATASTORES", content);
+    share_node = share_xml.node("DATASTORES");
 
-    if( content.empty())
+    if( share_node == 0 )
     {
         return -1;
     }
 
-    rc += ds.from_xml_node( content[0] );
-
-    ObjectXML::free_nodes(content);
-
-    content.clear();
+    rc += ds.from_xml_node( share_node );
 
     if (rc != 0)
     {
@@ -1844,18 +1845,14 @@ int HostShare::from_xml_node(const xmlNodePtr node)
 
     // ------------ PCI Devices ---------------
 
-    ObjectXML::get_nodes("/HOST_SHARE/PCI_DEVICES", content);
+    share_node = share_xml.node("PCI_DEVICES");
 
-    if( content.empty())
+    if( share_node == 0 )
     {
         return -1;
     }
 
-    rc += pci.from_xml_node( content[0] );
-
-    ObjectXML::free_nodes(content);
-
-    content.clear();
+    rc += pci.from_xml_node( share_node );
 
     if (rc != 0)
     {
@@ -1864,14 +1861,14 @@ int HostShare::from_xml_node(const xmlNodePtr node)
 
     // ------------ NUMA Nodes ---------------
 
-    ObjectXML::get_nodes("/HOST_SHARE/NUMA_NODES/NODE", content);
+    ObjectXML::ChildIndex numa_xml(share_xml.node("NUMA_NODES"));
+
+    numa_xml.nodes("NODE", content);
 
     if(!content.empty())
     {
         rc += numa.from_xml_node(content, vms_thread);
 
-        ObjectXML::free_nodes(content);
-
         content.clear();
 
         if (rc != 0)
@@ -202,6 +202,10 @@ void InformationManager::timer_action(const ActionRequest& ar)
         return;
     }
 
+    // Read the hosts in batches, each host is then locked from the pool cache
+    hpool->prefetch(vector<int>(discovered_hosts.begin(),
+                discovered_hosts.end()));
+
     for( it=discovered_hosts.begin() ; it!=discovered_hosts.end() ; ++it )
     {
         host = hpool->get(*it);
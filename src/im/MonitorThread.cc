@@ -127,7 +127,7 @@ void MonitorThread::do_message()
     map<int, const VectorAttribute*>::iterator itm;
 
     Template    tmpl;
-    Datastore * ds;
+    std::shared_ptr<const Datastore> ds;
 
     set<int>    non_shared_ds;
 
@@ -148,9 +148,9 @@ void MonitorThread::do_message()
 
     for (itm = datastores.begin(); itm != datastores.end(); itm++)
     {
-        ds = dspool->get_ro(itm->first);
+        ds = dspool->get_ro_shared(itm->first);
 
-        if (ds == 0)
+        if (!ds)
         {
             continue;
         }
@@ -159,8 +159,6 @@ void MonitorThread::do_message()
         {
             non_shared_ds.insert(itm->first);
         }
-
-        ds->unlock();
     }
 
     // -------------------------------------------------------------------------
@@ -211,17 +209,18 @@ void MonitorThread::do_message()
     //--------------------------------------------------------------------------
     if (vm_poll)
     {
-        set<int>::iterator         its;
         map<int,string>::iterator  itm;
 
-        for (its = lost.begin(); its != lost.end(); its++)
-        {
-            VirtualMachine * vm = vmpool->get_ro(*its);
+        vector<PoolObjectSQL *>           lost_vms;
+        vector<PoolObjectSQL *>::iterator itl;
 
-            if (vm == 0)
-            {
-                continue;
-            }
+        vector<int> found_ids;
+
+        vmpool->get_ro_many(vector<int>(lost.begin(), lost.end()), lost_vms);
+
+        for (itl = lost_vms.begin(); itl != lost_vms.end(); itl++)
+        {
+            VirtualMachine * vm = static_cast<VirtualMachine *>(*itl);
 
             // Move the VM to power off if it is not reported by the Host and:
             // 1.- It has a history record
@@ -234,7 +233,7 @@ void MonitorThread::do_message()
                    vm->get_lcm_state() == VirtualMachine::SHUTDOWN_POWEROFF ||
                    vm->get_lcm_state() == VirtualMachine::SHUTDOWN_UNDEPLOY))
             {
-                lcm->trigger(LCMAction::MONITOR_POWEROFF, *its);
+                lcm->trigger(LCMAction::MONITOR_POWEROFF, vm->get_oid());
             }
             // If the guest is shut down before the poll reports it at least
             // once, the VM gets stuck in running. An individual poll action
@@ -250,6 +249,14 @@ void MonitorThread::do_message()
             vm->unlock();
         }
 
+        // Read the found VMs in batches, each VM is then locked from the cache
+        for (itm = found.begin(); itm != found.end(); itm++)
+        {
+            found_ids.push_back(itm->first);
+        }
+
+        vmpool->prefetch(found_ids);
+
         for (itm = found.begin(); itm != found.end(); itm++)
         {
             VirtualMachine * vm = vmpool->get(itm->first);
@@ -22,7 +22,7 @@
 /* -------------------------------------------------------------------------- */
 
 MarketPlacePool::MarketPlacePool(SqlDB * db, bool is_federation_slave)
-    :PoolSQL(db, MarketPlace::table)
+    :PoolSQL(db, MarketPlace::table, !is_federation_slave)
 {
     //Federation slaves do not need to init the pool
     if (is_federation_slave)
@@ -333,6 +333,10 @@ void Nebula::start(bool bootstrap_only)
     unsigned int log_retention;
     unsigned int limit_purge;
 
+    unsigned int batch_records;
+    unsigned int batch_size;
+    unsigned int replica_window;
+
     vatt->vector_value("LOG_PURGE_TIMEOUT", log_purge);
     vatt->vector_value("ELECTION_TIMEOUT_MS", election_ms);
     vatt->vector_value("BROADCAST_TIMEOUT_MS", bcast_ms);
@@ -340,6 +344,50 @@ void Nebula::start(bool bootstrap_only)
     vatt->vector_value("LOG_RETENTION", log_retention);
     vatt->vector_value("LIMIT_PURGE", limit_purge);
 
+    if ( vatt->vector_value("BATCH_RECORDS", batch_records) != 0 )
+    {
+        batch_records = 100;
+    }
+
+    if ( vatt->vector_value("BATCH_SIZE", batch_size) != 0 )
+    {
+        batch_size = 1048576;
+    }
+
+    if ( vatt->vector_value("REPLICA_WINDOW", replica_window) != 0 ||
+            replica_window == 0 )
+    {
+        replica_window = 1;
+    }
+
+    unsigned int pool_size;
+    unsigned int pool_max;
+    time_t       pool_timeout;
+
+    if ( vatt->vector_value("CONN_POOL_SIZE", pool_size) != 0 )
+    {
+        pool_size = 4;
+    }
+
+    if ( vatt->vector_value("CONN_POOL_MAX", pool_max) != 0 )
+    {
+        pool_max = 8;
+    }
+
+    if ( vatt->vector_value("CONN_POOL_TIMEOUT", pool_timeout) != 0 )
+    {
+        pool_timeout = 10;
+    }
+
+    // Replica calls in flight to a follower share a pooled connection
+    if ( replica_window > 1 && replica_window > pool_max )
+    {
+        throw runtime_error("RAFT REPLICA_WINDOW cannot be greater than "
+            "CONN_POOL_MAX.");
+    }
+
+    Client::set_pool(pool_size, pool_max, pool_timeout);
+
     Log::set_zone_id(zone_id);
 
     // -----------------------------------------------------------
@@ -766,7 +814,7 @@ void Nebula::start(bool bootstrap_only)
         secgrouppool = new SecurityGroupPool(logdb);
 
         marketpool = new MarketPlacePool(db_ptr, is_federation_slave());
-        apppool    = new MarketPlaceAppPool(db_ptr);
+        apppool    = new MarketPlaceAppPool(db_ptr, is_federation_slave());
 
         vmgrouppool = new VMGroupPool(logdb);
 
@@ -836,7 +884,8 @@ void Nebula::start(bool bootstrap_only)
     try
     {
         raftm = new RaftManager(server_id, raft_leader_hook, raft_follower_hook,
-                log_purge, bcast_ms, election_ms, xmlrpc_ms, remotes_location);
+                log_purge, bcast_ms, election_ms, xmlrpc_ms, batch_records,
+                batch_size, replica_window, remotes_location);
     }
     catch (bad_alloc&)
     {
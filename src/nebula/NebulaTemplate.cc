@@ -500,6 +500,12 @@ void OpenNebulaTemplate::set_conf_default()
 #   BROADCAST_TIMEOUT_MS
 #   XMLRPC_TIMEOUT_MS
 #   LIMIT_PURGE
+#   BATCH_RECORDS
+#   BATCH_SIZE
+#   REPLICA_WINDOW
+#   CONN_POOL_SIZE
+#   CONN_POOL_MAX
+#   CONN_POOL_TIMEOUT
 #*******************************************************************************
 */
     // FEDERATION
@@ -520,6 +526,12 @@ void OpenNebulaTemplate::set_conf_default()
     vvalue.insert(make_pair("BROADCAST_TIMEOUT_MS","500"));
     vvalue.insert(make_pair("XMLRPC_TIMEOUT_MS","100"));
     vvalue.insert(make_pair("LIMIT_PURGE","100000"));
+    vvalue.insert(make_pair("BATCH_RECORDS","100"));
+    vvalue.insert(make_pair("BATCH_SIZE","1048576"));
+    vvalue.insert(make_pair("REPLICA_WINDOW","1"));
+    vvalue.insert(make_pair("CONN_POOL_SIZE","4"));
+    vvalue.insert(make_pair("CONN_POOL_MAX","8"));
+    vvalue.insert(make_pair("CONN_POOL_TIMEOUT","10"));
 
     vattribute = new VectorAttribute("RAFT",vvalue);
     conf_default.insert(make_pair(vattribute->name(),vattribute));
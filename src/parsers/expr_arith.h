@@ -1,8 +1,8 @@
-/* A Bison parser, made by GNU Bison 3.4.1.  */
+/* A Bison parser, made by GNU Bison 3.8.2.  */
 
 /* Bison interface for Yacc-like parsers in C
 
-   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2019 Free Software Foundation,
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
    Inc.
 
    This program is free software: you can redistribute it and/or modify
@@ -16,7 +16,7 @@
    GNU General Public License for more details.
 
    You should have received a copy of the GNU General Public License
-   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
 
 /* As a special exception, you may create a larger work that contains
    part or all of the Bison parser skeleton and distribute that work
@@ -31,11 +31,12 @@
    This special exception was added by the Free Software Foundation in
    version 2.2 of Bison.  */
 
-/* Undocumented macros, especially those whose name start with YY_,
-   are private implementation details.  Do not rely on them.  */
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
 
-#ifndef YY_EXPR_ARITH_EXPR_ARITH_HH_INCLUDED
-# define YY_EXPR_ARITH_EXPR_ARITH_HH_INCLUDED
+#ifndef YY_EXPR_ARITH_EXPR_ARITH_H_INCLUDED
+# define YY_EXPR_ARITH_EXPR_ARITH_H_INCLUDED
 /* Debug traces.  */
 #ifndef YYDEBUG
 # define YYDEBUG 0
@@ -44,7 +45,7 @@
 extern int expr_arith_debug;
 #endif
 /* "%code requires" blocks.  */
-#line 47 "expr_arith.y"
+#line 50 "expr_arith.y"
 
 #include <iostream>
 #include <sstream>
@@ -58,37 +59,43 @@ extern int expr_arith_debug;
 #include <fnmatch.h>
 
 #include "mem_collector.h"
-#include "ObjectXML.h"
+#include "Expression.h"
 
 typedef void * yyscan_t;
 
-int expr_arith_parse(ObjectXML *oxml, int& result, char ** errmsg,
+int expr_arith_parse(ArithExpression ** result, char ** errmsg,
     yyscan_t scanner);
 
-#line 69 "expr_arith.hh"
+#line 70 "expr_arith.h"
 
-/* Token type.  */
+/* Token kinds.  */
 #ifndef YYTOKENTYPE
 # define YYTOKENTYPE
   enum yytokentype
   {
-    INTEGER = 258,
-    STRING = 259,
-    FLOAT = 260
+    YYEMPTY = -2,
+    YYEOF = 0,                     /* "end of file"  */
+    YYerror = 256,                 /* error  */
+    YYUNDEF = 257,                 /* "invalid token"  */
+    INTEGER = 258,                 /* INTEGER  */
+    STRING = 259,                  /* STRING  */
+    FLOAT = 260                    /* FLOAT  */
   };
+  typedef enum yytokentype yytoken_kind_t;
 #endif
 
 /* Value type.  */
 #if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
 union YYSTYPE
 {
-#line 77 "expr_arith.y"
+#line 79 "expr_arith.y"
 
-    char *  val_str;
-    int     val_int;
-    float   val_float;
+    char *            val_str;
+    int               val_int;
+    float             val_float;
+    ArithExpression * val_expr;
 
-#line 92 "expr_arith.hh"
+#line 99 "expr_arith.h"
 
 };
 typedef union YYSTYPE YYSTYPE;
@@ -112,6 +119,8 @@ struct YYLTYPE
 
 
 
-int expr_arith_parse (mem_collector * mc, ObjectXML * oxml, int& result, char ** error_msg, yyscan_t scanner);
 
-#endif /* !YY_EXPR_ARITH_EXPR_ARITH_HH_INCLUDED  */
+int expr_arith_parse (mem_collector * mc, ArithExpression ** result, char ** error_msg, yyscan_t scanner);
+
+
+#endif /* !YY_EXPR_ARITH_EXPR_ARITH_H_INCLUDED  */
@@ -22,13 +22,14 @@
 #define expr_arith_lex expr_lex
 
 
-void expr_arith_error(YYLTYPE * llocp, mem_collector * mc, ObjectXML * oxml,
-        int& result, char ** error_msg, yyscan_t scanner, const char * str);
+void expr_arith_error(YYLTYPE * llocp, mem_collector * mc,
+        ArithExpression ** result, char ** error_msg, yyscan_t scanner,
+        const char * str);
 
 int expr_arith_lex(YYSTYPE *lvalp, YYLTYPE *llocp, mem_collector * mc,
     yyscan_t scanner);
 
-int expr_arith_parse(ObjectXML *oxml, int& result, char ** errmsg,
+int expr_arith_parse(ArithExpression ** result, char ** errmsg,
     yyscan_t scanner)
 {
     mem_collector mc;
@@ -36,7 +37,9 @@ int expr_arith_parse(ObjectXML *oxml, int& result, char ** errmsg,
 
     mem_collector_init(&mc);
 
-    rc = expr_arith_parse(&mc, oxml, result, errmsg, scanner);
+    *result = 0;
+
+    rc = expr_arith_parse(&mc, result, errmsg, scanner);
 
     mem_collector_cleanup(&mc);
 
@@ -57,17 +60,16 @@ int expr_arith_parse(ObjectXML *oxml, int& result, char ** errmsg,
 #include <fnmatch.h>
 
 #include "mem_collector.h"
-#include "ObjectXML.h"
+#include "Expression.h"
 
 typedef void * yyscan_t;
 
-int expr_arith_parse(ObjectXML *oxml, int& result, char ** errmsg,
+int expr_arith_parse(ArithExpression ** result, char ** errmsg,
     yyscan_t scanner);
 }
 
 %parse-param {mem_collector * mc}
-%parse-param {ObjectXML * oxml}
-%parse-param {int& result}
+%parse-param {ArithExpression ** result}
 %parse-param {char ** error_msg}
 %parse-param {yyscan_t scanner}
 
@@ -75,14 +77,16 @@ int expr_arith_parse(ObjectXML *oxml, int& result, char ** errmsg,
 %lex-param {yyscan_t scanner}
 
 %union {
-    char *  val_str;
-    int     val_int;
-    float   val_float;
+    char *            val_str;
+    int               val_int;
+    float             val_float;
+    ArithExpression * val_expr;
 };
 
 %defines
 %locations
 %pure-parser
+%define parse.error verbose
 %name-prefix "expr_arith_"
 %output      "expr_arith.cc"
 
@@ -91,36 +95,36 @@ int expr_arith_parse(ObjectXML *oxml, int& result, char ** errmsg,
 %token <val_int>    INTEGER
 %token <val_str>    STRING
 %token <val_float>  FLOAT
-%type  <val_int>    stmt
-%type  <val_float>  expr
+%type  <val_expr>   expr
+
+%destructor { delete $$; } <val_expr>
 
 %%
 
-stmt:   expr                { result = static_cast<int>($1);}
-        |                   { result = 0; }
+stmt:   expr                { *result = $1; }
+        |                   { *result = new ArithConstant(0); }
         ;
 
-expr:   STRING              { float val; oxml->search($1, val); $$ = val; }
-        | FLOAT             { $$ = $1; }
-        | INTEGER           { $$ = static_cast<float>($1); }
-        | expr '+' expr     { $$ = $1 + $3;}
-        | expr '-' expr     { $$ = $1 - $3;}
-        | expr '*' expr     { $$ = $1 * $3;}
-        | expr '/' expr     { $$ = $1 / $3;}
-        | '-' expr          { $$ = - $2;}
+expr:   STRING              { $$ = new ArithVariable($1); }
+        | FLOAT             { $$ = new ArithConstant($1); }
+        | INTEGER           { $$ = new ArithConstant(static_cast<float>($1)); }
+        | expr '+' expr     { $$ = new ArithOperation(ArithOperation::ADD, $1, $3);}
+        | expr '-' expr     { $$ = new ArithOperation(ArithOperation::SUB, $1, $3);}
+        | expr '*' expr     { $$ = new ArithOperation(ArithOperation::MUL, $1, $3);}
+        | expr '/' expr     { $$ = new ArithOperation(ArithOperation::DIV, $1, $3);}
+        | '-' expr          { $$ = new ArithOperation(ArithOperation::NEG, $2, 0);}
         | '(' expr ')'      { $$ = $2;}
         ;
 
 %%
 
 void expr_arith_error(
-    YYLTYPE *       llocp,
-    mem_collector * mc,
-    ObjectXML *     oxml,
-    int&            result,
-    char **         error_msg,
-    yyscan_t        scanner,
-    const char *    str)
+    YYLTYPE *         llocp,
+    mem_collector *   mc,
+    ArithExpression ** result,
+    char **           error_msg,
+    yyscan_t          scanner,
+    const char *      str)
 {
     int length;
 
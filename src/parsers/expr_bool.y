@@ -22,13 +22,14 @@
 #define YYERROR_VERBOSE
 #define expr_bool_lex expr_lex
 
-void expr_bool_error(YYLTYPE * llocp, mem_collector * mc, ObjectXML * oxml,
-    bool& result, char ** error_msg, yyscan_t scanner, const char * str);
+void expr_bool_error(YYLTYPE * llocp, mem_collector * mc,
+    BoolExpression ** result, char ** error_msg, yyscan_t scanner,
+    const char * str);
 
 int expr_bool_lex (YYSTYPE *lvalp, YYLTYPE *llocp, mem_collector * mc,
     yyscan_t scanner);
 
-int expr_bool_parse(ObjectXML *oxml, bool& result, char ** errmsg,
+int expr_bool_parse(BoolExpression ** result, char ** errmsg,
     yyscan_t scanner)
 {
     mem_collector mc;
@@ -36,7 +37,9 @@ int expr_bool_parse(ObjectXML *oxml, bool& result, char ** errmsg,
 
     mem_collector_init(&mc);
 
-    rc = expr_bool_parse(&mc, oxml, result, errmsg, scanner);
+    *result = 0;
+
+    rc = expr_bool_parse(&mc, result, errmsg, scanner);
 
     mem_collector_cleanup(&mc);
 
@@ -59,17 +62,16 @@ int expr_bool_parse(ObjectXML *oxml, bool& result, char ** errmsg,
 
 #include "mem_collector.h"
 
-#include "ObjectXML.h"
+#include "Expression.h"
 
 typedef void * yyscan_t;
 
-int expr_bool_parse(ObjectXML *oxml, bool& result, char ** errmsg,
+int expr_bool_parse(BoolExpression ** result, char ** errmsg,
     yyscan_t scanner);
 }
 
 %parse-param {mem_collector * mc}
-%parse-param {ObjectXML * oxml}
-%parse-param {bool& result}
+%parse-param {BoolExpression ** result}
 %parse-param {char ** error_msg}
 %parse-param {yyscan_t scanner}
 
@@ -77,14 +79,16 @@ int expr_bool_parse(ObjectXML *oxml, bool& result, char ** errmsg,
 %lex-param {yyscan_t scanner}
 
 %union {
-    char *  val_str;
-    int     val_int;
-    float   val_float;
+    char *           val_str;
+    int              val_int;
+    float            val_float;
+    BoolExpression * val_expr;
 };
 
 %defines
 %locations
 %pure-parser
+%define parse.error verbose
 %name-prefix "expr_bool_"
 %output      "expr_bool.cc"
 
@@ -92,163 +96,83 @@ int expr_bool_parse(ObjectXML *oxml, bool& result, char ** errmsg,
 %token <val_int>    INTEGER
 %token <val_str>    STRING
 %token <val_float>  FLOAT
-%type  <val_int>    stmt expr
+%type  <val_expr>   expr
+
+%destructor { delete $$; } <val_expr>
 
 %%
 
-stmt:   expr    { result=$1;   }
-        |       { result=true; } /* TRUE BY DEFAULT, ON EMPTY STRINGS */
+stmt:   expr    { *result = $1; }
+        |       { *result = new BoolConstant(true); } /* TRUE BY DEFAULT, ON EMPTY STRINGS */
         ;
 
 expr:   STRING '=' INTEGER {
-            int val = $3;
-            int rc;
-
-            rc = oxml->search($1,val);
-
-            $$ = (rc == 0 && val == $3);
+            $$ = new BoolCompare<int>($1, BoolCompare<int>::EQ, $3);
         }
 
         | STRING '!' '=' INTEGER {
-            int val = $4;
-            int rc;
-
-            rc = oxml->search($1,val);
-
-            $$ = (rc == 0 && val != $4);
+            $$ = new BoolCompare<int>($1, BoolCompare<int>::NE, $4);
         }
 
         | STRING '>' INTEGER {
-            int val, rc;
-
-            rc = oxml->search($1,val);
-            $$ = (rc == 0 && val > $3);
+            $$ = new BoolCompare<int>($1, BoolCompare<int>::GT, $3);
         }
 
         | STRING '<' INTEGER {
-            int val, rc;
-
-            rc = oxml->search($1,val);
-            $$ = (rc == 0 && val < $3);
+            $$ = new BoolCompare<int>($1, BoolCompare<int>::LT, $3);
         }
 
         | STRING '@''>' INTEGER {
-            std::vector<int> val;
-            std::vector<int>::iterator it;
-
-            $$ = false;
-
-            oxml->search($1,val);
-
-            for (it=val.begin(); it != val.end(); ++it)
-            {
-                if ($4 == *it)
-                {
-                    $$ = true;
-                    break;
-                }
-            }
+            $$ = new BoolCompare<int>($1, BoolCompare<int>::CONTAINS, $4);
         }
 
         | STRING '=' FLOAT {
-            float val, rc;
-
-            rc = oxml->search($1,val);
-            $$ = (rc == 0 && val == $3);
+            $$ = new BoolCompare<float>($1, BoolCompare<float>::EQ, $3);
         }
 
         | STRING '!' '=' FLOAT {
-            float val, rc;
-
-            rc = oxml->search($1,val);
-            $$ = (rc == 0 && val != $4);
+            $$ = new BoolCompare<float>($1, BoolCompare<float>::NE, $4);
         }
 
         | STRING '>' FLOAT {
-            float val, rc;
-
-            rc = oxml->search($1,val);
-            $$ = (rc == 0 && val > $3);
+            $$ = new BoolCompare<float>($1, BoolCompare<float>::GT, $3);
         }
 
         | STRING '<' FLOAT {
-            float val, rc;
-
-            rc = oxml->search($1,val);
-            $$ = (rc == 0 && val < $3);
+            $$ = new BoolCompare<float>($1, BoolCompare<float>::LT, $3);
         }
 
         | STRING '@''>' FLOAT {
-            std::vector<float> val;
-            std::vector<float>::iterator it;
-
-            $$ = false;
-
-            oxml->search($1,val);
-
-            for (it=val.begin(); it != val.end(); ++it)
-            {
-                if ($4 == *it)
-                {
-                    $$ = true;
-                    break;
-                }
-            }
+            $$ = new BoolCompare<float>($1, BoolCompare<float>::CONTAINS, $4);
         }
 
         | STRING '=' STRING {
-            std::string val;
-            int rc;
-
-            rc = oxml->search($1,val);
-            $$ = (rc != 0 || $3==0) ? false : fnmatch($3,val.c_str(),0)==0;
+            $$ = new BoolMatch($1, BoolMatch::EQ, $3);
         }
 
         | STRING '!''=' STRING {
-            std::string val;
-            int rc;
-
-            rc = oxml->search($1,val);
-            $$ = (rc != 0 || $4==0) ? false : fnmatch($4,val.c_str(),0)!=0;
+            $$ = new BoolMatch($1, BoolMatch::NE, $4);
         }
 
         | STRING '@''>' STRING {
-            std::vector<std::string> val;
-            std::vector<std::string>::iterator it;
-
-            $$ = false;
-
-            if ( $4 != 0 )
-            {
-                oxml->search($1,val);
-
-                for (it=val.begin(); it != val.end(); ++it)
-                {
-                    if ( fnmatch($4, (*it).c_str(), 0) == 0 )
-                    {
-                        $$ = true;
-                        break;
-                    }
-                }
-            }
+            $$ = new BoolMatch($1, BoolMatch::CONTAINS, $4);
         }
 
-        | expr '&' expr { $$ = $1 && $3; }
-        | expr '|' expr { $$ = $1 || $3; }
-        | '!' expr      { $$ = ! $2; }
-        | '(' expr ')'  { $$ =   $2; }
+        | expr '&' expr { $$ = new BoolLogical(BoolLogical::AND, $1, $3); }
+        | expr '|' expr { $$ = new BoolLogical(BoolLogical::OR, $1, $3); }
+        | '!' expr      { $$ = new BoolLogical(BoolLogical::NOT, $2, 0); }
+        | '(' expr ')'  { $$ = $2; }
         ;
 
 %%
 
 void expr_bool_error(
-    YYLTYPE *       llocp,
-    mem_collector * mc,
-    ObjectXML *     oxml,
-    bool&           result,
-    char **         error_msg,
-    yyscan_t        scanner,
-    const char *    str)
+    YYLTYPE *        llocp,
+    mem_collector *  mc,
+    BoolExpression ** result,
+    char **          error_msg,
+    yyscan_t         scanner,
+    const char *     str)
 {
     int length;
 
@@ -266,6 +190,4 @@ void expr_bool_error(
             llocp->first_column,
             llocp->last_column);
     }
-
-    result = false;
 }
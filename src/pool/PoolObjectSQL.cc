@@ -16,6 +16,7 @@
 
 #include "PoolObjectSQL.h"
 #include "PoolObjectAuth.h"
+#include "PoolSQLCache.h"
 #include "NebulaUtil.h"
 #include "Nebula.h"
 #include "Clusterable.h"
@@ -61,13 +62,51 @@ int PoolObjectSQL::select(SqlDB *db)
     ostringstream   oss;
     int             rc;
     int             boid;
+    string          body;
+
+    boid = oid;
+
+    if ( db_body != 0 )
+    {
+        oid = -1;
+
+        rc = from_xml(*db_body);
+
+        if ((rc != 0) || (oid != boid ))
+        {
+            return -1;
+        }
+
+        if ( cache != 0 )
+        {
+            cache->set(oid, *db_body);
+        }
+
+        return 0;
+    }
+
+    if ( cache != 0 && cache->get(boid, body) )
+    {
+        oid = -1;
+
+        rc = from_xml(body);
+
+        if ((rc != 0) || (oid != boid ))
+        {
+            cache->invalidate(boid);
+
+            return -1;
+        }
+
+        return 0;
+    }
 
     set_callback(
-            static_cast<Callbackable::Callback>(&PoolObjectSQL::select_cb));
+            static_cast<Callbackable::Callback>(&PoolObjectSQL::select_cb),
+            static_cast<void *>(&body));
 
     oss << "SELECT body FROM " << table << " WHERE oid = " << oid;
 
-    boid = oid;
     oid  = -1;
 
     rc = db->exec_rd(oss, this);
@@ -79,12 +118,43 @@ int PoolObjectSQL::select(SqlDB *db)
         return -1;
     }
 
+    if ( cache != 0 )
+    {
+        cache->set(oid, body);
+    }
+
     return 0;
 }
 
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+bool PoolObjectSQL::get_db_records(std::vector<string>& records)
+{
+    if ( db_records != 0 )
+    {
+        records = *db_records;
+
+        return true;
+    }
+
+    return cache != 0 && cache->get_records(oid, records);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void PoolObjectSQL::cache_db_records(const std::vector<string>& records)
+{
+    if ( cache != 0 )
+    {
+        cache->set_records(oid, records);
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 int PoolObjectSQL::select_oid(SqlDB *db, const char * _table,
         const string& _name, int _uid)
 {
@@ -415,17 +485,20 @@ int PoolObjectSQL::perms_from_xml()
 {
     int rc = 0;
 
-    rc += xpath(owner_u, "/*/PERMISSIONS/OWNER_U", 0);
-    rc += xpath(owner_m, "/*/PERMISSIONS/OWNER_M", 0);
-    rc += xpath(owner_a, "/*/PERMISSIONS/OWNER_A", 0);
+    ObjectXML::ChildIndex root(*this);
+    ObjectXML::ChildIndex perms(root.node("PERMISSIONS"));
 
-    rc += xpath(group_u, "/*/PERMISSIONS/GROUP_U", 0);
-    rc += xpath(group_m, "/*/PERMISSIONS/GROUP_M", 0);
-    rc += xpath(group_a, "/*/PERMISSIONS/GROUP_A", 0);
+    rc += perms.get(owner_u, "OWNER_U", 0);
+    rc += perms.get(owner_m, "OWNER_M", 0);
+    rc += perms.get(owner_a, "OWNER_A", 0);
 
-    rc += xpath(other_u, "/*/PERMISSIONS/OTHER_U", 0);
-    rc += xpath(other_m, "/*/PERMISSIONS/OTHER_M", 0);
-    rc += xpath(other_a, "/*/PERMISSIONS/OTHER_A", 0);
+    rc += perms.get(group_u, "GROUP_U", 0);
+    rc += perms.get(group_m, "GROUP_M", 0);
+    rc += perms.get(group_a, "GROUP_A", 0);
+
+    rc += perms.get(other_u, "OTHER_U", 0);
+    rc += perms.get(other_m, "OTHER_M", 0);
+    rc += perms.get(other_a, "OTHER_A", 0);
 
     return rc;
 }
@@ -433,7 +506,7 @@ int PoolObjectSQL::perms_from_xml()
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
-void PoolObjectSQL::get_permissions(PoolObjectAuth& auth)
+void PoolObjectSQL::get_permissions(PoolObjectAuth& auth) const
 {
     auth.obj_type = obj_type;
 
@@ -455,7 +528,7 @@ void PoolObjectSQL::get_permissions(PoolObjectAuth& auth)
 
     auth.locked = static_cast<int>(locked);
 
-    Clusterable* cl = dynamic_cast<Clusterable*>(this);
+    const Clusterable* cl = dynamic_cast<const Clusterable*>(this);
 
     if (cl != 0)
     {
@@ -463,7 +536,8 @@ void PoolObjectSQL::get_permissions(PoolObjectAuth& auth)
     }
     else
     {
-        ClusterableSingle* cls = dynamic_cast<ClusterableSingle*>(this);
+        const ClusterableSingle* cls =
+            dynamic_cast<const ClusterableSingle*>(this);
 
         if (cls != 0)
         {
@@ -665,25 +739,22 @@ int PoolObjectSQL::lock_db_from_xml()
     int rc = 0;
     int locked_int;
 
-    vector<xmlNodePtr> content;
-
-    ObjectXML::get_nodes("/*/LOCK/LOCKED", content);
+    ObjectXML::ChildIndex root(*this);
+    ObjectXML::ChildIndex locks(root.node("LOCK"));
 
-    if ( content.empty() )
+    if ( locks.node("LOCKED") == 0 )
     {
         return 0;
     }
 
-    rc += xpath(locked_int,  "/*/LOCK/LOCKED", 0);
-    rc += xpath(lock_req_id, "/*/LOCK/REQ_ID", -1);
-    rc += xpath(lock_owner,  "/*/LOCK/OWNER", -1);
+    rc += locks.get(locked_int,  "LOCKED", 0);
+    rc += locks.get(lock_req_id, "REQ_ID", -1);
+    rc += locks.get(lock_owner,  "OWNER", -1);
 
-    xpath<time_t>(lock_time, "/*/LOCK/TIME", time(0));
+    locks.get<time_t>(lock_time, "TIME", time(0));
 
     locked = static_cast<LockStates>(locked_int);
 
-    ObjectXML::free_nodes(content);
-
     return rc;
 }
 
@@ -79,15 +79,103 @@ void PoolSQL::set_lastOID(int _last_oid)
 
     _set_lastOID(_last_oid, db, table);
 
+    next_oid  = 0;
+    block_oid = -1;
+
     unlock();
 }
 
 /* -------------------------------------------------------------------------- */
+
+int PoolSQL::next_lastOID()
+{
+    unsigned int gen;
+
+    bool exclusive = cache.get_generation(gen);
+
+    if ( exclusive && gen == block_generation && next_oid <= block_oid )
+    {
+        return next_oid++;
+    }
+
+    int lastOID = _get_lastOID(db, table);
+
+    if (lastOID == INT_MAX)
+    {
+        lastOID = -1;
+    }
+
+    // OIDs close to INT_MAX are assigned one at a time so they wrap to 0
+    exclusive = exclusive && lastOID < INT_MAX - OID_BLOCK_SIZE;
+
+    int last_block = lastOID + 1;
+
+    if ( exclusive )
+    {
+        last_block = lastOID + OID_BLOCK_SIZE;
+    }
+
+    if ( _set_lastOID(last_block, db, table) == -1 )
+    {
+        next_oid  = 0;
+        block_oid = -1;
+
+        return -1;
+    }
+
+    if ( exclusive )
+    {
+        next_oid  = lastOID + 2;
+        block_oid = last_block;
+
+        block_generation = gen;
+    }
+    else
+    {
+        next_oid  = 0;
+        block_oid = -1;
+    }
+
+    return lastOID + 1;
+}
+
 /* -------------------------------------------------------------------------- */
 
-PoolSQL::PoolSQL(SqlDB * _db, const char * _table):db(_db), table(_table)
+void PoolSQL::release_lastOID(int oid)
+{
+    if ( block_oid != -1 )
+    {
+        if ( oid == next_oid - 1 )
+        {
+            next_oid = oid;
+        }
+
+        return;
+    }
+
+    // OID not allocated from a block, restore last_oid in pool_control
+    int lastOID = oid - 1;
+
+    if ( lastOID < 0 )
+    {
+        lastOID = 0;
+    }
+
+    _set_lastOID(lastOID, db, table);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+PoolSQL::PoolSQL(SqlDB * _db, const char * _table, bool cache_objects,
+        bool has_records):db(_db), table(_table),
+    cache(_table, cache_objects, has_records), next_oid(0),
+    block_oid(-1), block_generation(0), changes_epoch(time(0)),
+    changes_version(0), changes_min(0)
 {
     pthread_mutex_init(&mutex,0);
+
+    pthread_mutex_init(&changes_mutex,0);
 };
 
 /* -------------------------------------------------------------------------- */
@@ -100,6 +188,8 @@ PoolSQL::~PoolSQL()
     pthread_mutex_lock(&mutex);
 
     pthread_mutex_destroy(&mutex);
+
+    pthread_mutex_destroy(&changes_mutex);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -114,22 +204,19 @@ int PoolSQL::allocate(PoolObjectSQL *objsql, string& error_str)
 
     lock();
 
-    lastOID = _get_lastOID(db, table);
+    lastOID = next_lastOID();
 
-    if (lastOID == INT_MAX)
-    {
-        lastOID = -1;
-    }
-
-    objsql->oid = ++lastOID;
-
-    if ( _set_lastOID(lastOID, db, table) == -1 )
+    if ( lastOID == -1 )
     {
         unlock();
 
         return -1;
     }
 
+    objsql->oid = lastOID;
+
+    cache.invalidate(lastOID);
+
     rc = objsql->insert(db, error_str);
 
     if ( rc != 0 )
@@ -139,23 +226,116 @@ int PoolSQL::allocate(PoolObjectSQL *objsql, string& error_str)
     else
     {
         rc = lastOID;
+
+        record_change(lastOID);
     }
 
     delete objsql;
 
     if( rc == -1 )
     {
-        lastOID = lastOID - 1;
+        release_lastOID(lastOID);
+    }
+
+    unlock();
+
+    return rc;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void PoolSQL::record_change(int oid)
+{
+    unsigned int generation;
+
+    if (!cache.get_generation(generation))
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&changes_mutex);
+
+    changes_version++;
+
+    auto it = changes.find(oid);
+
+    if ( it != changes.end() )
+    {
+        changes_log.erase(it->second);
+
+        it->second = changes_version;
+    }
+    else
+    {
+        changes.insert(make_pair(oid, changes_version));
+    }
+
+    changes_log.insert(make_pair(changes_version, oid));
+
+    if ( changes.size() > MAX_CHANGES )
+    {
+        auto first = changes_log.begin();
+
+        changes_min = first->first;
+
+        changes.erase(first->second);
+
+        changes_log.erase(first);
+    }
+
+    pthread_mutex_unlock(&changes_mutex);
+}
 
-        if ( lastOID < 0 )
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int PoolSQL::get_changes(string& version, vector<int>& oids)
+{
+    unsigned int generation;
+
+    long long          epoch;
+    unsigned int       vgeneration;
+    unsigned long long since;
+
+    char sep1, sep2;
+    int  rc = -1;
+
+    oids.clear();
+
+    if (!cache.get_generation(generation))
+    {
+        version.clear();
+
+        return -1;
+    }
+
+    istringstream iss(version);
+
+    iss >> epoch >> sep1 >> vgeneration >> sep2 >> since;
+
+    pthread_mutex_lock(&changes_mutex);
+
+    if (!iss.fail() && sep1 == '.' && sep2 == '.' && epoch == changes_epoch &&
+            vgeneration == generation && since >= changes_min &&
+            since <= changes_version)
+    {
+        for (auto it = changes_log.upper_bound(since); it != changes_log.end();
+                ++it)
         {
-            lastOID = 0;
+            oids.push_back(it->second);
         }
 
-        _set_lastOID(lastOID, db, table);
+        rc = 0;
     }
 
-    unlock();
+    ostringstream oss;
+
+    oss << changes_epoch << '.' << generation << '.' << changes_version;
+
+    pthread_mutex_unlock(&changes_mutex);
+
+    version = oss.str();
 
     return rc;
 }
@@ -180,8 +360,12 @@ PoolObjectSQL * PoolSQL::get(int oid)
 
     objectsql->mutex = object_lock;
 
+    objectsql->cache = &cache;
+
     int rc = objectsql->select(db);
 
+    objectsql->cache = 0;
+
     if ( rc != 0 )
     {
         objectsql->unlock(); //Free object and unlock cache line mutex
@@ -208,8 +392,23 @@ PoolObjectSQL * PoolSQL::get_ro(int oid)
 
     objectsql->ro = true;
 
+    // Read the object from the cache only if no writer holds it
+    pthread_mutex_t * object_lock = cache.trylock_line(oid);
+
+    if ( object_lock != 0 )
+    {
+        objectsql->cache = &cache;
+    }
+
     int rc = objectsql->select(db);
 
+    objectsql->cache = 0;
+
+    if ( object_lock != 0 )
+    {
+        pthread_mutex_unlock(object_lock);
+    }
+
     if ( rc != 0 )
     {
         objectsql->unlock(); //Free object;
@@ -223,6 +422,232 @@ PoolObjectSQL * PoolSQL::get_ro(int oid)
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+std::shared_ptr<const PoolObjectSQL> PoolSQL::get_ro_shared(int oid)
+{
+    std::shared_ptr<const PoolObjectSQL> object;
+
+    if ( oid < 0 )
+    {
+        return object;
+    }
+
+    if ( cache.get(oid, object) )
+    {
+        return object;
+    }
+
+    PoolObjectSQL * objectsql = create();
+
+    objectsql->oid = oid;
+
+    objectsql->ro = true;
+
+    // Share the object only if it is read from the cache line without writers
+    pthread_mutex_t * object_lock = cache.trylock_line(oid);
+
+    if ( object_lock != 0 )
+    {
+        objectsql->cache = &cache;
+    }
+
+    int rc = objectsql->select(db);
+
+    objectsql->cache = 0;
+
+    if ( rc != 0 )
+    {
+        if ( object_lock != 0 )
+        {
+            pthread_mutex_unlock(object_lock);
+        }
+
+        objectsql->unlock(); //Free object;
+
+        return object;
+    }
+
+    object.reset(objectsql);
+
+    if ( object_lock != 0 )
+    {
+        cache.set(oid, object);
+
+        pthread_mutex_unlock(object_lock);
+    }
+
+    return object;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void PoolSQL::get_ro_many(const std::vector<int>& oids,
+        std::vector<PoolObjectSQL *>& objects)
+{
+    select_many(oids, &objects);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void PoolSQL::prefetch(const std::vector<int>& oids)
+{
+    select_many(oids, 0);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void PoolSQL::select_many(const std::vector<int>& oids,
+        std::vector<PoolObjectSQL *> * objects)
+{
+    std::vector<int>::const_iterator it = oids.begin();
+
+    while ( it != oids.end() )
+    {
+        // oid -> cache ticket, false if the body cannot be cached
+        std::map<int, std::pair<bool, unsigned long> > batch;
+        std::map<int, std::pair<bool, unsigned long> >::iterator bit;
+
+        std::map<int, string> bodies;
+        std::map<int, string>::iterator body;
+
+        std::map<int, std::vector<string> > records;
+
+        ostringstream oss;
+
+        bool cacheable = false;
+
+        // No cache line is held while reading, the bodies are cached after
+        // the query only if no writer locked the object meanwhile
+        for (; it != oids.end() && batch.size() < MAX_BATCH_OIDS; ++it)
+        {
+            unsigned long ticket = 0;
+
+            string              cbody;
+            std::vector<string> crecords;
+
+            if ( *it < 0 || batch.count(*it) != 0 || bodies.count(*it) != 0 )
+            {
+                continue;
+            }
+
+            if ( cache.get(*it, cbody, crecords) )
+            {
+                if ( objects != 0 )
+                {
+                    bodies.insert(make_pair(*it, cbody));
+
+                    records[*it].swap(crecords);
+                }
+
+                continue;
+            }
+
+            bool rc = cache.get_ticket(*it, ticket);
+
+            if ( !rc && objects == 0 )
+            {
+                continue;
+            }
+
+            cacheable = cacheable || rc;
+
+            batch.insert(make_pair(*it, make_pair(rc, ticket)));
+        }
+
+        if ( !batch.empty() && (cacheable || objects != 0) )
+        {
+            std::map<int, string> db_bodies;
+
+            for (bit = batch.begin(); bit != batch.end(); ++bit)
+            {
+                if ( bit != batch.begin() )
+                {
+                    oss << ",";
+                }
+
+                oss << bit->first;
+            }
+
+            string oid_list = oss.str();
+
+            oss.str("");
+
+            oss << "SELECT oid, body FROM " << table << " WHERE oid IN ("
+                << oid_list << ")";
+
+            map_cb<int> cb;
+
+            cb.set_callback(&db_bodies);
+
+            int rc = db->exec_rd(oss, &cb);
+
+            cb.unset_callback();
+
+            if ( rc == 0 )
+            {
+                rc = select_records(oid_list, records);
+            }
+
+            if ( rc == 0 )
+            {
+                bodies.insert(db_bodies.begin(), db_bodies.end());
+            }
+            else
+            {
+                batch.clear();
+            }
+        }
+
+        for (body = bodies.begin(); body != bodies.end(); ++body)
+        {
+            std::vector<string>& object_records = records[body->first];
+
+            if ( objects != 0 )
+            {
+                PoolObjectSQL * objectsql = create();
+
+                objectsql->oid = body->first;
+
+                objectsql->ro = true;
+
+                objectsql->db_body    = &(body->second);
+                objectsql->db_records = &object_records;
+
+                int rc = objectsql->select(db);
+
+                objectsql->db_body    = 0;
+                objectsql->db_records = 0;
+
+                if ( rc == 0 )
+                {
+                    objects->push_back(objectsql);
+                }
+                else
+                {
+                    objectsql->unlock(); //Free object;
+
+                    continue;
+                }
+            }
+
+            bit = batch.find(body->first);
+
+            if ( bit != batch.end() && bit->second.first )
+            {
+                cache.set(bit->first, body->second, bit->second.second);
+
+                cache.set_records(bit->first, object_records,
+                        bit->second.second);
+            }
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 void PoolSQL::exist(const string& id_str, std::set<int>& id_list)
 {
     std::vector<int> existing_items;
@@ -15,72 +15,587 @@
 /* -------------------------------------------------------------------------- */
 
 #include "PoolSQLCache.h"
-#include "Nebula.h"
+#include "NebulaLog.h"
 
-unsigned int PoolSQLCache::MAX_ELEMENTS = 10000;
+unsigned int PoolSQLCache::MAX_ELEMENTS = 10000 / PoolSQLCache::NUM_SHARDS;
 
-PoolSQLCache::PoolSQLCache()
+std::atomic<bool> PoolSQLCache::enabled(false);
+
+std::atomic<unsigned int> PoolSQLCache::generation(0);
+
+PoolSQLCache::PoolSQLCache(const std::string& _table, bool _cache_objects,
+        bool _has_records):table(_table), cache_objects(_cache_objects),
+    has_records(_has_records)
 {
-    pthread_mutex_init(&mutex, 0);
 };
 
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+void PoolSQLCache::enable(bool _enabled)
+{
+    generation++;
+
+    enabled = _enabled;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 pthread_mutex_t * PoolSQLCache::lock_line(int oid)
 {
-    static unsigned int num_locks = 0;
+    CacheShard& shard = get_shard(oid);
+
+    CacheLine * cl;
+
+    bool flushed;
+
+    std::shared_ptr<const PoolObjectSQL> object;
+
+    shard.lock();
+
+    cl = shard.get_line(oid);
+
+    cl->active++;
+
+    shard.unlock();
+
+    cl->lock();
+
+    shard.lock();
 
+    cl->active--;
+
+    cl->stamp = ++shard.seq;
+
+    // The writer may update other tables of the object (e.g. VM history)
+    object.swap(cl->object);
+
+    flushed = shard.check_flush();
+
+    shard.unlock();
+
+    if ( flushed )
+    {
+        log_stats();
+    }
+
+    return &(cl->mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+pthread_mutex_t * PoolSQLCache::trylock_line(int oid)
+{
+    pthread_mutex_t * line_mutex = 0;
+
+    bool flushed;
+
+    if ( !cache_objects || !enabled )
+    {
+        return 0;
+    }
+
+    CacheShard& shard = get_shard(oid);
+
+    shard.lock();
+
+    CacheLine * cl = shard.get_line(oid);
+
+    if ( cl->trylock() == 0 )
+    {
+        line_mutex = &(cl->mutex);
+    }
+
+    flushed = shard.check_flush();
+
+    shard.unlock();
+
+    if ( flushed )
+    {
+        log_stats();
+    }
+
+    return line_mutex;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+bool PoolSQLCache::get(int oid, std::string& body)
+{
     std::map<int, CacheLine *>::iterator it;
 
-    CacheLine * cl;
+    if ( !cache_objects || !enabled )
+    {
+        return false;
+    }
+
+    CacheShard& shard = get_shard(oid);
 
-    lock();
+    shard.lock();
 
-    it = cache.find(oid);
+    it = shard.lines.find(oid);
 
-    if ( it == cache.end() )
+    if ( it == shard.lines.end() || !it->second->cached ||
+            it->second->generation != generation )
     {
-        cl = new CacheLine();
+        shard.misses++;
+
+        shard.unlock();
 
-        cache.insert(make_pair(oid, cl));
+        return false;
     }
-    else
+
+    shard.hits++;
+
+    it->second->referenced = true;
+
+    body = it->second->body;
+
+    shard.unlock();
+
+    return true;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void PoolSQLCache::set(int oid, const std::string& body)
+{
+    if ( !cache_objects || !enabled )
     {
-        cl = it->second;
+        return;
     }
 
-    cl->active++;
+    std::shared_ptr<const PoolObjectSQL> object;
 
-    unlock();
+    CacheShard& shard = get_shard(oid);
 
-    cl->lock();
+    shard.lock();
 
-    lock();
+    CacheLine * cl = shard.get_line(oid);
 
-    cl->active--;
+    cl->body       = body;
+    cl->cached     = true;
+    cl->referenced = true;
+    cl->generation = generation;
+
+    cl->records.clear();
+
+    cl->records_cached = !has_records;
+
+    object.swap(cl->object);
+
+    shard.unlock();
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+bool PoolSQLCache::get_ticket(int oid, unsigned long& ticket)
+{
+    bool rc = false;
+
+    if ( !cache_objects || !enabled )
+    {
+        return false;
+    }
+
+    CacheShard& shard = get_shard(oid);
+
+    shard.lock();
+
+    CacheLine * cl = shard.get_line(oid);
+
+    // A writer holding the line may update the DB after the body is read
+    if ( cl->trylock() == 0 )
+    {
+        ticket = shard.seq;
+
+        cl->unlock();
+
+        rc = true;
+    }
+
+    shard.unlock();
+
+    return rc;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void PoolSQLCache::set(int oid, const std::string& body, unsigned long ticket)
+{
+    if ( !cache_objects || !enabled )
+    {
+        return;
+    }
+
+    std::shared_ptr<const PoolObjectSQL> object;
+
+    CacheShard& shard = get_shard(oid);
+
+    shard.lock();
+
+    CacheLine * cl = shard.get_line(oid);
+
+    if ( cl->stamp <= ticket && cl->trylock() == 0 )
+    {
+        cl->body       = body;
+        cl->cached     = true;
+        cl->referenced = true;
+        cl->generation = generation;
+
+        cl->records.clear();
+
+        cl->records_cached = !has_records;
+
+        object.swap(cl->object);
+
+        cl->unlock();
+    }
+
+    shard.unlock();
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+bool PoolSQLCache::get(int oid, std::string& body,
+        std::vector<std::string>& records)
+{
+    std::map<int, CacheLine *>::iterator it;
+
+    if ( !cache_objects || !enabled )
+    {
+        return false;
+    }
+
+    CacheShard& shard = get_shard(oid);
+
+    shard.lock();
+
+    it = shard.lines.find(oid);
+
+    if ( it == shard.lines.end() || !it->second->cached ||
+            !it->second->records_cached ||
+            it->second->generation != generation )
+    {
+        shard.misses++;
+
+        shard.unlock();
+
+        return false;
+    }
+
+    shard.hits++;
+
+    it->second->referenced = true;
+
+    body    = it->second->body;
+    records = it->second->records;
+
+    shard.unlock();
+
+    return true;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+bool PoolSQLCache::get_records(int oid, std::vector<std::string>& records)
+{
+    std::map<int, CacheLine *>::iterator it;
+
+    if ( !cache_objects || !enabled )
+    {
+        return false;
+    }
+
+    CacheShard& shard = get_shard(oid);
+
+    shard.lock();
+
+    it = shard.lines.find(oid);
+
+    if ( it == shard.lines.end() || !it->second->cached ||
+            !it->second->records_cached ||
+            it->second->generation != generation )
+    {
+        shard.unlock();
 
-    if ( ++num_locks > MAX_ELEMENTS )
+        return false;
+    }
+
+    records = it->second->records;
+
+    shard.unlock();
+
+    return true;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void PoolSQLCache::set_records(int oid, const std::vector<std::string>& records)
+{
+    if ( !cache_objects || !enabled || !has_records )
     {
-        num_locks = 0;
+        return;
+    }
+
+    CacheShard& shard = get_shard(oid);
+
+    shard.lock();
+
+    CacheLine * cl = shard.get_line(oid);
+
+    // Records are only stored with the body they belong to
+    if ( cl->cached && cl->generation == generation )
+    {
+        cl->records        = records;
+        cl->records_cached = true;
+    }
+
+    shard.unlock();
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void PoolSQLCache::set_records(int oid, const std::vector<std::string>& records,
+        unsigned long ticket)
+{
+    if ( !cache_objects || !enabled || !has_records )
+    {
+        return;
+    }
+
+    CacheShard& shard = get_shard(oid);
+
+    shard.lock();
+
+    CacheLine * cl = shard.get_line(oid);
+
+    if ( cl->cached && cl->generation == generation && cl->stamp <= ticket &&
+            cl->trylock() == 0 )
+    {
+        cl->records        = records;
+        cl->records_cached = true;
+
+        cl->unlock();
+    }
+
+    shard.unlock();
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+bool PoolSQLCache::get(int oid, std::shared_ptr<const PoolObjectSQL>& object)
+{
+    std::map<int, CacheLine *>::iterator it;
+
+    if ( !cache_objects || !enabled )
+    {
+        return false;
+    }
+
+    CacheShard& shard = get_shard(oid);
+
+    shard.lock();
+
+    it = shard.lines.find(oid);
+
+    if ( it == shard.lines.end() || !it->second->object ||
+            it->second->generation != generation )
+    {
+        shard.unlock();
+
+        return false;
+    }
+
+    shard.hits++;
+
+    it->second->referenced = true;
+
+    object = it->second->object;
+
+    shard.unlock();
+
+    return true;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void PoolSQLCache::set(int oid,
+        const std::shared_ptr<const PoolObjectSQL>& object)
+{
+    if ( !cache_objects || !enabled )
+    {
+        return;
+    }
+
+    CacheShard& shard = get_shard(oid);
+
+    shard.lock();
+
+    CacheLine * cl = shard.get_line(oid);
+
+    // Only share instances of the current cached body
+    if ( cl->cached && cl->generation == generation )
+    {
+        cl->object = object;
+    }
+
+    shard.unlock();
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void PoolSQLCache::invalidate(int oid)
+{
+    std::map<int, CacheLine *>::iterator it;
+
+    // Release the shared instance (if no longer in use) out of the shard lock
+    std::shared_ptr<const PoolObjectSQL> object;
+
+    CacheShard& shard = get_shard(oid);
+
+    shard.lock();
 
-        if ( cache.size() > MAX_ELEMENTS )
+    it = shard.lines.find(oid);
+
+    if ( it != shard.lines.end() )
+    {
+        it->second->cached = false;
+
+        it->second->body.clear();
+
+        it->second->records_cached = false;
+
+        it->second->records.clear();
+
+        object.swap(it->second->object);
+    }
+
+    shard.unlock();
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void PoolSQLCache::get_stats(unsigned long& hits, unsigned long& misses,
+        unsigned long& objects)
+{
+    hits    = 0;
+    misses  = 0;
+    objects = 0;
+
+    for (unsigned int i = 0; i < NUM_SHARDS; ++i)
+    {
+        shards[i].lock();
+
+        hits    += shards[i].hits;
+        misses  += shards[i].misses;
+        objects += shards[i].lines.size();
+
+        shards[i].unlock();
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void PoolSQLCache::log_stats()
+{
+    std::ostringstream oss;
+
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long objects;
+
+    get_stats(hits, misses, objects);
+
+    oss << "Cache for " << table << ": " << objects << " objects, "
+        << hits << " hits, " << misses << " misses";
+
+    NebulaLog::log("ONE", Log::INFO, oss);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+/* PoolSQLCache::CacheShard                                                   */
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+PoolSQLCache::CacheShard::~CacheShard()
+{
+    for (std::map<int,CacheLine *>::iterator it=lines.begin(); it!=lines.end();
+            ++it)
+    {
+        delete it->second;
+    }
+
+    pthread_mutex_destroy(&mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+PoolSQLCache::CacheLine * PoolSQLCache::CacheShard::get_line(int oid)
+{
+    std::map<int, CacheLine *>::iterator it;
+
+    CacheLine * cl;
+
+    it = lines.find(oid);
+
+    if ( it == lines.end() )
+    {
+        cl = new CacheLine(seq);
+
+        lines.insert(make_pair(oid, cl));
+    }
+    else
+    {
+        cl = it->second;
+    }
+
+    return cl;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+bool PoolSQLCache::CacheShard::check_flush()
+{
+    if ( ++accesses > MAX_ELEMENTS )
+    {
+        accesses = 0;
+
+        if ( lines.size() > MAX_ELEMENTS )
         {
             flush_cache_lines();
+
+            return true;
         }
     }
 
-    unlock();
-
-    return &(cl->mutex);
+    return false;
 }
 
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
-void PoolSQLCache::flush_cache_lines()
+void PoolSQLCache::CacheShard::flush_cache_lines()
 {
-    for (std::map<int,CacheLine *>::iterator it=cache.begin(); it!=cache.end();)
+    for (std::map<int,CacheLine *>::iterator it=lines.begin(); it!=lines.end();)
     {
         CacheLine * cl = it->second;
 
@@ -100,9 +615,20 @@ void PoolSQLCache::flush_cache_lines()
             continue;
         }
 
-        delete it->second; // cache line locked & active == 0
+        if ( cl->referenced ) // second chance for recently used objects
+        {
+            cl->referenced = false;
+
+            cl->unlock();
+
+            ++it;
+            continue;
+        }
+
+        cl->unlock(); // cache line not in use & active == 0
 
-        it = cache.erase(it);
+        delete cl;
+
+        it = lines.erase(it);
     }
 };
-
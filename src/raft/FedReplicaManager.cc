@@ -414,7 +414,7 @@ int FedReplicaManager::xmlrpc_replicate_log(int zone_id, bool& success,
     xmlrpc_c::value result;
     xmlrpc_c::paramList replica_params;
 
-    if ( Client::read_oneauth(xmlrpc_secret, error) == -1 )
+    if ( Client::get_oneauth(xmlrpc_secret, error) == -1 )
     {
         return -1;
     }
@@ -428,7 +428,7 @@ int FedReplicaManager::xmlrpc_replicate_log(int zone_id, bool& success,
     // Do the XML-RPC call
     // -------------------------------------------------------------------------
     xml_rc = Client::client()->call(zedp, replica_method, replica_params,
-        xmlrpc_timeout_ms, &result, error);
+        xmlrpc_timeout_ms, &result, error, true);
 
     if ( xml_rc == 0 )
     {
@@ -24,6 +24,7 @@
 #include "Nebula.h"
 
 #include <cstdlib>
+#include <deque>
 
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
@@ -31,6 +32,8 @@ const time_t RaftManager::timer_period_ms = 50;
 
 const string RaftManager::raft_state_name = "RAFT_STATE";
 
+const int RaftManager::REPLICA_VERSION = 2;
+
 static void set_timeout(long long ms, struct timespec& timeout)
 {
     std::lldiv_t d;
@@ -52,8 +55,11 @@ static unsigned int get_zone_servers(std::map<int, std::string>& _s);
 RaftManager::RaftManager(int id, const VectorAttribute * leader_hook_mad,
         const VectorAttribute * follower_hook_mad, time_t log_purge,
         long long bcast, long long elect, time_t xmlrpc,
+        unsigned int _batch_records, size_t _batch_size, unsigned int window,
         const string& remotes_location):server_id(id), term(0), num_servers(0),
-        reconciling(false), commit(0), leader_hook(0), follower_hook(0)
+        reconciling(false), batch_records(_batch_records),
+        batch_size(_batch_size), replica_window(window), commit(0),
+        leader_hook(0), follower_hook(0)
 {
     Nebula& nd    = Nebula::instance();
     LogDB * logdb = nd.get_logdb();
@@ -113,6 +119,9 @@ RaftManager::RaftManager(int id, const VectorAttribute * leader_hook_mad,
 		state = FOLLOWER;
 	}
 
+    // Objects can be cached only if this oned is the only writer of the DB
+    PoolSQLCache::enable(state == SOLO && !nd.is_cache());
+
     // -------------------------------------------------------------------------
     // Initialize Raft timers
     // -------------------------------------------------------------------------
@@ -313,6 +322,8 @@ void RaftManager::add_server(int follower_id, const std::string& endpoint)
 
 	match.insert(std::make_pair(follower_id, 0));
 
+	versions.insert(std::make_pair(follower_id, 0));
+
     oss << "Starting replication and heartbeat threads for follower: "
         << follower_id;
 
@@ -347,6 +358,8 @@ void RaftManager::delete_server(int follower_id)
 
 	match.erase(follower_id);
 
+	versions.erase(follower_id);
+
     oss << "Stopping replication and heartbeat threads for follower: "
         << follower_id;
 
@@ -384,6 +397,11 @@ extern "C" void * reconciling_thread(void *arg)
 
     rm->reconciling = false;
 
+    if ( rm->state == RaftManager::LEADER )
+    {
+        PoolSQLCache::enable(true);
+    }
+
     pthread_mutex_unlock(&(rm->mutex));
 
     free(index);
@@ -427,6 +445,8 @@ void RaftManager::leader()
     next.clear();
     match.clear();
 
+    versions.clear();
+
     requests.clear();
 
     if ( leader_hook != 0 )
@@ -448,6 +468,8 @@ void RaftManager::leader()
     else
     {
         _next_index = index + 1;
+
+        PoolSQLCache::enable(true);
     }
 
     for (it = servers.begin(); it != servers.end() ; ++it )
@@ -461,6 +483,8 @@ void RaftManager::leader()
 
         match.insert(std::make_pair(it->first, 0));
 
+        versions.insert(std::make_pair(it->first, 0));
+
         _follower_ids.push_back(it->first);
     }
 
@@ -528,6 +552,8 @@ void RaftManager::follower(unsigned int _term)
 
     state = FOLLOWER;
 
+    PoolSQLCache::enable(false);
+
     if ( _term > term )
     {
         term     = _term;
@@ -547,6 +573,8 @@ void RaftManager::follower(unsigned int _term)
     next.clear();
     match.clear();
 
+    versions.clear();
+
     requests.clear();
 
     pthread_mutex_unlock(&mutex);
@@ -620,7 +648,7 @@ void RaftManager::replicate_log(ReplicaRequest * request)
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
-void RaftManager::replicate_success(int follower_id)
+void RaftManager::replicate_success(int follower_id, uint64_t last_index)
 {
     std::map<int, ReplicaRequest *>::iterator it;
 
@@ -646,16 +674,26 @@ void RaftManager::replicate_success(int follower_id)
         return;
     }
 
-    uint64_t replicated_index = next_it->second;
+    uint64_t replicated_index = last_index;
 
-    match_it->second = replicated_index;
-    next_it->second  = replicated_index + 1;
+    // Stale reply, next index was reset while the call was in flight
+    if ( next_it->second > replicated_index )
+    {
+        pthread_mutex_unlock(&mutex);
+        return;
+    }
 
-    if ( requests.add_replica(replicated_index) == 0 )
+    for (uint64_t i = next_it->second; i <= replicated_index; ++i)
     {
-        commit = replicated_index;
+        if ( requests.add_replica(i) == 0 )
+        {
+            commit = i;
+        }
     }
 
+    match_it->second = replicated_index;
+    next_it->second  = replicated_index + 1;
+
     if (db_lindex > replicated_index && state == LEADER &&
             requests.is_replicable(replicated_index + 1))
     {
@@ -668,6 +706,62 @@ void RaftManager::replicate_success(int follower_id)
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+void RaftManager::snapshot_success(int follower_id, uint64_t index)
+{
+    std::map<int, uint64_t>::iterator next_it;
+    std::map<int, uint64_t>::iterator match_it;
+
+    Nebula& nd    = Nebula::instance();
+    LogDB * logdb = nd.get_logdb();
+
+	unsigned int db_lterm;
+    uint64_t db_lindex;
+
+    logdb->get_last_record_index(db_lindex, db_lterm);
+
+    pthread_mutex_lock(&mutex);
+
+    next_it  = next.find(follower_id);
+    match_it = match.find(follower_id);
+
+    if ( next_it == next.end() || match_it == match.end() )
+    {
+        pthread_mutex_unlock(&mutex);
+        return;
+    }
+
+    match_it->second = index;
+    next_it->second  = index + 1;
+
+    if (db_lindex > index && state == LEADER)
+    {
+        replica_manager.replicate(follower_id);
+    }
+
+    pthread_mutex_unlock(&mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int RaftManager::create_snapshot(const std::string& file, uint64_t& index,
+        unsigned int& term, uint64_t& fed_index)
+{
+    LogDB * logdb = Nebula::instance().get_logdb();
+
+    // Monitoring data is not replicated, each server keeps its own
+    std::set<std::string> local;
+
+    local.insert("host_monitoring");
+    local.insert("vm_monitoring");
+
+    return logdb->create_snapshot(file, raft_state_name, local, index, term,
+            fed_index);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 void RaftManager::replicate_failure(int follower_id)
 {
     std::map<int, uint64_t>::iterator next_it;
@@ -795,18 +889,22 @@ void RaftManager::timer_action(const ActionRequest& ar)
         mark_tics = 0;
     }
 
-    // Database housekeeping
-    if ( (purge_tics * timer_period_ms) >= purge_period_ms )
-    {
-        LogDB * logdb = nd.get_logdb();
+    // Database housekeeping, a purge step (chunk of the log) on each tic
+    LogDB * logdb = nd.get_logdb();
 
+    if ( logdb->is_purging() ||
+            (purge_tics * timer_period_ms) >= purge_period_ms )
+    {
         int rc = logdb->purge_log();
 
-        purge_tics = 0;
-
-        if (rc > 0 && purge_period_ms > 60000) //logs removed, wakeup in 60s
+        if ( !logdb->is_purging() )
         {
-            purge_tics = (int) ((purge_period_ms - 60000)/timer_period_ms);
+            purge_tics = 0;
+
+            if (rc > 0 && purge_period_ms > 60000) //logs removed, wakeup in 60s
+            {
+                purge_tics = (int) ((purge_period_ms - 60000)/timer_period_ms);
+            }
         }
     }
 
@@ -1043,19 +1141,308 @@ void RaftManager::request_vote()
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
-int RaftManager::xmlrpc_replicate_log(int follower_id, LogDBRecord * lr,
-		bool& success, unsigned int& fterm, std::string& error)
+/**
+ *  A single batch of records, for the heartbeats and single record calls
+ */
+class SingleBatch : public RaftManager::ReplicaBatches
+{
+public:
+    SingleBatch(const std::vector<LogDBRecord *>& _lrs):lrs(_lrs), sent(false)
+    {};
+
+    const std::vector<LogDBRecord *> * next_batch() override
+    {
+        if ( sent )
+        {
+            return 0;
+        }
+
+        sent = true;
+
+        return &lrs;
+    };
+
+    bool batch_result(const std::vector<LogDBRecord *>& _lrs,
+            const RaftManager::ReplicaResult& _rr) override
+    {
+        rr = _rr;
+
+        return true;
+    };
+
+    RaftManager::ReplicaResult rr;
+
+private:
+    const std::vector<LogDBRecord *>& lrs;
+
+    bool sent;
+};
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+/**
+ *  Replicate calls to a follower, one for each batch. SQL commands are sent
+ *  compressed, as stored in the log (SQL_ZLIB), if the follower supports it.
+ */
+class ReplicaCalls : public Client::CallSequence
+{
+public:
+    ReplicaCalls(RaftManager::ReplicaBatches& _batches, int _follower_id,
+            const std::string& _secret, int _server_id, uint64_t _commit,
+            unsigned int _term, int _version, time_t _wait_ms):
+        batches(_batches), follower_id(_follower_id), secret(_secret),
+        server_id(_server_id), commit(_commit), term(_term),
+        version(_version), wait_ms(_wait_ms), reported(-1), first(true)
+    {};
+
+    bool next_call(xmlrpc_c::paramList& plist) override;
+
+    bool reply(int rc, const xmlrpc_c::value& result,
+            const std::string& error) override;
+
+    /**
+     *  @return the version reported by the follower, -1 if not reported
+     */
+    int get_reported() const
+    {
+        return reported;
+    };
+
+private:
+    RaftManager::ReplicaBatches& batches;
+
+    int follower_id;
+
+    const std::string& secret;
+
+    int server_id;
+
+    uint64_t commit;
+
+    unsigned int term;
+
+    int version;
+
+    time_t wait_ms;
+
+    int reported;
+
+    bool first;
+
+    /**
+     *  Batches in flight, oldest first
+     */
+    std::deque<const std::vector<LogDBRecord *> *> inflight;
+};
+
+/* -------------------------------------------------------------------------- */
+
+bool ReplicaCalls::next_call(xmlrpc_c::paramList& plist)
+{
+    std::ostringstream ess;
+
+    std::string zsql;
+    std::string first_zsql;
+
+    vector<xmlrpc_c::value> batch;
+
+    std::vector<LogDBRecord *>::const_iterator jt;
+
+    const std::vector<LogDBRecord *> * lrs = batches.next_batch();
+
+    if ( lrs == 0 || lrs->empty() )
+    {
+        return false;
+    }
+
+    // Followers without batch support would ignore the extra records and
+    // store the compressed SQL commands as plain text
+    if ( version < 1 && lrs->size() > 1 )
+    {
+        ess << "Follower " << follower_id << " does not support batches";
+
+        NebulaLog::log("RCM", Log::ERROR, ess);
+
+        return false;
+    }
+
+    for ( jt = lrs->begin() ; jt != lrs->end() && version >= 1 ; ++jt )
+    {
+        if ( (*jt)->get_zsql(zsql) != 0 )
+        {
+            ess << "Error compressing log record " << (*jt)->index;
+
+            NebulaLog::log("RCM", Log::ERROR, ess);
+
+            return false;
+        }
+
+        if ( jt == lrs->begin() )
+        {
+            first_zsql = zsql;
+            continue;
+        }
+
+        vector<xmlrpc_c::value> record;
+
+        record.push_back(xmlrpc_c::value_i8((*jt)->index));
+        record.push_back(xmlrpc_c::value_int((*jt)->term));
+        record.push_back(xmlrpc_c::value_i8((*jt)->fed_index));
+        record.push_back(xmlrpc_c::value_string(zsql));
+
+        batch.push_back(xmlrpc_c::value_array(record));
+    }
+
+    LogDBRecord * lr = lrs->front();
+
+    plist.add(xmlrpc_c::value_string(secret));
+    plist.add(xmlrpc_c::value_int(server_id));
+    plist.add(xmlrpc_c::value_i8(commit));
+    plist.add(xmlrpc_c::value_int(term));
+    plist.add(xmlrpc_c::value_i8(lr->index));
+    plist.add(xmlrpc_c::value_int(lr->term));
+    plist.add(xmlrpc_c::value_i8(lr->prev_index));
+    plist.add(xmlrpc_c::value_int(lr->prev_term));
+    plist.add(xmlrpc_c::value_i8(lr->fed_index));
+
+    if ( version < 1 )
+    {
+        plist.add(xmlrpc_c::value_string(lr->sql));
+    }
+    else
+    {
+        plist.add(xmlrpc_c::value_string(first_zsql));
+        plist.add(xmlrpc_c::value_array(batch));
+        plist.add(xmlrpc_c::value_int(LogDBRecord::SQL_ZLIB));
+    }
+
+    // The previous batches may still be in flight, the follower waits for
+    // them before checking the previous record
+    if ( version >= 2 )
+    {
+        plist.add(xmlrpc_c::value_int(first ? 0 : wait_ms));
+    }
+
+    first = false;
+
+    inflight.push_back(lrs);
+
+    return true;
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool ReplicaCalls::reply(int rc, const xmlrpc_c::value& result,
+        const std::string& error)
+{
+    RaftManager::ReplicaResult rr;
+
+    const std::vector<LogDBRecord *> * lrs = inflight.front();
+
+    inflight.pop_front();
+
+    rr.rc = rc;
+
+    if ( rr.rc == 0 )
+    {
+        vector<xmlrpc_c::value> values;
+
+        values     = xmlrpc_c::value_array(result).vectorValueValue();
+        rr.success = xmlrpc_c::value_boolean(values[0]);
+
+        if ( rr.success ) //values[2] = error code (string)
+        {
+            rr.fterm = xmlrpc_c::value_int(values[1]);
+
+            // values[3] = replication version, not set by older servers
+            if ( values.size() > 3 )
+            {
+                reported = xmlrpc_c::value_int(values[3]);
+            }
+            else
+            {
+                reported = 0;
+            }
+        }
+        else
+        {
+            rr.error = xmlrpc_c::value_string(values[1]);
+            rr.fterm = xmlrpc_c::value_int(values[3]);
+        }
+    }
+    else
+    {
+        std::ostringstream ess;
+
+        ess << "Error replicating log entry " << lrs->front()->index
+            << " on follower " << follower_id << ": " << error;
+
+        rr.error = ess.str();
+    }
+
+    return batches.batch_result(*lrs, rr);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int RaftManager::xmlrpc_replicate_log(int follower_id,
+        const std::vector<LogDBRecord *>& lrs, bool& success,
+        unsigned int& fterm, std::string& error)
+{
+    SingleBatch batch(lrs);
+
+    xmlrpc_replicate_log(follower_id, batch);
+
+    success = batch.rr.success;
+    fterm   = batch.rr.fterm;
+    error   = batch.rr.error;
+
+    return batch.rr.rc;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+/**
+ *  Fails the first batch without calling the follower
+ */
+static void replicate_error(RaftManager::ReplicaBatches& batches,
+        const std::string& error)
+{
+    RaftManager::ReplicaResult rr;
+
+    const std::vector<LogDBRecord *> * lrs = batches.next_batch();
+
+    if ( lrs != 0 )
+    {
+        rr.error = error;
+
+        batches.batch_result(*lrs, rr);
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+int RaftManager::xmlrpc_replicate_log(int follower_id, ReplicaBatches& batches)
 {
 	int _server_id;
 	uint64_t _commit;
     unsigned int _term;
     std::string xmlrpc_secret;
+    std::string error;
 
     static const std::string replica_method = "one.zone.replicate";
 
     std::string follower_edp;
 
     std::map<int, std::string>::iterator it;
+    std::map<int, int>::iterator vit;
+
+    int version = 0;
+
+    unsigned int window = 1;
 
 	int xml_rc = 0;
 
@@ -1065,47 +1452,134 @@ int RaftManager::xmlrpc_replicate_log(int follower_id, LogDBRecord * lr,
 
     if ( it == servers.end() )
     {
-        error = "Cannot find follower end point";
         pthread_mutex_unlock(&mutex);
 
+        replicate_error(batches, "Cannot find follower end point");
+
         return -1;
     }
 
     follower_edp = it->second;
 
+    vit = versions.find(follower_id);
+
+    if ( vit != versions.end() )
+    {
+        version = vit->second;
+    }
+
+    // Followers process the calls of a window in order since version 2
+    if ( version >= 2 )
+    {
+        window = replica_window;
+    }
+
 	_commit    = commit;
     _term      = term;
 	_server_id = server_id;
 
 	pthread_mutex_unlock(&mutex);
 
+    if ( Client::get_oneauth(xmlrpc_secret, error) == -1 )
+    {
+        replicate_error(batches, error);
+
+        return -1;
+    }
+
     // -------------------------------------------------------------------------
-    // Get parameters to call append entries on follower
+    // Do the XML-RPC calls, up to the window in flight at the same time. The
+    // follower waits for the previous batches up to half the call timeout
+    // -------------------------------------------------------------------------
+    ReplicaCalls calls(batches, follower_id, xmlrpc_secret, _server_id,
+            _commit, _term, version, xmlrpc_timeout_ms / 2);
+
+    xml_rc = Client::call(follower_edp, replica_method, calls, window,
+            xmlrpc_timeout_ms, true);
+
+    if ( calls.get_reported() != -1 )
+    {
+        pthread_mutex_lock(&mutex);
+
+        vit = versions.find(follower_id);
+
+        if ( vit != versions.end() )
+        {
+            vit->second = calls.get_reported();
+        }
+
+        pthread_mutex_unlock(&mutex);
+    }
+
+    return xml_rc;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int RaftManager::xmlrpc_snapshot(int follower_id, uint64_t index,
+        unsigned int sterm, uint64_t fed_index, uint64_t offset,
+        const std::string& data, bool done, bool& success, unsigned int& ft,
+        std::string& error)
+{
+	int _server_id;
+    unsigned int _term;
+    std::string xmlrpc_secret;
+
+    static const std::string snapshot_method = "one.zone.snapshot";
+
+    std::string follower_edp;
+
+    std::map<int, std::string>::iterator it;
+
+	int xml_rc = 0;
+
+	pthread_mutex_lock(&mutex);
+
+    it = servers.find(follower_id);
+
+    if ( it == servers.end() )
+    {
+        error = "Cannot find follower end point";
+        pthread_mutex_unlock(&mutex);
+
+        return -1;
+    }
+
+    follower_edp = it->second;
+
+	_term      = term;
+	_server_id = server_id;
+
+	pthread_mutex_unlock(&mutex);
+
+    // -------------------------------------------------------------------------
+    // Get parameters to call snapshot on follower
     // -------------------------------------------------------------------------
     xmlrpc_c::value result;
-    xmlrpc_c::paramList replica_params;
+    xmlrpc_c::paramList snapshot_params;
 
-    if ( Client::read_oneauth(xmlrpc_secret, error) == -1 )
+    if ( Client::get_oneauth(xmlrpc_secret, error) == -1 )
     {
         return -1;
     }
 
-    replica_params.add(xmlrpc_c::value_string(xmlrpc_secret));
-    replica_params.add(xmlrpc_c::value_int(_server_id));
-    replica_params.add(xmlrpc_c::value_i8(_commit));
-    replica_params.add(xmlrpc_c::value_int(_term));
-    replica_params.add(xmlrpc_c::value_i8(lr->index));
-    replica_params.add(xmlrpc_c::value_int(lr->term));
-    replica_params.add(xmlrpc_c::value_i8(lr->prev_index));
-    replica_params.add(xmlrpc_c::value_int(lr->prev_term));
-    replica_params.add(xmlrpc_c::value_i8(lr->fed_index));
-    replica_params.add(xmlrpc_c::value_string(lr->sql));
+    snapshot_params.add(xmlrpc_c::value_string(xmlrpc_secret));
+    snapshot_params.add(xmlrpc_c::value_int(_server_id));
+    snapshot_params.add(xmlrpc_c::value_int(_term));
+    snapshot_params.add(xmlrpc_c::value_i8(index));
+    snapshot_params.add(xmlrpc_c::value_int(sterm));
+    snapshot_params.add(xmlrpc_c::value_i8(fed_index));
+    snapshot_params.add(xmlrpc_c::value_i8(offset));
+    snapshot_params.add(xmlrpc_c::value_string(data));
+    snapshot_params.add(xmlrpc_c::value_boolean(done));
 
     // -------------------------------------------------------------------------
-    // Do the XML-RPC call
+    // Do the XML-RPC call. Installing the snapshot may take long, the last
+    // call is not timed out
     // -------------------------------------------------------------------------
-    xml_rc = Client::call(follower_edp, replica_method, replica_params,
-            xmlrpc_timeout_ms, &result, error);
+    xml_rc = Client::call(follower_edp, snapshot_method, snapshot_params,
+        done ? 0 : xmlrpc_timeout_ms, &result, error, true);
 
     if ( xml_rc == 0 )
     {
@@ -1116,20 +1590,20 @@ int RaftManager::xmlrpc_replicate_log(int follower_id, LogDBRecord * lr,
 
         if ( success ) //values[2] = error code (string)
         {
-            fterm = xmlrpc_c::value_int(values[1]);
+            ft = xmlrpc_c::value_int(values[1]);
         }
         else
         {
             error = xmlrpc_c::value_string(values[1]);
-            fterm = xmlrpc_c::value_int(values[3]);
+            ft    = xmlrpc_c::value_int(values[3]);
         }
     }
     else
     {
         std::ostringstream ess;
 
-        ess << "Error replicating log entry " << lr->index << " on follower "
-            << follower_id << ": " << error;
+        ess << "Error sending snapshot to follower " << follower_id << ": "
+            << error;
 
         error = ess.str();
     }
@@ -1181,7 +1655,7 @@ int RaftManager::xmlrpc_request_vote(int follower_id, uint64_t lindex,
     xmlrpc_c::value result;
     xmlrpc_c::paramList replica_params;
 
-    if ( Client::read_oneauth(xmlrpc_secret, error) == -1 )
+    if ( Client::get_oneauth(xmlrpc_secret, error) == -1 )
     {
         return -1;
     }
@@ -1196,7 +1670,7 @@ int RaftManager::xmlrpc_request_vote(int follower_id, uint64_t lindex,
     // Do the XML-RPC call
     // -------------------------------------------------------------------------
     xml_rc = Client::call(follower_edp, replica_method, replica_params,
-        xmlrpc_timeout_ms, &result, error);
+        xmlrpc_timeout_ms, &result, error, true);
 
     if ( xml_rc == 0 )
     {
@@ -1283,6 +1757,29 @@ std::string& RaftManager::to_xml(std::string& raft_xml)
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+int RaftManager::get_replica_version(int follower_id)
+{
+    std::map<int, int>::iterator it;
+
+    int version = 0;
+
+    pthread_mutex_lock(&mutex);
+
+    it = versions.find(follower_id);
+
+    if ( it != versions.end() )
+    {
+        version = it->second;
+    }
+
+    pthread_mutex_unlock(&mutex);
+
+    return version;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 void RaftManager::reset_index(int follower_id)
 {
     std::map<int, uint64_t>::iterator next_it;
@@ -22,7 +22,11 @@
 #include "FedReplicaManager.h"
 
 #include <errno.h>
+#include <unistd.h>
 #include <string>
+#include <vector>
+#include <list>
+#include <fstream>
 
 // -----------------------------------------------------------------------------
 // -----------------------------------------------------------------------------
@@ -173,16 +177,237 @@ RaftReplicaThread::RaftReplicaThread(int fid):ReplicaThread(fid)
 // -----------------------------------------------------------------------------
 // -----------------------------------------------------------------------------
 
-int RaftReplicaThread::replicate()
+int RaftReplicaThread::load_batch(uint64_t index, uint64_t last_index,
+        unsigned int max_records, size_t max_size,
+        std::vector<LogDBRecord *>& lrs)
 {
-    std::string error;
+    size_t batch_size = 0;
 
-    LogDBRecord lr;
+    for (uint64_t i = index; i <= last_index || lrs.empty(); ++i)
+    {
+        if ( !lrs.empty() && ( lrs.size() >= max_records ||
+                    !raftm->is_replicable(i) ) )
+        {
+            break;
+        }
 
-    bool success = false;
+        LogDBRecord * lr = new LogDBRecord;
+
+        if ( logdb->get_log_record(i, *lr) != 0 )
+        {
+            delete lr;
+
+            if ( lrs.empty() )
+            {
+                return -1;
+            }
+
+            break;
+        }
+
+        if ( !lrs.empty() && batch_size + lr->zsql.size() > max_size )
+        {
+            delete lr;
+            break;
+        }
+
+        batch_size += lr->zsql.size();
+
+        lrs.push_back(lr);
+    }
+
+    return 0;
+}
+
+// -----------------------------------------------------------------------------
+// -----------------------------------------------------------------------------
+
+/**
+ *  Batches of records sent to a follower in a sliding window. The records are
+ *  loaded as the window advances, up to the last record in the log, and freed
+ *  once replied. next_index is advanced as each call is accepted.
+ */
+class RaftReplicaThread::ReplicaWindow : public RaftManager::ReplicaBatches
+{
+public:
+    ReplicaWindow(RaftReplicaThread * _rt, uint64_t _index, unsigned int _term,
+            unsigned int _max_records, size_t _max_size):rt(_rt), index(_index),
+        term(_term), max_records(_max_records), max_size(_max_size),
+        loaded(false), replied(false), rc(0){};
+
+    ~ReplicaWindow()
+    {
+        while ( !batches.empty() )
+        {
+            free_batch();
+        }
+    };
+
+    const std::vector<LogDBRecord *> * next_batch() override;
+
+    bool batch_result(const std::vector<LogDBRecord *>& lrs,
+            const RaftManager::ReplicaResult& rr) override;
+
+    /**
+     *  @return true if at least a batch has been loaded
+     */
+    bool is_loaded() const
+    {
+        return loaded;
+    };
+
+    /**
+     *  @return -1 if the first call failed because of a network error
+     */
+    int get_rc() const
+    {
+        return rc;
+    };
+
+private:
+    RaftReplicaThread * rt;
+
+    /**
+     *  Index of the next record to load
+     */
+    uint64_t index;
+
+    unsigned int term;
+
+    unsigned int max_records;
+
+    size_t max_size;
+
+    bool loaded;
+
+    bool replied;
+
+    int rc;
+
+    /**
+     *  Batches in flight, oldest first
+     */
+    std::list<std::vector<LogDBRecord *> > batches;
+
+    void free_batch()
+    {
+        std::vector<LogDBRecord *>::iterator it;
+
+        for ( it = batches.front().begin(); it != batches.front().end(); ++it )
+        {
+            delete *it;
+        }
+
+        batches.pop_front();
+    };
+};
+
+// -----------------------------------------------------------------------------
+
+const std::vector<LogDBRecord *> * RaftReplicaThread::ReplicaWindow::next_batch()
+{
+    unsigned int last_term;
+    uint64_t     last_index;
+
+    std::vector<LogDBRecord *> lrs;
+
+    rt->logdb->get_last_record_index(last_index, last_term);
+
+    // The first record is always sent, the following ones while ready
+    if ( loaded && (index > last_index || !rt->raftm->is_replicable(index)) )
+    {
+        return 0;
+    }
+
+    if ( rt->load_batch(index, last_index, max_records, max_size, lrs) != 0 )
+    {
+        return 0;
+    }
+
+    loaded = true;
+
+    index = lrs.back()->index + 1;
+
+    batches.push_back(lrs);
+
+    return &(batches.back());
+}
+
+// -----------------------------------------------------------------------------
+
+bool RaftReplicaThread::ReplicaWindow::batch_result(
+        const std::vector<LogDBRecord *>& lrs,
+        const RaftManager::ReplicaResult& rr)
+{
+    uint64_t first = lrs.front()->index;
+    uint64_t last  = lrs.back()->index;
+
+    bool is_first = !replied;
+
+    replied = true;
+
+    // Replies come in order, the batch is the oldest one in flight
+    free_batch();
+
+    if ( rr.rc != 0 )
+    {
+        std::ostringstream oss;
+
+        oss << "Faild to replicate log records at index: " << first
+            << " - " << last << " on follower: " << rt->follower_id
+            << ", error: " << rr.error;
+
+        NebulaLog::log("RCM", Log::DEBUG, oss);
 
-    unsigned int follower_term = -1;
+        if ( is_first )
+        {
+            rc = -1;
+        }
+        else
+        {
+            rt->add_request();
+        }
+
+        return false;
+    }
+
+    if ( rr.success )
+    {
+        rt->raftm->replicate_success(rt->follower_id, last);
+
+        return true;
+    }
 
+    if ( rr.fterm > term )
+    {
+        ostringstream ess;
+
+        ess << "Follower " << rt->follower_id << " term (" << rr.fterm
+            << ") is higher than current (" << term << ")";
+
+        NebulaLog::log("RCM", Log::INFO, ess);
+
+        rt->raftm->follower(rr.fterm);
+    }
+    else if ( is_first )
+    {
+        rt->raftm->replicate_failure(rt->follower_id);
+    }
+    else
+    {
+        // Previous calls were accepted but the follower could not order this
+        // one (e.g. wait timeout). Send it again from next_index
+        rt->add_request();
+    }
+
+    return false;
+}
+
+// -----------------------------------------------------------------------------
+// -----------------------------------------------------------------------------
+
+int RaftReplicaThread::replicate()
+{
     unsigned int term  = raftm->get_term();
 
     uint64_t next_index = raftm->get_next_index(follower_id);
@@ -198,55 +423,148 @@ int RaftReplicaThread::replicate()
         return -1;
     }
 
+    unsigned int max_records;
+    size_t       max_size;
 
-    if ( logdb->get_log_record(next_index, lr) != 0 )
+    raftm->get_batch_limits(max_records, max_size);
+
+    // Followers without batch support get one record per call
+    if ( raftm->get_replica_version(follower_id) < 1 )
     {
-        ostringstream ess;
+        max_records = 1;
+    }
 
-        ess << "Failed to load log record at index: " << next_index;
+    // -------------------------------------------------------------------------
+    // Send the records in batches, with up to the replica window calls in
+    // flight. Each reply advances next_index, a failure stops the window
+    // -------------------------------------------------------------------------
+    ReplicaWindow batches(this, next_index, term, max_records, max_size);
 
-        NebulaLog::log("RCM", Log::ERROR, ess);
+    raftm->xmlrpc_replicate_log(follower_id, batches);
 
-        return -1;
+    if ( batches.is_loaded() )
+    {
+        return batches.get_rc();
     }
 
-    if ( raftm->xmlrpc_replicate_log(follower_id, &lr, success, follower_term,
-                error) != 0 )
+    if ( next_index < logdb->get_first_index() )
     {
-        std::ostringstream oss;
+        // The records needed by the follower are no longer in the log
+        return send_snapshot();
+    }
 
-        oss << "Faild to replicate log record at index: " << next_index
-            << " on follower: " << follower_id << ", error: " << error;
+    ostringstream ess;
 
-        NebulaLog::log("RCM", Log::DEBUG, oss);
+    ess << "Failed to load log record at index: " << next_index;
 
-        return -1;
-    }
+    NebulaLog::log("RCM", Log::ERROR, ess);
 
-    if ( success )
+    return -1;
+}
+
+// -----------------------------------------------------------------------------
+// -----------------------------------------------------------------------------
+
+int RaftReplicaThread::send_snapshot()
+{
+    std::ostringstream oss;
+
+    unsigned int max_records;
+    size_t       max_size;
+
+    uint64_t     index;
+    unsigned int sterm;
+    uint64_t     fed_index;
+
+    unsigned int term = raftm->get_term();
+
+    oss << Nebula::instance().get_var_location() << "raft_snapshot."
+        << follower_id;
+
+    std::string file = oss.str();
+
+    if ( raftm->create_snapshot(file, index, sterm, fed_index) != 0 )
     {
-        raftm->replicate_success(follower_id);
+        unlink(file.c_str());
+        return -1;
     }
-    else
+
+    oss.str("");
+
+    oss << "Sending snapshot at log index " << index << " to follower "
+        << follower_id;
+
+    NebulaLog::log("RCM", Log::INFO, oss);
+
+    raftm->get_batch_limits(max_records, max_size);
+
+    std::ifstream in(file.c_str(), std::ios::in | std::ios::binary);
+
+    std::vector<char> buffer(max_size);
+
+    uint64_t offset = 0;
+
+    int rc = in.good() ? 0 : -1;
+
+    while ( rc == 0 )
     {
-        if ( follower_term > term )
+        in.read(&buffer[0], max_size);
+
+        std::string chunk(&buffer[0], in.gcount());
+
+        bool done = in.eof();
+
+        bool success = false;
+        unsigned int fterm = 0;
+        std::string error;
+
+        std::string * data = one_util::zlib_compress(chunk, true);
+
+        if ( data == 0 )
         {
-            ostringstream ess;
+            rc = -1;
+            break;
+        }
 
-            ess << "Follower " << follower_id << " term (" << follower_term
-                << ") is higher than current (" << term << ")";
+        rc = raftm->xmlrpc_snapshot(follower_id, index, sterm, fed_index,
+                offset, *data, done, success, fterm, error);
 
-            NebulaLog::log("RCM", Log::INFO, ess);
+        delete data;
 
-            raftm->follower(follower_term);
+        if ( rc != 0 )
+        {
+            NebulaLog::log("RCM", Log::DEBUG, error);
         }
-        else
+        else if ( !success )
         {
-            raftm->replicate_failure(follower_id);
+            if ( fterm > term )
+            {
+                raftm->follower(fterm);
+            }
+
+            oss.str("");
+
+            oss << "Follower " << follower_id << " failed to receive snapshot"
+                << ", error: " << error;
+
+            NebulaLog::log("RCM", Log::ERROR, oss);
+
+            rc = -1;
+        }
+        else if ( done )
+        {
+            raftm->snapshot_success(follower_id, index);
+            break;
         }
+
+        offset += chunk.size();
     }
 
-    return 0;
+    in.close();
+
+    unlink(file.c_str());
+
+    return rc;
 }
 
 // -----------------------------------------------------------------------------
@@ -413,8 +413,10 @@ void Request::execute(
             return;
         }
 
+        // Forwarded calls do not use the pool, the connections to the
+        // leader are bounded by the xml-rpc server threads (MAX_CONN)
         int rc = Client::call(leader_endpoint, method_name, _paramList,
-                xmlrpc_timeout, _retval, att.resp_msg);
+                xmlrpc_timeout, _retval, att.resp_msg, false);
 
         if ( rc != 0 )
         {
@@ -484,14 +486,13 @@ Request::ErrorCode Request::basic_authorization(
         PoolObjectSQL::ObjectType auth_object,
         RequestAttributes&      att)
 {
-    PoolObjectSQL * object;
     PoolObjectAuth  perms;
 
     if ( oid >= 0 )
     {
-        object = pool->get(oid);
+        std::shared_ptr<const PoolObjectSQL> object = pool->get_ro_shared(oid);
 
-        if ( object == 0 )
+        if ( !object )
         {
             att.resp_id = oid;
 
@@ -499,8 +500,6 @@ Request::ErrorCode Request::basic_authorization(
         }
 
         object->get_permissions(perms);
-
-        object->unlock();
     }
     else
     {
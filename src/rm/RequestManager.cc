@@ -365,6 +365,7 @@ void RequestManager::register_xml_methods()
 
     // VirtualMachine Methods
     xmlrpc_c::methodPtr vm_deploy(new VirtualMachineDeploy());
+    xmlrpc_c::methodPtr vm_deploy_multi(new VirtualMachineDeployMulti());
     xmlrpc_c::methodPtr vm_migrate(new VirtualMachineMigrate());
     xmlrpc_c::methodPtr vm_action(new VirtualMachineAction());
     xmlrpc_c::methodPtr vm_monitoring(new VirtualMachineMonitoring());
@@ -501,6 +502,12 @@ void RequestManager::register_xml_methods()
     xmlrpc_c::methodPtr vrouter_pool_info(new VirtualRouterPoolInfo());
     xmlrpc_c::methodPtr hookpool_info(new HookPoolInfo());
 
+    xmlrpc_c::methodPtr hostpool_delta(new HostPoolInfoDelta());
+    xmlrpc_c::methodPtr datastorepool_delta(new DatastorePoolInfoDelta());
+    xmlrpc_c::methodPtr vm_pool_delta(new VirtualMachinePoolInfoDelta());
+    xmlrpc_c::methodPtr vnpool_delta(new VirtualNetworkPoolInfoDelta());
+    xmlrpc_c::methodPtr clusterpool_delta(new ClusterPoolInfoDelta());
+
     // Host Methods
     xmlrpc_c::methodPtr host_status(new HostStatus());
     xmlrpc_c::methodPtr host_monitoring(new HostMonitoring());
@@ -587,6 +594,7 @@ void RequestManager::register_xml_methods()
 
     /* VM related methods  */
     RequestManagerRegistry.addMethod("one.vm.deploy", vm_deploy);
+    RequestManagerRegistry.addMethod("one.vm.deploymulti", vm_deploy_multi);
     RequestManagerRegistry.addMethod("one.vm.action", vm_action);
     RequestManagerRegistry.addMethod("one.vm.migrate", vm_migrate);
     RequestManagerRegistry.addMethod("one.vm.allocate", vm_allocate);
@@ -617,6 +625,7 @@ void RequestManager::register_xml_methods()
 
     RequestManagerRegistry.addMethod("one.vmpool.info", vm_pool_info);
     RequestManagerRegistry.addMethod("one.vmpool.infoextended", vm_pool_info_extended);
+    RequestManagerRegistry.addMethod("one.vmpool.infodelta", vm_pool_delta);
     RequestManagerRegistry.addMethod("one.vmpool.accounting", vm_pool_acct);
     RequestManagerRegistry.addMethod("one.vmpool.monitoring", vm_pool_monitoring);
     RequestManagerRegistry.addMethod("one.vmpool.showback", vm_pool_showback);
@@ -660,6 +669,7 @@ void RequestManager::register_xml_methods()
     RequestManagerRegistry.addMethod("one.host.rename", host_rename);
 
     RequestManagerRegistry.addMethod("one.hostpool.info", hostpool_info);
+    RequestManagerRegistry.addMethod("one.hostpool.infodelta", hostpool_delta);
     RequestManagerRegistry.addMethod("one.hostpool.monitoring", host_pool_monitoring);
 
     /* Group related methods */
@@ -731,6 +741,7 @@ void RequestManager::register_xml_methods()
     RequestManagerRegistry.addMethod("one.vn.unlock", vn_unlock);
 
     RequestManagerRegistry.addMethod("one.vnpool.info", vnpool_info);
+    RequestManagerRegistry.addMethod("one.vnpool.infodelta", vnpool_delta);
 
     /* User related methods*/
 
@@ -786,6 +797,7 @@ void RequestManager::register_xml_methods()
     xmlrpc_c::methodPtr user_info(new UserInfo());
     xmlrpc_c::methodPtr user_set_quota(new UserSetQuota());
     xmlrpc_c::methodPtr userpool_info(new UserPoolInfo());
+    xmlrpc_c::methodPtr userpool_delta(new UserPoolInfoDelta());
     xmlrpc_c::methodPtr user_get_default_quota(new UserQuotaInfo());
     xmlrpc_c::methodPtr user_set_default_quota(new UserQuotaUpdate());
 
@@ -802,6 +814,7 @@ void RequestManager::register_xml_methods()
     RequestManagerRegistry.addMethod("one.user.login", user_login);
 
     RequestManagerRegistry.addMethod("one.userpool.info", userpool_info);
+    RequestManagerRegistry.addMethod("one.userpool.infodelta", userpool_delta);
 
     RequestManagerRegistry.addMethod("one.userquota.info", user_get_default_quota);
     RequestManagerRegistry.addMethod("one.userquota.update", user_set_default_quota);
@@ -862,6 +875,7 @@ void RequestManager::register_xml_methods()
     RequestManagerRegistry.addMethod("one.datastore.enable",  datastore_enable);
 
     RequestManagerRegistry.addMethod("one.datastorepool.info",datastorepool_info);
+    RequestManagerRegistry.addMethod("one.datastorepool.infodelta",datastorepool_delta);
 
     /* Cluster related methods */
     RequestManagerRegistry.addMethod("one.cluster.allocate",cluster_allocate);
@@ -878,6 +892,7 @@ void RequestManager::register_xml_methods()
     RequestManagerRegistry.addMethod("one.cluster.delvnet", cluster_delvnet);
 
     RequestManagerRegistry.addMethod("one.clusterpool.info",clusterpool_info);
+    RequestManagerRegistry.addMethod("one.clusterpool.infodelta",clusterpool_delta);
 
     /* Generic Document objects related methods*/
     RequestManagerRegistry.addMethod("one.document.allocate",doc_allocate);
@@ -927,6 +942,7 @@ void RequestManager::register_xml_methods()
     xmlrpc_c::methodPtr zone_delserver(new ZoneDeleteServer());
     xmlrpc_c::methodPtr zone_resetserver(new ZoneResetServer());
     xmlrpc_c::methodPtr zone_replicatelog(new ZoneReplicateLog());
+    xmlrpc_c::methodPtr zone_snapshot(new ZoneSnapshot());
     xmlrpc_c::methodPtr zone_voterequest(new ZoneVoteRequest());
     xmlrpc_c::methodPtr zone_raftstatus(new ZoneRaftStatus());
     xmlrpc_c::methodPtr zone_fedreplicatelog(new ZoneReplicateFedLog());
@@ -940,6 +956,7 @@ void RequestManager::register_xml_methods()
     RequestManagerRegistry.addMethod("one.zone.info",     zone_info);
     RequestManagerRegistry.addMethod("one.zone.rename",   zone_rename);
     RequestManagerRegistry.addMethod("one.zone.replicate",zone_replicatelog);
+    RequestManagerRegistry.addMethod("one.zone.snapshot",zone_snapshot);
     RequestManagerRegistry.addMethod("one.zone.fedreplicate",zone_fedreplicatelog);
     RequestManagerRegistry.addMethod("one.zone.voterequest",zone_voterequest);
     RequestManagerRegistry.addMethod("one.zone.raftstatus", zone_raftstatus);
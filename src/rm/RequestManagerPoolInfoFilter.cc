@@ -1075,4 +1075,203 @@ void HookLogInfo::request_execute(xmlrpc_c::paramList const& _paramList,
     success_response(dump_xml, att);
 
     return;
-}
\ No newline at end of file
+}
+
+/* ------------------------------------------------------------------------- */
+/* ------------------------------------------------------------------------- */
+/* ------------------------------------------------------------------------- */
+
+void RequestManagerPoolInfoDelta::request_execute(
+        xmlrpc_c::paramList const& paramList,
+        RequestAttributes& att)
+{
+    string version = xmlrpc_c::value_string(paramList.getString(1));
+
+    vector<int> oids;
+
+    string where_string;
+    string pool_str;
+
+    ostringstream oss;
+
+    int rc = 0;
+
+    // The version is read before the dump, objects changed in the meantime
+    // are included again in the next delta
+    bool full = pool->get_changes(version, oids) != 0 ||
+                oids.size() > MAX_DELTA_OIDS;
+
+    if ( full )
+    {
+        oids.clear();
+
+        delta_filter(att, and_clause, where_string);
+    }
+    else if ( !oids.empty() )
+    {
+        ostringstream and_oids;
+
+        if (!and_clause.empty())
+        {
+            and_oids << "(" << and_clause << ") AND ";
+        }
+
+        and_oids << "oid IN (";
+
+        for (auto it = oids.begin(); it != oids.end(); ++it)
+        {
+            if ( it != oids.begin() )
+            {
+                and_oids << ",";
+            }
+
+            and_oids << *it;
+        }
+
+        and_oids << ")";
+
+        delta_filter(att, and_oids.str(), where_string);
+    }
+
+    if ( full || !oids.empty() )
+    {
+        if ( extended )
+        {
+            rc = pool->dump_extended(pool_str, where_string, "", false);
+        }
+        else
+        {
+            rc = pool->dump(pool_str, where_string, "", false);
+        }
+    }
+
+    if ( rc != 0 )
+    {
+        att.resp_msg = "Internal error";
+        failure_response(INTERNAL, att);
+        return;
+    }
+
+    oss << "<POOL_DELTA>"
+        << "<VERSION>" << version << "</VERSION>"
+        << "<FULL>" << full << "</FULL>"
+        << "<CHANGED>";
+
+    for (auto it = oids.begin(); it != oids.end(); ++it)
+    {
+        oss << "<ID>" << *it << "</ID>";
+    }
+
+    oss << "</CHANGED>"
+        << pool_str
+        << "</POOL_DELTA>";
+
+    success_response(oss.str(), att);
+
+    return;
+}
+
+/* ------------------------------------------------------------------------- */
+/* ------------------------------------------------------------------------- */
+
+VirtualMachinePoolInfoDelta::VirtualMachinePoolInfoDelta()
+    : RequestManagerPoolInfoDelta("one.vmpool.infodelta",
+            "Returns the changes of the virtual machine pool (not DONE)")
+{
+    Nebula& nd  = Nebula::instance();
+    pool        = nd.get_vmpool();
+    auth_object = PoolObjectSQL::VM;
+
+    extended = true;
+
+    ostringstream oss;
+
+    oss << "state <> " << VirtualMachine::DONE;
+
+    and_clause = oss.str();
+}
+
+/* ------------------------------------------------------------------------- */
+/* ------------------------------------------------------------------------- */
+
+HostPoolInfoDelta::HostPoolInfoDelta()
+    : RequestManagerPoolInfoDelta("one.hostpool.infodelta",
+            "Returns the changes of the host pool")
+{
+    Nebula& nd  = Nebula::instance();
+    pool        = nd.get_hpool();
+    auth_object = PoolObjectSQL::HOST;
+}
+
+/* ------------------------------------------------------------------------- */
+/* ------------------------------------------------------------------------- */
+
+DatastorePoolInfoDelta::DatastorePoolInfoDelta()
+    : RequestManagerPoolInfoDelta("one.datastorepool.infodelta",
+            "Returns the changes of the datastore pool")
+{
+    Nebula& nd  = Nebula::instance();
+    pool        = nd.get_dspool();
+    auth_object = PoolObjectSQL::DATASTORE;
+}
+
+/* ------------------------------------------------------------------------- */
+/* ------------------------------------------------------------------------- */
+
+VirtualNetworkPoolInfoDelta::VirtualNetworkPoolInfoDelta()
+    : RequestManagerPoolInfoDelta("one.vnpool.infodelta",
+            "Returns the changes of the virtual network pool")
+{
+    Nebula& nd  = Nebula::instance();
+    pool        = nd.get_vnpool();
+    auth_object = PoolObjectSQL::NET;
+}
+
+/* ------------------------------------------------------------------------- */
+
+void VirtualNetworkPoolInfoDelta::delta_filter(RequestAttributes& att,
+        const string& and_clause, string& where_string)
+{
+    // Same filters as VirtualNetworkPoolInfo for vnets and reservations
+    string where_vnets, where_reserv;
+    string and_vnets  = "pid = -1";
+    string and_reserv = "pid != -1";
+
+    if (!and_clause.empty())
+    {
+        and_vnets  += " AND " + and_clause;
+        and_reserv += " AND " + and_clause;
+    }
+
+    where_filter(att, ALL, -1, -1, and_vnets, "", false, false, false,
+        where_vnets);
+
+    where_filter(att, ALL, -1, -1, and_reserv, "", true, true, false,
+        where_reserv);
+
+    where_string = "( " + where_vnets + " ) OR ( " + where_reserv + " ) ";
+}
+
+/* ------------------------------------------------------------------------- */
+/* ------------------------------------------------------------------------- */
+
+UserPoolInfoDelta::UserPoolInfoDelta()
+    : RequestManagerPoolInfoDelta("one.userpool.infodelta",
+            "Returns the changes of the user pool")
+{
+    Nebula& nd  = Nebula::instance();
+    pool        = nd.get_upool();
+    auth_object = PoolObjectSQL::USER;
+}
+
+/* ------------------------------------------------------------------------- */
+/* ------------------------------------------------------------------------- */
+
+ClusterPoolInfoDelta::ClusterPoolInfoDelta()
+    : RequestManagerPoolInfoDelta("one.clusterpool.infodelta",
+            "Returns the changes of the cluster pool")
+{
+    Nebula& nd  = Nebula::instance();
+    pool        = nd.get_clpool();
+    auth_object = PoolObjectSQL::CLUSTER;
+}
@@ -1432,6 +1432,178 @@ void VirtualMachineMigrate::request_execute(xmlrpc_c::paramList const& paramList
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+void VirtualMachineDeployMulti::request_execute(
+        xmlrpc_c::paramList const& paramList, RequestAttributes& att)
+{
+    struct DeployArgs
+    {
+        int    vid;
+        int    hid;
+        int    ds_id;
+        string extra;
+        bool   migrate;
+        bool   live;
+        bool   clear;
+    };
+
+    vector<DeployArgs> dargs;
+
+    // ------------------------------------------------------------------------
+    // Parse the whole list before dispatching any VM
+    // ------------------------------------------------------------------------
+    try
+    {
+        vector<xmlrpc_c::value> vms = xmlrpc_c::value_array(
+                paramList.getArray(1)).vectorValueValue();
+
+        for (auto it = vms.begin(); it != vms.end(); ++it)
+        {
+            vector<xmlrpc_c::value> vm_args =
+                xmlrpc_c::value_array(*it).vectorValueValue();
+
+            if ( vm_args.size() < 3 )
+            {
+                att.resp_msg = "Wrong number of arguments for a VM";
+                failure_response(XML_RPC_API, att);
+
+                return;
+            }
+
+            DeployArgs da;
+
+            da.vid     = xmlrpc_c::value_int(vm_args[0]);
+            da.hid     = xmlrpc_c::value_int(vm_args[1]);
+            da.ds_id   = xmlrpc_c::value_int(vm_args[2]);
+            da.migrate = false;
+            da.live    = false;
+            da.clear   = false;
+
+            if ( vm_args.size() > 3 )
+            {
+                da.extra = xmlrpc_c::value_string(vm_args[3]);
+            }
+
+            if ( vm_args.size() > 4 )
+            {
+                da.migrate = xmlrpc_c::value_boolean(vm_args[4]);
+            }
+
+            if ( vm_args.size() > 5 )
+            {
+                da.live = xmlrpc_c::value_boolean(vm_args[5]);
+            }
+
+            if ( vm_args.size() > 6 )
+            {
+                da.clear = xmlrpc_c::value_boolean(vm_args[6]);
+            }
+
+            dargs.push_back(da);
+        }
+    }
+    catch (exception const& e)
+    {
+        att.resp_msg = string("Wrong VM list: ") + e.what();
+        failure_response(XML_RPC_API, att);
+
+        return;
+    }
+
+    // ------------------------------------------------------------------------
+    // Dispatch the VMs with one.vm.deploy or one.vm.migrate. The auth
+    // operation is computed once for each request type
+    // ------------------------------------------------------------------------
+    RequestAttributes deploy_att(att);
+    RequestAttributes migrate_att(att);
+
+    migrate_att.auth_op = AuthRequest::MANAGE;
+    migrate_att.set_auth_op(VMActions::MIGRATE_ACTION);
+
+    ostringstream oss;
+
+    oss << "<DEPLOY_RESULTS>";
+
+    for (auto it = dargs.begin(); it != dargs.end(); ++it)
+    {
+        xmlrpc_c::paramList pl;
+        xmlrpc_c::value     result;
+
+        pl.add(xmlrpc_c::value_string(att.session));
+        pl.add(xmlrpc_c::value_int(it->vid));
+        pl.add(xmlrpc_c::value_int(it->hid));
+
+        if ( it->migrate )
+        {
+            RequestAttributes vm_att(migrate_att);
+
+            vm_att.retval = &result;
+
+            pl.add(xmlrpc_c::value_boolean(it->live));
+            pl.add(xmlrpc_c::value_boolean(false));
+
+            migrate.request_execute(pl, vm_att);
+        }
+        else
+        {
+            RequestAttributes vm_att(deploy_att);
+
+            vm_att.retval = &result;
+
+            pl.add(xmlrpc_c::value_boolean(false));
+            pl.add(xmlrpc_c::value_int(it->ds_id));
+            pl.add(xmlrpc_c::value_string(it->extra));
+
+            deploy.request_execute(pl, vm_att);
+        }
+
+        vector<xmlrpc_c::value> values =
+            xmlrpc_c::value_array(result).vectorValueValue();
+
+        bool success = xmlrpc_c::value_boolean(values[0]);
+
+        oss << "<VM>"
+            << "<ID>" << it->vid << "</ID>"
+            << "<SUCCESS>" << success << "</SUCCESS>";
+
+        if ( success )
+        {
+            oss << "<ERROR/>";
+        }
+        else
+        {
+            string error = xmlrpc_c::value_string(values[1]);
+
+            oss << "<ERROR>" << one_util::escape_xml(error) << "</ERROR>";
+        }
+
+        oss << "</VM>";
+
+        if ( !success || !it->clear )
+        {
+            continue;
+        }
+
+        VirtualMachine * vm = static_cast<VirtualMachinePool *>(pool)->get(
+                it->vid);
+
+        if ( vm != nullptr )
+        {
+            vm->remove_user_template_attribute("SCHED_MESSAGE");
+
+            static_cast<VirtualMachinePool *>(pool)->update(vm);
+
+            vm->unlock();
+        }
+    }
+
+    oss << "</DEPLOY_RESULTS>";
+
+    success_response(oss.str(), att);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 void VirtualMachineDiskSaveas::request_execute(
         xmlrpc_c::paramList const& paramList, RequestAttributes& att)
 {
@@ -21,6 +21,9 @@
 #include "FedReplicaManager.h"
 #include "RaftManager.h"
 
+#include <fstream>
+#include <unistd.h>
+
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
@@ -292,6 +295,95 @@ void ZoneResetServer::request_execute(xmlrpc_c::paramList const& paramList,
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+/**
+ *  Adds the records of a batched replicate call (optional parameter 10) to
+ *  the batch. Each record is an array [index, term, fed_index, sql] and follows
+ *  the last one in the batch.
+ *    @param paramList of the replicate call
+ *    @param lrs the batch, it includes the first record of the call
+ *    @param error describing the error if any
+ *    @return 0 on success, -1 otherwise
+ */
+static int add_log_batch(xmlrpc_c::paramList const& paramList, int format,
+        std::vector<LogDBRecord *>& lrs, std::string& error)
+{
+    if ( paramList.size() <= 10 )
+    {
+        return 0;
+    }
+
+    try
+    {
+        vector<xmlrpc_c::value> batch = xmlrpc_c::value_array(
+                paramList.getArray(10)).vectorValueValue();
+
+        vector<xmlrpc_c::value>::iterator it;
+
+        for ( it = batch.begin() ; it != batch.end() ; ++it )
+        {
+            vector<xmlrpc_c::value> record =
+                xmlrpc_c::value_array(*it).vectorValueValue();
+
+            if ( record.size() < 4 )
+            {
+                error = "Wrong number of attributes for a log record";
+                return -1;
+            }
+
+            LogDBRecord * lr = new LogDBRecord;
+
+            lr->index      = xmlrpc_c::value_i8(record[0]);
+            lr->term       = xmlrpc_c::value_int(record[1]);
+            lr->fed_index  = xmlrpc_c::value_i8(record[2]);
+            lr->timestamp  = 0;
+            lr->prev_index = lrs.back()->index;
+            lr->prev_term  = lrs.back()->term;
+
+            lrs.push_back(lr);
+
+            if ( lr->set_sql(xmlrpc_c::value_string(record[3]), format) != 0 )
+            {
+                error = "Wrong SQL command format in log record";
+                return -1;
+            }
+
+            if ( lr->index != lr->prev_index + 1 )
+            {
+                error = "Log records in batch are not consecutive";
+                return -1;
+            }
+
+            if ( lr->sql.empty() )
+            {
+                error = "Empty SQL command in log record";
+                return -1;
+            }
+        }
+    }
+    catch (exception const& e)
+    {
+        error = string("Wrong log record batch: ") + e.what();
+        return -1;
+    }
+
+    return 0;
+}
+
+static void free_log_batch(std::vector<LogDBRecord *>& lrs)
+{
+    std::vector<LogDBRecord *>::iterator it;
+
+    for ( it = lrs.begin() ; it != lrs.end() ; ++it )
+    {
+        delete *it;
+    }
+
+    lrs.clear();
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 void ZoneReplicateLog::request_execute(xmlrpc_c::paramList const& paramList,
     RequestAttributes& att)
 {
@@ -312,9 +404,25 @@ void ZoneReplicateLog::request_execute(xmlrpc_c::paramList const& paramList,
 
     string sql = xmlrpc_c::value_string(paramList.getString(9));
 
+    // SQL commands format (LogDBRecord::SqlFormat), plain text if not set
+    int format = LogDBRecord::SQL_PLAIN;
+
+    if ( paramList.size() > 11 )
+    {
+        format = xmlrpc_c::value_int(paramList.getInt(11));
+    }
+
+    // Max time (ms) to wait for the previous record, sent in the same window
+    time_t wait_ms = 0;
+
+    if ( paramList.size() > 12 )
+    {
+        wait_ms = xmlrpc_c::value_int(paramList.getInt(12));
+    }
+
     unsigned int current_term = raftm->get_term();
 
-    LogDBRecord lr, prev_lr;
+    unsigned int lterm;
 
     if (!att.is_oneadmin())
     {
@@ -382,7 +490,7 @@ void ZoneReplicateLog::request_execute(xmlrpc_c::paramList const& paramList,
 
         logdb->apply_log_records(new_commit);
 
-        success_response(static_cast<int>(current_term), att);
+        replica_response(current_term, att);
         return;
     }
 
@@ -390,7 +498,7 @@ void ZoneReplicateLog::request_execute(xmlrpc_c::paramList const& paramList,
     // REPLICATE
     //   0. Check it is a valid record (prevent spurious entries)
     //   1. Check log consistency (index, and previous index match)
-    //   2. Insert record in the log
+    //   2. Insert records in the log, a batch is written in one transaction
     //   3. Apply log records that can be safely applied
     //--------------------------------------------------------------------------
     if ( sql.empty() )
@@ -404,7 +512,14 @@ void ZoneReplicateLog::request_execute(xmlrpc_c::paramList const& paramList,
 
     if ( index > 0 )
     {
-        if ( logdb->get_log_record(prev_index, prev_lr) != 0 )
+        // Calls of the same window may arrive out of order, wait for the
+        // previous ones to be written
+        if ( wait_ms > 0 )
+        {
+            logdb->wait_log_record(prev_index, wait_ms);
+        }
+
+        if ( logdb->get_log_term(prev_index, lterm) != 0 )
         {
             att.resp_msg = "Error loading previous log record";
             att.resp_id  = current_term;
@@ -413,7 +528,7 @@ void ZoneReplicateLog::request_execute(xmlrpc_c::paramList const& paramList,
             return;
         }
 
-        if ( prev_lr.term != prev_term )
+        if ( lterm != prev_term )
         {
             att.resp_msg = "Previous log record missmatch";
             att.resp_id  = current_term;
@@ -423,22 +538,67 @@ void ZoneReplicateLog::request_execute(xmlrpc_c::paramList const& paramList,
         }
     }
 
-    if ( logdb->get_log_record(index, lr) == 0 )
+    std::vector<LogDBRecord *> lrs;
+
+    LogDBRecord * first = new LogDBRecord;
+
+    first->index      = index;
+    first->term       = term;
+    first->prev_index = prev_index;
+    first->prev_term  = prev_term;
+    first->timestamp  = 0;
+    first->fed_index  = fed_index;
+
+    lrs.push_back(first);
+
+    int rc = first->set_sql(sql, format);
+
+    if ( rc != 0 )
+    {
+        att.resp_msg = "Wrong SQL command format in log record";
+    }
+    else
+    {
+        rc = add_log_batch(paramList, format, lrs, att.resp_msg);
+    }
+
+    if ( rc != 0 )
     {
-        if ( lr.term != term )
+        free_log_batch(lrs);
+
+        att.resp_id = current_term;
+
+        failure_response(ACTION, att);
+        return;
+    }
+
+    // Skip records already in the log (same index and term), remove the log
+    // from the first conflicting one
+    std::vector<LogDBRecord *>::iterator it;
+
+    for ( it = lrs.begin() ; it != lrs.end() ; ++it )
+    {
+        if ( logdb->get_log_term((*it)->index, lterm) != 0 )
         {
-            logdb->delete_log_records(index);
+            break;
         }
-        else //Already a log record with same index and term
+
+        if ( lterm != (*it)->term )
         {
-            success_response(static_cast<int>(current_term), att);
-            return;
+            logdb->delete_log_records((*it)->index);
+            break;
         }
     }
 
-    ostringstream sql_oss(sql);
+    std::vector<LogDBRecord *> new_lrs(it, lrs.end());
+
+    uint64_t last_index = lrs.back()->index;
+
+    rc = logdb->insert_log_records(new_lrs);
+
+    free_log_batch(lrs);
 
-    if (logdb->insert_log_record(index, term, sql_oss, 0, fed_index, true) != 0)
+    if ( rc != 0 )
     {
         att.resp_msg = "Error writing log record";
         att.resp_id  = current_term;
@@ -447,10 +607,181 @@ void ZoneReplicateLog::request_execute(xmlrpc_c::paramList const& paramList,
         return;
     }
 
-    uint64_t new_commit = raftm->update_commit(leader_commit, index);
+    uint64_t new_commit = raftm->update_commit(leader_commit, last_index);
 
     logdb->apply_log_records(new_commit);
 
+    replica_response(current_term, att);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void ZoneReplicateLog::replica_response(unsigned int term,
+        RequestAttributes& att)
+{
+    success_response(static_cast<int>(term), att);
+
+    vector<xmlrpc_c::value> values =
+        xmlrpc_c::value_array(*(att.retval)).vectorValueValue();
+
+    values.push_back(xmlrpc_c::value_int(RaftManager::REPLICA_VERSION));
+
+    *(att.retval) = xmlrpc_c::value_array(values);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void ZoneSnapshot::request_execute(xmlrpc_c::paramList const& paramList,
+    RequestAttributes& att)
+{
+    Nebula& nd    = Nebula::instance();
+    LogDB * logdb = nd.get_logdb();
+
+    RaftManager * raftm = nd.get_raftm();
+
+    int leader_id            = xmlrpc_c::value_int(paramList.getInt(1));
+    unsigned int leader_term = xmlrpc_c::value_int(paramList.getInt(2));
+
+    uint64_t index       = xmlrpc_c::value_i8(paramList.getI8(3));
+    unsigned int term    = xmlrpc_c::value_int(paramList.getInt(4));
+    uint64_t fed_index   = xmlrpc_c::value_i8(paramList.getI8(5));
+    uint64_t offset      = xmlrpc_c::value_i8(paramList.getI8(6));
+
+    string data = xmlrpc_c::value_string(paramList.getString(7));
+    bool   done = xmlrpc_c::value_boolean(paramList.getBoolean(8));
+
+    unsigned int current_term = raftm->get_term();
+
+    if (!att.is_oneadmin())
+    {
+        att.resp_id  = current_term;
+
+        failure_response(AUTHORIZATION, att);
+        return;
+    }
+
+    if ( nd.is_cache() )
+    {
+        att.resp_msg = "Server is in cache mode.";
+        att.resp_id  = 0;
+
+        failure_response(ACTION, att);
+        return;
+    }
+
+    if ( leader_term < current_term )
+    {
+        std::ostringstream oss;
+
+        oss << "Leader term (" << leader_term << ") is outdated ("
+            << current_term<<")";
+
+        NebulaLog::log("ReM", Log::INFO, oss);
+
+        att.resp_msg = oss.str();
+        att.resp_id  = current_term;
+
+        failure_response(ACTION, att);
+        return;
+    }
+    else if ( leader_term > current_term )
+    {
+        std::ostringstream oss;
+
+        oss << "New term (" << leader_term << ") discovered from leader "
+            << leader_id;
+
+        NebulaLog::log("ReM", Log::INFO, oss);
+
+        raftm->follower(leader_term);
+    }
+
+    if ( raftm->is_candidate() )
+    {
+        raftm->follower(leader_term);
+    }
+
+    raftm->update_last_heartbeat(leader_id);
+
+    //--------------------------------------------------------------------------
+    // SNAPSHOT
+    //   1. Append the chunk to the snapshot file, chunks are sent in order
+    //   2. Install the snapshot with the last chunk, it replaces the DB state
+    //      and the log
+    //--------------------------------------------------------------------------
+    string file = nd.get_var_location() + "raft_snapshot";
+
+    std::ios::openmode mode = std::ios::out | std::ios::binary;
+
+    if ( offset == 0 )
+    {
+        mode |= std::ios::trunc;
+    }
+    else
+    {
+        mode |= std::ios::app | std::ios::ate;
+    }
+
+    std::ofstream out(file.c_str(), mode);
+
+    if ( !out.good() || static_cast<uint64_t>(out.tellp()) != offset )
+    {
+        att.resp_msg = "Snapshot chunk out of order";
+        att.resp_id  = current_term;
+
+        failure_response(ACTION, att);
+        return;
+    }
+
+    string * chunk = one_util::zlib_decompress(data, true);
+
+    if ( chunk == 0 )
+    {
+        att.resp_msg = "Error decompressing snapshot chunk";
+        att.resp_id  = current_term;
+
+        failure_response(ACTION, att);
+        return;
+    }
+
+    out << *chunk;
+
+    delete chunk;
+
+    out.close();
+
+    if ( out.fail() )
+    {
+        att.resp_msg = "Error writing snapshot file";
+        att.resp_id  = current_term;
+
+        failure_response(ACTION, att);
+        return;
+    }
+
+    if ( !done )
+    {
+        success_response(static_cast<int>(current_term), att);
+        return;
+    }
+
+    int rc = logdb->install_snapshot(file, index, term, fed_index);
+
+    unlink(file.c_str());
+
+    if ( rc != 0 )
+    {
+        att.resp_msg = "Error installing snapshot";
+        att.resp_id  = current_term;
+
+        failure_response(ACTION, att);
+        return;
+    }
+
+    raftm->update_commit(index, index);
+
     success_response(static_cast<int>(current_term), att);
 }
 
@@ -28,7 +28,8 @@ using namespace std;
 class AclXML : public AclManager
 {
 public:
-    AclXML(Client * _client, int zone_id):AclManager(zone_id), client(_client)
+    AclXML(Client * _client, int zone_id):AclManager(zone_id), client(_client),
+        signature(0)
     {};
 
     virtual ~AclXML(){};
@@ -39,6 +40,24 @@ public:
      */
     int set_up();
 
+    /**
+     *  Loads the ACL rules from a file instead of requesting them to oned
+     *  (see PoolXML::set_fixture)
+     *    @param file with the rules, as returned by one.acl.info
+     */
+    void set_fixture(const string& file)
+    {
+        fixture = file;
+    };
+
+    /**
+     *  @return hash of the rule set, it changes when any rule changes
+     */
+    size_t get_signature() const
+    {
+        return signature;
+    };
+
 private:
     /* ---------------------------------------------------------------------- */
     /* Re-implement DB public functions not used in scheduler                */
@@ -68,6 +87,16 @@ private:
 
     Client * client;
 
+    /**
+     *  File to load the rules from, empty to use oned
+     */
+    string fixture;
+
+    /**
+     *  Hash of the XML representation of the rule set
+     */
+    size_t signature;
+
     /**
      *  Loads the ACL rule set from its XML representation:
      *  as obtained by a dump call
@@ -57,6 +57,11 @@ protected:
     void add_object(xmlNodePtr node);
 
     int load_info(xmlrpc_c::value &result);
+
+    const char * delta_method() const
+    {
+        return "one.clusterpool.infodelta";
+    };
 };
 
 #endif /* CLUSTER_POOL_XML_H_ */
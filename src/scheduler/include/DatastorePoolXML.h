@@ -31,6 +31,8 @@ public:
 
     ~DatastorePoolXML(){};
 
+    int set_up();
+
     /**
      *  Gets an object from the pool
      *   @param oid the object unique identifier
@@ -42,6 +44,16 @@ public:
         return static_cast<DatastoreXML *>(PoolXML::get(oid));
     };
 
+    /**
+     *  Gets the datastores with enough free space for a VM, using the
+     *  capacity index built in set_up. Only the capacity of shared and
+     *  monitored datastores is checked, as in DatastoreXML::test_capacity.
+     *    @param vm_disk_mb capacity needed by the VM
+     *    @param datastores that fit the VM sorted by ID
+     */
+    void get_fitting_datastores(long long vm_disk_mb,
+            vector<DatastoreXML *>& datastores) const;
+
 protected:
 
     virtual int get_suitable_nodes(vector<xmlNodePtr>& content) = 0;
@@ -49,6 +61,27 @@ protected:
     void add_object(xmlNodePtr node);
 
     int load_info(xmlrpc_c::value &result);
+
+    const char * delta_method() const
+    {
+        return "one.datastorepool.infodelta";
+    };
+
+private:
+    /**
+     *  Shared and monitored datastores sorted by free space (decreasing)
+     */
+    vector<DatastoreXML *> capacity_index;
+
+    /**
+     *  Datastores whose capacity is not checked
+     */
+    vector<DatastoreXML *> unchecked;
+
+    /**
+     *  Builds the capacity index from the pool objects
+     */
+    void build_capacity_index();
 };
 
 /* -------------------------------------------------------------------------- */
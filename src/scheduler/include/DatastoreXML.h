@@ -70,6 +70,14 @@ public:
         return oid;
     };
 
+    /**
+     *  @return free disk for VMs (in MB)
+     */
+    long long get_free_mb() const
+    {
+        return free_mb;
+    };
+
     bool is_in_cluster(int cid) const
     {
         return cluster_ids.count(cid) != 0;
@@ -53,6 +53,23 @@ public:
      */
     void merge_clusters(ClusterPoolXML * clpool);
 
+    /**
+     *  Computes the signature of each host, to detect the hosts that changed
+     *  since the previous cycle. It should be called once the host documents
+     *  are complete (i.e. after merge_clusters)
+     */
+    void update_signatures();
+
+    /**
+     *  Gets the hosts with enough free CPU and memory for a VM, using the
+     *  capacity index built in set_up. The hosts still need to be checked
+     *  with HostXML::test_capacity (PCI devices and NUMA topology).
+     *    @param sr capacity request of the VM
+     *    @param hosts that fit the request sorted by ID
+     */
+    void get_fitting_hosts(const HostShareCapacity& sr,
+            vector<HostXML *>& hosts) const;
+
 protected:
 
     int get_suitable_nodes(vector<xmlNodePtr>& content)
@@ -63,6 +80,34 @@ protected:
     void add_object(xmlNodePtr node);
 
     int load_info(xmlrpc_c::value &result);
+
+    const char * delta_method() const
+    {
+        return "one.hostpool.infodelta";
+    };
+
+private:
+    /**
+     *  Free capacity of a host
+     */
+    struct HostCapacity
+    {
+        long long cpu;
+        long long mem;
+
+        HostXML * host;
+    };
+
+    /**
+     *  Hosts sorted by free CPU (decreasing). The capacity is only indexed
+     *  for matching, it is not updated as VMs are dispatched.
+     */
+    vector<HostCapacity> capacity_index;
+
+    /**
+     *  Builds the capacity index from the pool objects
+     */
+    void build_capacity_index();
 };
 
 #endif /* HOST_POOL_XML_H_ */
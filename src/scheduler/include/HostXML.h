@@ -108,6 +108,22 @@ public:
         ds_free_disk[dsid] -= vm_disk_mb;
     }
 
+    /**
+     *  @return free CPU of the host (percentage)
+     */
+    long long free_cpu() const
+    {
+        return max_cpu - cpu_usage;
+    }
+
+    /**
+     *  @return free memory of the host (in KB)
+     */
+    long long free_mem() const
+    {
+        return max_mem - mem_usage;
+    }
+
     /**
      *  Prints the share information to an output stream.
      */
@@ -179,6 +195,20 @@ public:
         return public_cloud;
     }
 
+    /**
+     *  @return hash of the host document, it changes when any attribute of
+     *  the host changes. Computed by update_signature.
+     */
+    size_t get_signature() const
+    {
+        return signature;
+    }
+
+    /**
+     *  Computes the hash of the current host document
+     */
+    void update_signature();
+
     void get_permissions(PoolObjectAuth& auth);
 
     /* ---------------------------------------------------------------------- */
@@ -195,6 +225,22 @@ public:
         return share.test_capacity(sr, error);
     }
 
+    /**
+     *  @return free CPU of the host (percentage)
+     */
+    long long get_free_cpu() const
+    {
+        return share.free_cpu();
+    }
+
+    /**
+     *  @return free memory of the host (in KB)
+     */
+    long long get_free_mem() const
+    {
+        return share.free_mem();
+    }
+
     /**
      *  Adds a new VM to the given share by incrementing the cpu,mem and disk
      *  counters
@@ -279,6 +325,8 @@ private:
 
     bool public_cloud;
 
+    size_t signature;
+
     // ---------------------------------------------------------------------- //
     // Scheduling statistics                                                  //
     // ---------------------------------------------------------------------- //
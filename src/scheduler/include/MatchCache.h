@@ -0,0 +1,221 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2019, OpenNebula Project, OpenNebula Systems                */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+#ifndef MATCH_CACHE_H_
+#define MATCH_CACHE_H_
+
+#include <map>
+
+#include "ObjectXML.h"
+
+using namespace std;
+
+/**
+ *  Results of matching the pending VMs with the hosts, kept across scheduling
+ *  cycles. A result is reused while the VM and the host do not change, as
+ *  given by their signatures (hashes of the attributes used to match them).
+ */
+class MatchCache
+{
+public:
+    /**
+     *  Steps of the host match passed by a VM
+     */
+    enum MatchStage
+    {
+        NONE    = 0, /**< Host discarded before authorization    */
+        AUTH    = 1, /**< User authorized to use the host        */
+        FITS    = 2, /**< Host has capacity for the VM           */
+        MATCHED = 3  /**< Host meets the VM requirements         */
+    };
+
+    /**
+     *  Match of a VM with a host
+     */
+    struct HostMatch
+    {
+        HostMatch(size_t sig, MatchStage st):
+            signature(sig), stage(st), ranked(false), rank(0){};
+
+        size_t     signature;
+        MatchStage stage;
+
+        bool ranked;
+        int  rank;
+    };
+
+    /**
+     *  Host matches of a VM
+     */
+    class VMMatch
+    {
+    public:
+        VMMatch():signature(0){};
+
+        /**
+         *  Gets the match with a host
+         *    @param hid of the host
+         *    @param sig current signature of the host
+         *    @return the match or 0 if not cached or the host changed
+         */
+        HostMatch * get(int hid, size_t sig)
+        {
+            map<int, HostMatch>::iterator it = hosts.find(hid);
+
+            if ( it == hosts.end() || it->second.signature != sig )
+            {
+                return 0;
+            }
+
+            return &(it->second);
+        }
+
+        /**
+         *  Sets the match with a host, the rank is not cached
+         *    @param hid of the host
+         *    @param sig current signature of the host
+         *    @param stage reached by the match
+         */
+        void set(int hid, size_t sig, MatchStage stage)
+        {
+            map<int, HostMatch>::iterator it = hosts.find(hid);
+
+            if ( it == hosts.end() )
+            {
+                hosts.insert(make_pair(hid, HostMatch(sig, stage)));
+            }
+            else
+            {
+                it->second = HostMatch(sig, stage);
+            }
+        }
+
+        /**
+         *  Gets the cached rank of a matched host. Only valid after the host
+         *  match has been looked up or set in this cycle.
+         *    @param hid of the host
+         *    @param rank of the host
+         *    @return true if the rank is cached
+         */
+        bool get_rank(int hid, int& rank) const
+        {
+            map<int, HostMatch>::const_iterator it = hosts.find(hid);
+
+            if ( it == hosts.end() || !it->second.ranked )
+            {
+                return false;
+            }
+
+            rank = it->second.rank;
+
+            return true;
+        }
+
+        /**
+         *  Caches the rank of a matched host
+         */
+        void set_rank(int hid, int rank)
+        {
+            map<int, HostMatch>::iterator it = hosts.find(hid);
+
+            if ( it != hosts.end() )
+            {
+                it->second.ranked = true;
+                it->second.rank   = rank;
+            }
+        }
+
+    private:
+        friend class MatchCache;
+
+        /**
+         *  Signature of the VM when the hosts were matched
+         */
+        size_t signature;
+
+        map<int, HostMatch> hosts;
+    };
+
+    /**
+     *  Prepares the cache for a new cycle. Entries are created for the pending
+     *  VMs and removed for the VMs no longer pending. It needs to be called
+     *  before matching the VMs.
+     *    @param vms the pending VMs
+     */
+    void set_up(const map<int, ObjectXML*>& vms)
+    {
+        map<int, VMMatch>::iterator it = matches.begin();
+
+        while ( it != matches.end() )
+        {
+            if ( vms.find(it->first) == vms.end() )
+            {
+                matches.erase(it++);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        map<int, ObjectXML*>::const_iterator jt;
+
+        for ( jt = vms.begin() ; jt != vms.end() ; ++jt )
+        {
+            matches.insert(make_pair(jt->first, VMMatch()));
+        }
+    }
+
+    /**
+     *  Gets the host matches of a VM, they are cleared if the VM changed.
+     *  After set_up, it can be called from different threads for different
+     *  VMs.
+     *    @param vid of the VM
+     *    @param sig current signature of the VM
+     *    @return the matches of the VM, 0 if it was not pending in set_up
+     */
+    VMMatch * get(int vid, size_t sig)
+    {
+        map<int, VMMatch>::iterator it = matches.find(vid);
+
+        if ( it == matches.end() )
+        {
+            return 0;
+        }
+
+        if ( it->second.signature != sig )
+        {
+            it->second.hosts.clear();
+
+            it->second.signature = sig;
+        }
+
+        return &(it->second);
+    }
+
+    /**
+     *  Removes all the cached matches
+     */
+    void clear()
+    {
+        matches.clear();
+    }
+
+private:
+    map<int, VMMatch> matches;
+};
+
+#endif /*MATCH_CACHE_H_*/
@@ -18,6 +18,8 @@
 #ifndef POOL_XML_H_
 #define POOL_XML_H_
 
+#include <fstream>
+
 #include "NebulaLog.h"
 #include "ObjectXML.h"
 #include "Client.h"
@@ -53,39 +55,47 @@ public:
         flush();
 
         // ---------------------------------------------------------------------
-        // Load the ids (to get an updated list of the pool)
+        // Update the pool document, with the changes since the last update if
+        // supported by the pool
         // ---------------------------------------------------------------------
 
-        xmlrpc_c::value result;
+        rc = -1;
 
-        rc = load_info(result);
+        if ( is_offline() )
+        {
+            if ( load_fixture() != 0 )
+            {
+                return -1;
+            }
 
-        if ( rc != 0 )
+            rc = 0;
+        }
+        else if ( delta_method() != 0 && use_delta )
         {
-            NebulaLog::log("POOL",Log::ERROR,
-                           "Could not retrieve pool info from ONE");
-            return -1;
+            rc = load_delta();
         }
 
-        vector<xmlrpc_c::value> values =
-                        xmlrpc_c::value_array(result).vectorValueValue();
+        if ( rc != 0 )
+        {
+            if ( load_pool() != 0 )
+            {
+                return -1;
+            }
 
-        bool   success = xmlrpc_c::value_boolean( values[0] );
-        string message = xmlrpc_c::value_string(  values[1] );
+            // oned does not implement the delta method
+            if ( rc == -2 )
+            {
+                ostringstream oss;
 
-        if( !success )
-        {
-            ostringstream oss;
+                oss << delta_method() << " not supported by ONE, the full "
+                    << "pool will be retrieved in each cycle.";
 
-            oss << "ONE returned error while retrieving pool info:" << endl;
-            oss << message;
+                NebulaLog::log("POOL", Log::WARNING, oss);
 
-            NebulaLog::log("POOL", Log::ERROR, oss);
-            return -1;
+                use_delta = false;
+            }
         }
 
-        update_from_str(message);
-
         vector<xmlNodePtr> nodes;
 
         get_suitable_nodes(nodes);
@@ -166,6 +176,17 @@ public:
         return rc.second;
     }
 
+    /**
+     *  Loads the pool from a file instead of requesting it to oned, used to
+     *  simulate a scheduling cycle (see Scheduler::simulate). Requests that
+     *  update oned are not sent for pools loaded from a file.
+     *    @param file with the pool, as returned by the pool info call
+     */
+    void set_fixture(const string& file)
+    {
+        fixture = file;
+    };
+
 protected:
     // ------------------------------------------------------------------------
 
@@ -173,6 +194,8 @@ protected:
     {
         this->client     = client;
         this->pool_limit = pool_limit;
+
+        use_delta = true;
     };
 
     virtual ~PoolXML()
@@ -181,6 +204,15 @@ protected:
     };
 
     // ------------------------------------------------------------------------
+    /**
+     *  @return true if the pool is loaded from a file, and no requests should
+     *  be sent to oned
+     */
+    bool is_offline() const
+    {
+        return !fixture.empty();
+    };
+
     /**
      * Inserts a new ObjectXML into the objects map
      */
@@ -196,6 +228,17 @@ protected:
      */
     virtual int load_info(xmlrpc_c::value &result) = 0;
 
+    /**
+     *  XML-RPC method that returns the changes of the pool since a given
+     *  version (e.g. one.hostpool.infodelta). The method must return the same
+     *  objects as load_info. Pools without delta method are loaded each time.
+     *    @return the method name or 0 if not supported
+     */
+    virtual const char * delta_method() const
+    {
+        return 0;
+    };
+
     /**
      *  Deletes pool objects and frees resources.
      */
@@ -229,6 +272,201 @@ protected:
      * Hash map contains the suitable [id, object] pairs.
      */
     map<int, ObjectXML *> objects;
+
+private:
+    /**
+     *  Version of the pool document as returned by the delta method, empty if
+     *  the document has to be loaded from scratch
+     */
+    string version;
+
+    /**
+     *  False if oned does not implement the delta method
+     */
+    bool use_delta;
+
+    /**
+     *  File to load the pool from, empty to use oned
+     */
+    string fixture;
+
+    /**
+     *  Loads the pool document from the fixture file. A missing file is
+     *  loaded as an empty pool.
+     *    @return 0 on success
+     */
+    int load_fixture()
+    {
+        ifstream      file(fixture.c_str());
+        ostringstream oss;
+
+        if ( !file.good() )
+        {
+            oss << "Cannot open " << fixture << ", using an empty pool.";
+
+            NebulaLog::log("POOL", Log::WARNING, oss);
+
+            return update_from_str("<POOL/>");
+        }
+
+        oss << file.rdbuf();
+
+        if ( update_from_str(oss.str()) != 0 )
+        {
+            NebulaLog::log("POOL", Log::ERROR, "Wrong XML in " + fixture);
+            return -1;
+        }
+
+        return 0;
+    }
+
+    /**
+     *  Loads the pool document with load_info
+     *    @return 0 on success
+     */
+    int load_pool()
+    {
+        xmlrpc_c::value result;
+
+        version.clear();
+
+        if ( load_info(result) != 0 )
+        {
+            NebulaLog::log("POOL",Log::ERROR,
+                           "Could not retrieve pool info from ONE");
+            return -1;
+        }
+
+        vector<xmlrpc_c::value> values =
+                        xmlrpc_c::value_array(result).vectorValueValue();
+
+        bool   success = xmlrpc_c::value_boolean( values[0] );
+        string message = xmlrpc_c::value_string(  values[1] );
+
+        if( !success )
+        {
+            ostringstream oss;
+
+            oss << "ONE returned error while retrieving pool info:" << endl;
+            oss << message;
+
+            NebulaLog::log("POOL", Log::ERROR, oss);
+            return -1;
+        }
+
+        return update_from_str(message);
+    }
+
+    /**
+     *  Updates the pool document with the objects changed since the last
+     *  version. The pool is loaded from scratch if oned cannot compute the
+     *  changes (e.g. after a restart or a leader change).
+     *    @return 0 on success, -1 on error, -2 if oned does not implement
+     *    the method
+     */
+    int load_delta()
+    {
+        xmlrpc_c::value result;
+
+        try
+        {
+            client->call(delta_method(), "s", &result, version.c_str());
+        }
+        catch (ClientFault const& f)
+        {
+            ostringstream oss;
+
+            oss << "Exception raised: " << f.what();
+
+            NebulaLog::log("POOL", Log::ERROR, oss);
+
+            version.clear();
+
+            if ( f.get_code() == xmlrpc_c::fault::CODE_NO_SUCH_METHOD )
+            {
+                return -2;
+            }
+
+            return -1;
+        }
+        catch (exception const& e)
+        {
+            // Transient error (e.g. timeout, oned restart), retried next cycle
+            ostringstream oss;
+
+            oss << "Exception raised: " << e.what();
+
+            NebulaLog::log("POOL", Log::ERROR, oss);
+
+            version.clear();
+
+            return -1;
+        }
+
+        vector<xmlrpc_c::value> values =
+                        xmlrpc_c::value_array(result).vectorValueValue();
+
+        bool   success = xmlrpc_c::value_boolean( values[0] );
+        string message = xmlrpc_c::value_string(  values[1] );
+
+        if( !success )
+        {
+            ostringstream oss;
+
+            oss << "ONE returned error while retrieving pool changes:" << endl;
+            oss << message;
+
+            NebulaLog::log("POOL", Log::ERROR, oss);
+            return -1;
+        }
+
+        ObjectXML delta;
+
+        if ( delta.update_from_str(message) != 0 )
+        {
+            version.clear();
+            return -1;
+        }
+
+        string         new_version;
+        int            full;
+        vector<int>    ids;
+        vector<xmlNodePtr> pool;
+
+        delta.xpath(new_version, "/POOL_DELTA/VERSION", "");
+        delta.xpath(full, "/POOL_DELTA/FULL", 1);
+        delta.xpaths(ids, "/POOL_DELTA/CHANGED/ID");
+
+        delta.get_nodes("/POOL_DELTA/*[not(self::VERSION or self::FULL or "
+                "self::CHANGED)]", pool);
+
+        int rc;
+
+        if ( full == 1 )
+        {
+            rc = pool.empty() ? -1 : update_from_node(pool[0]);
+        }
+        else if ( version.empty() )
+        {
+            rc = -1;
+        }
+        else
+        {
+            rc = merge_by_id(pool.empty() ? 0 : pool[0], ids);
+        }
+
+        free_nodes(pool);
+
+        if ( rc != 0 )
+        {
+            version.clear();
+            return -1;
+        }
+
+        version = new_version;
+
+        return 0;
+    }
 };
 
 #endif /* POOL_XML_H_ */
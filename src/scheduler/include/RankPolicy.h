@@ -38,6 +38,24 @@ protected:
      */
     virtual const string& get_rank(ObjectXML *obj) = 0;
 
+    /**
+     *  Gets the rank of a resource computed in a previous cycle, by default
+     *  ranks are not cached
+     *    @param obj The Schedulable object
+     *    @param oid of the resource
+     *    @param rank of the resource
+     *    @return true if the rank is cached
+     */
+    virtual bool get_cached_rank(ObjectXML * obj, int oid, int& rank)
+    {
+        return false;
+    };
+
+    /**
+     *  Caches the rank of a resource
+     */
+    virtual void set_cached_rank(ObjectXML * obj, int oid, int rank){};
+
     /**
      *  Default rank for resources
      */
@@ -75,13 +93,23 @@ private:
 
         for (unsigned int i=0; i<resources.size(); rank=0, i++)
         {
+            if ( get_cached_rank(obj, resources[i]->oid, rank) )
+            {
+                priority.push_back(rank);
+                continue;
+            }
+
             resource = pool->get(resources[i]->oid);
 
             if ( resource != 0 )
             {
                 rc = resource->eval_arith(srank, rank, &errmsg);
 
-                if (rc != 0)
+                if ( rc == 0 )
+                {
+                    set_cached_rank(obj, resources[i]->oid, rank);
+                }
+                else
                 {
                     ostringstream oss;
 
@@ -134,6 +162,27 @@ private:
 
         return vm->get_rank();
     };
+
+    bool get_cached_rank(ObjectXML * obj, int oid, int& rank)
+    {
+        VirtualMachineXML * vm = static_cast<VirtualMachineXML *>(obj);
+
+        MatchCache::VMMatch * mc = vm->get_match_cache();
+
+        return mc != 0 && mc->get_rank(oid, rank);
+    };
+
+    void set_cached_rank(ObjectXML * obj, int oid, int rank)
+    {
+        VirtualMachineXML * vm = static_cast<VirtualMachineXML *>(obj);
+
+        MatchCache::VMMatch * mc = vm->get_match_cache();
+
+        if ( mc != 0 )
+        {
+            mc->set_rank(oid, rank);
+        }
+    };
 };
 
 
@@ -18,6 +18,7 @@
 #define RESOURCE_H_
 
 #include <map>
+#include <algorithm>
 
 class PoolXML;
 
@@ -79,6 +80,25 @@ public:
         std::sort(resources.begin(), resources.end(), cmp);
     }
 
+    /**
+     *  Moves a resource to the last position, so it is the first one
+     *  considered when the resources are traversed by priority
+     *    @param oid of the resource
+     */
+    void set_highest_priority(int oid)
+    {
+        vector<Resource *>::iterator it;
+
+        for (it = resources.begin(); it != resources.end(); ++it)
+        {
+            if ((*it)->oid == oid)
+            {
+                std::rotate(it, it + 1, resources.end());
+                break;
+            }
+        }
+    }
+
     /**
      *  Return a reference to the resources of the object
      *    @return vector of resources.
@@ -35,6 +35,8 @@ using namespace std;
 /* -------------------------------------------------------------------------- */
 
 extern "C" void * scheduler_action_loop(void *arg);
+
+extern "C" void * scheduler_match_loop(void *arg);
 class  SchedulerTemplate;
 /**
  *  The Scheduler class. It represents the scheduler ...
@@ -45,6 +47,22 @@ class Scheduler: public ActionListener
 public:
     void start();
 
+    /**
+     *  Runs a single scheduling cycle offline, reading the pools from the XML
+     *  files in a directory instead of contacting oned. Nothing is sent to
+     *  oned, dispatched VMs are only accounted in the pools. The files are the
+     *  output of the pool info calls:
+     *    - acl.xml, user.xml, host.xml, cluster.xml, vnet.xml, vmgroup.xml
+     *    - datastore.xml, used for the system and image datastores
+     *    - vm.xml (one.vmpool.infoextended), used for pending VMs, VM roles
+     *      and scheduled actions
+     *  Missing files are loaded as empty pools. Timing of each phase and the
+     *  placement results are written to the standard output.
+     *    @param dir path of the directory with the pool files
+     *    @return 0 on success
+     */
+    int simulate(const string& dir);
+
     virtual void register_policies(const SchedulerTemplate& conf){};
 
     static Scheduler& instance(Scheduler* the_sched=0)
@@ -64,6 +82,47 @@ public:
         return mem_ds_scale;
     };
 
+    /**
+     *  State of a match thread. Log messages of a VM are buffered and
+     *  written together, VM updates are sent to oned once all the threads
+     *  finish.
+     */
+    struct MatchContext
+    {
+        MatchContext():vms(0), host_match(0), host_rank(0), ds_match(0),
+            ds_rank(0), net_match(0), net_rank(0){};
+
+        void log(Log::MessageType type, const string& msg)
+        {
+            logs.push_back(make_pair(type, msg));
+        };
+
+        /**
+         *  Number of VMs matched by the thread
+         */
+        unsigned int vms;
+
+        /**
+         *  Time spent in each phase, in seconds
+         */
+        double host_match;
+        double host_rank;
+        double ds_match;
+        double ds_rank;
+        double net_match;
+        double net_rank;
+
+        /**
+         *  Log messages of the VM being matched
+         */
+        vector<pair<Log::MessageType, string> > logs;
+
+        /**
+         *  VMs with scheduling messages to update in oned
+         */
+        vector<VirtualMachineXML *> updates;
+    };
+
 protected:
 
     Scheduler():
@@ -84,8 +143,12 @@ protected:
         dispatch_limit(0),
         host_dispatch_limit(0),
         mem_ds_scale(0),
-        diff_vnets(false)
+        diff_vnets(false),
+        sched_threads(1),
+        role_placement(false)
     {
+        pthread_mutex_init(&match_log_mutex, 0);
+
         am.addListener(this);
     };
 
@@ -106,6 +169,8 @@ protected:
         delete vmgpool;
 
         delete acls;
+
+        pthread_mutex_destroy(&match_log_mutex);
     };
 
     // ---------------------------------------------------------------
@@ -179,6 +244,13 @@ protected:
 
     virtual void do_vm_groups();
 
+    /**
+     *  Places the pending VMs of anti-affined roles as a whole, after the
+     *  match phase. Each VM gets a different preferred host.
+     *    @param placed VMs of each placed role, to be dispatched together
+     */
+    void place_vm_groups(vector<vector<int> >& placed);
+
 private:
     Scheduler(Scheduler const&){};
 
@@ -186,6 +258,23 @@ private:
 
     friend void * scheduler_action_loop(void *arg);
 
+    friend void * scheduler_match_loop(void *arg);
+
+    /**
+     *  Reads the scheduler attributes from the configuration file
+     *    @param conf the scheduler configuration
+     *    @param live_rescheds set to LIVE_RESCHEDS
+     */
+    void get_configuration(const SchedulerTemplate& conf,
+            unsigned int& live_rescheds);
+
+    /**
+     *  Creates the scheduler pools
+     *    @param client to contact oned, 0 for offline pools
+     *    @param live_resched perform live migrations to reschedule VMs
+     */
+    void create_pools(Client * client, bool live_resched);
+
     // ---------------------------------------------------------------
     // Scheduling Policies
     // ---------------------------------------------------------------
@@ -233,11 +322,48 @@ private:
      */
     bool diff_vnets;
 
+    /**
+     *  Number of threads used to match the pending VMs
+     */
+    unsigned int sched_threads;
+
+    /**
+     *  Place the VMs of anti-affined VM group roles as a whole
+     */
+    bool role_placement;
+
     /**
      * oned runtime configuration values
      */
      Template oned_conf;
 
+    // ---------------------------------------------------------------
+    // Match phase, pending VMs are matched by sched_threads threads
+    // ---------------------------------------------------------------
+
+    /**
+     *  Matches hosts, system datastores and networks for a pending VM, and
+     *  ranks them. It only modifies the VM, so VMs can be matched in parallel.
+     *    @param vm the pending VM
+     *    @param mc state of the calling thread
+     */
+    void match_vm(VirtualMachineXML * vm, MatchContext& mc);
+
+    /**
+     *  Writes the buffered messages of a match thread to the log
+     */
+    void flush_match_log(MatchContext& mc);
+
+    /**
+     *  Serializes the writes of the match threads logs
+     */
+    pthread_mutex_t match_log_mutex;
+
+    /**
+     *  Host matches and ranks of the pending VMs from previous cycles
+     */
+    MatchCache match_cache;
+
     // ---------------------------------------------------------------
     // Timer to periodically schedule and dispatch VMs
     // ---------------------------------------------------------------
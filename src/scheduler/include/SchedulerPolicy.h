@@ -54,10 +54,13 @@ public:
         //1. Compute priorities
         policy(obj, priority);
 
-        //2. Scale priorities
-        sw.max = fabs(*max_element(priority.begin(), priority.end(), abs_cmp));
+        //2. Scale priorities, objects can be scheduled in parallel so the
+        //   scale is not stored in the policy
+        ScaleWeight scale = sw;
 
-        transform(priority.begin(), priority.end(), priority.begin(), sw);
+        scale.max = fabs(*max_element(priority.begin(), priority.end(), abs_cmp));
+
+        transform(priority.begin(), priority.end(), priority.begin(), scale);
 
         //3. Aggregate to other policies
         for (unsigned int i=0; i< resources.size(); i++)
@@ -52,6 +52,11 @@ protected:
     void add_object(xmlNodePtr node);
 
     int load_info(xmlrpc_c::value &result);
+
+    const char * delta_method() const
+    {
+        return "one.userpool.infodelta";
+    };
 };
 
 #endif /* USER_POOL_XML_H_ */
@@ -20,9 +20,11 @@
 #include "ObjectXML.h"
 #include "VMGroupRole.h"
 #include "VMGroupRule.h"
+#include "HostShare.h"
 
 class VirtualMachinePoolXML;
 class VirtualMachineRolePoolXML;
+class HostPoolXML;
 
 class VMGroupXML : public ObjectXML
 {
@@ -37,6 +39,30 @@ public:
         init_attributes();
     };
 
+    /**
+     *  VMs and capacity reserved in a host by the placed roles, they are
+     *  not dispatched yet
+     */
+    struct HostReservation
+    {
+        HostReservation():vms(0)
+        {
+            capacity.vmid     = -1;
+            capacity.vcpu     = 0;
+            capacity.cpu      = 0;
+            capacity.mem      = 0;
+            capacity.disk     = 0;
+            capacity.topology = 0;
+        };
+
+        unsigned int vms;
+
+        /**
+         *  CPU, memory and PCI devices of the VMs
+         */
+        HostShareCapacity capacity;
+    };
+
     /* ---------------------------------------------------------------------- */
     /* ---------------------------------------------------------------------- */
     int get_oid() const
@@ -78,6 +104,26 @@ public:
     void set_host_requirements(VirtualMachinePoolXML * vmp,
             std::ostringstream& oss);
 
+    /**
+     *  Places the pending VMs of each anti-affined role as a whole. A
+     *  different host is assigned to each VM out of its matched hosts
+     *  (maximum bipartite matching, following the host ranking), and made
+     *  the preferred host of the VM for the dispatch phase.
+     *    @params vmpool VM set of pending VMs, with matched hosts
+     *    @params hpool the host pool
+     *    @params host_limit max. number of VMs dispatched to a host
+     *    @params reserved VMs and capacity already assigned to each host,
+     *    the hosts need room for them too. It is updated with the placements
+     *    of the roles
+     *    @params placed VMs of each placed role, they should be dispatched
+     *    together
+     *    @params oss stream to output debug information
+     */
+    void place_antiaffined_roles(VirtualMachinePoolXML * vmpool,
+            HostPoolXML * hpool, unsigned int host_limit,
+            std::map<int, HostReservation>& reserved,
+            std::vector<std::vector<int> >& placed, std::ostringstream& oss);
+
 
 private:
     // ------------------------------------------------------------------------
@@ -30,7 +30,8 @@ public:
     VirtualMachinePoolXML(Client*        client,
                           unsigned int   machines_limit,
                           bool           _live_resched):
-        PoolXML(client, machines_limit), live_resched(_live_resched){};
+        PoolXML(client, machines_limit), live_resched(_live_resched),
+        deploy_multi(true){};
 
     virtual ~VirtualMachinePoolXML(){};
 
@@ -63,6 +64,27 @@ public:
      */
     int dispatch(int vid, int hid, int dsid, bool resched, const string& extra_template) const;
 
+    /**
+     *  Adds a VM to the list of VMs to be dispatched with dispatch_queued
+     *    @param vid the VM id
+     *    @param hid the id of the target host
+     *    @param dsid the id of the target system datastore
+     *    @param resched the machine is going to be rescheduled
+     *    @param extra template with result nics
+     */
+    void queue_dispatch(int vid, int hid, int dsid, bool resched,
+            const string& extra_template);
+
+    /**
+     *  Dispatches the queued VMs with one.vm.deploymulti, in batches of
+     *  MAX_DISPATCH_BATCH VMs. VMs are dispatched one by one if oned does
+     *  not support the batch call. The queue is cleared.
+     *    @param failed ids of the VMs that could not be dispatched
+     *
+     *    @return number of VMs dispatched
+     */
+    int dispatch_queued(set<int>& failed);
+
     /**
      *  Update the VM template
      *    @param vid the VM id
@@ -114,6 +136,11 @@ protected:
 
     virtual int load_info(xmlrpc_c::value &result);
 
+    const char * delta_method() const
+    {
+        return "one.vmpool.infodelta";
+    };
+
     /**
      * Do live migrations to resched VMs
      */
@@ -124,6 +151,45 @@ private:
      *  Stores the list of vms, and it associated user prioty vm_resources.
      */
     VirtualMachineResourceMatch vm_resources;
+
+    /**
+     *  VM dispatch arguments (see queue_dispatch)
+     */
+    struct DispatchArgs
+    {
+        int    vid;
+        int    hid;
+        int    dsid;
+        bool   resched;
+        string extra_template;
+    };
+
+    /**
+     *  VMs to be dispatched
+     */
+    vector<DispatchArgs> dispatch_queue;
+
+    /**
+     *  False if oned does not implement one.vm.deploymulti (the call
+     *  returned a no such method fault)
+     */
+    bool deploy_multi;
+
+    /**
+     *  Max number of VMs dispatched in a single call
+     */
+    static const size_t MAX_DISPATCH_BATCH = 100;
+
+    /**
+     *  Dispatches a batch of queued VMs with one.vm.deploymulti
+     *    @param first VM of the batch in the dispatch queue
+     *    @param last VM of the batch (not included)
+     *    @param failed ids of the VMs that could not be dispatched
+     *
+     *    @return 0 on success, -1 if the call failed
+     */
+    int dispatch_batch(vector<DispatchArgs>::const_iterator first,
+            vector<DispatchArgs>::const_iterator last, set<int>& failed);
 };
 
 /* -------------------------------------------------------------------------- */
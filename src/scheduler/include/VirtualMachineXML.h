@@ -23,6 +23,7 @@
 #include "ObjectXML.h"
 #include "HostPoolXML.h"
 #include "Resource.h"
+#include "MatchCache.h"
 
 #include "VirtualMachineTemplate.h"
 #include "ScheduledAction.h"
@@ -320,6 +321,29 @@ public:
         match_hosts.sort_resources();
     }
 
+    /**
+     *  Host matches of the VM from previous cycles, 0 if not cached
+     */
+    MatchCache::VMMatch * get_match_cache() const
+    {
+        return match_cache;
+    }
+
+    void set_match_cache(MatchCache::VMMatch * mc)
+    {
+        match_cache = mc;
+    }
+
+    /**
+     *  Makes a matched host the first option to dispatch the VM, used when
+     *  the host has been selected for a group of VMs
+     *    @param oid of the host
+     */
+    void set_preferred_host(int oid)
+    {
+        match_hosts.set_highest_priority(oid);
+    }
+
     /**
      *  Sort the matched datastores for the VM
      */
@@ -473,6 +497,8 @@ protected:
 
     set<int> affined_vms;
 
+    MatchCache::VMMatch * match_cache;
+
     /* ----------------------- VIRTUAL MACHINE ATTRIBUTES ------------------- */
     int oid;
 
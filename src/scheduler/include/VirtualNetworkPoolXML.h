@@ -54,6 +54,11 @@ protected:
     void add_object(xmlNodePtr node);
 
     int load_info(xmlrpc_c::value &result);
+
+    const char * delta_method() const
+    {
+        return "one.vnpool.infodelta";
+    };
 };
 
 #endif /* VNET_POOL_XML_H_ */
\ No newline at end of file
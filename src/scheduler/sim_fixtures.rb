@@ -0,0 +1,400 @@
+#!/usr/bin/env ruby
+
+# -------------------------------------------------------------------------- #
+# Copyright 2002-2019, OpenNebula Project, OpenNebula Systems                #
+#                                                                            #
+# Licensed under the Apache License, Version 2.0 (the "License"); you may    #
+# not use this file except in compliance with the License. You may obtain    #
+# a copy of the License at                                                   #
+#                                                                            #
+# http://www.apache.org/licenses/LICENSE-2.0                                 #
+#                                                                            #
+# Unless required by applicable law or agreed to in writing, software        #
+# distributed under the License is distributed on an "AS IS" BASIS,          #
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   #
+# See the License for the specific language governing permissions and        #
+# limitations under the License.                                             #
+#--------------------------------------------------------------------------- #
+
+# Generates the pool files read by the scheduler simulation mode:
+#
+#   sim_fixtures.rb -n 1000 -m 5000 --groups 10 /tmp/sim
+#   mm_sched -s /tmp/sim
+#
+# The files have the format of the pool info calls, with the attributes the
+# scheduler uses. All the objects are owned by oneadmin, so no ACLs are needed.
+
+require 'optparse'
+require 'fileutils'
+
+options = {
+    :hosts      => 100,
+    :vms        => 1000,
+    :clusters   => 1,
+    :host_cpus  => 32,
+    :host_mem   => 128,
+    :host_load  => 0.0,
+    :numa_nodes => 0,
+    :pci        => 0,
+    :vm_cpu     => 1.0,
+    :vm_mem     => 2048,
+    :vm_pci     => 0.0,
+    :vm_numa    => 0.0,
+    :groups     => 0,
+    :roles      => 2,
+    :role_size  => 3,
+    :policy     => 'ANTI_AFFINED',
+    :seed       => 0
+}
+
+parser = OptionParser.new do |opts|
+    opts.banner = "Usage: sim_fixtures.rb [options] <dir>"
+
+    opts.separator ""
+    opts.separator "Hosts:"
+
+    opts.on("-n", "--hosts N", Integer, "Number of hosts (#{options[:hosts]})") do |v|
+        options[:hosts] = v
+    end
+
+    opts.on("-c", "--clusters N", Integer,
+            "Clusters, hosts are spread evenly (#{options[:clusters]})") do |v|
+        options[:clusters] = v
+    end
+
+    opts.on("--host-cpus N", Integer,
+            "CPUs of each host (#{options[:host_cpus]})") do |v|
+        options[:host_cpus] = v
+    end
+
+    opts.on("--host-mem GB", Integer,
+            "Memory of each host (#{options[:host_mem]})") do |v|
+        options[:host_mem] = v
+    end
+
+    opts.on("--host-load F", Float,
+            "Max fraction of CPU and memory in use, random per host " \
+            "(#{options[:host_load]})") do |v|
+        options[:host_load] = v
+    end
+
+    opts.on("--numa-nodes N", Integer,
+            "NUMA nodes of each host, 0 for no topology " \
+            "(#{options[:numa_nodes]})") do |v|
+        options[:numa_nodes] = v
+    end
+
+    opts.on("--pci N", Integer,
+            "PCI devices (GPUs) of each host (#{options[:pci]})") do |v|
+        options[:pci] = v
+    end
+
+    opts.separator ""
+    opts.separator "Pending VMs:"
+
+    opts.on("-m", "--vms N", Integer, "Number of VMs (#{options[:vms]})") do |v|
+        options[:vms] = v
+    end
+
+    opts.on("--vm-cpu F", Float, "CPU of each VM (#{options[:vm_cpu]})") do |v|
+        options[:vm_cpu] = v
+    end
+
+    opts.on("--vm-mem MB", Integer,
+            "Memory of each VM (#{options[:vm_mem]})") do |v|
+        options[:vm_mem] = v
+    end
+
+    opts.on("--vm-pci F", Float,
+            "Fraction of VMs that request a PCI device (#{options[:vm_pci]})") do |v|
+        options[:vm_pci] = v
+    end
+
+    opts.on("--vm-numa F", Float,
+            "Fraction of VMs with a pinned NUMA topology, needs " \
+            "--numa-nodes (#{options[:vm_numa]})") do |v|
+        options[:vm_numa] = v
+    end
+
+    opts.separator ""
+    opts.separator "VM groups, made of the first pending VMs:"
+
+    opts.on("-g", "--groups N", Integer,
+            "Number of VM groups (#{options[:groups]})") do |v|
+        options[:groups] = v
+    end
+
+    opts.on("--roles N", Integer,
+            "Roles of each group (#{options[:roles]})") do |v|
+        options[:roles] = v
+    end
+
+    opts.on("--role-size N", Integer,
+            "VMs of each role (#{options[:role_size]})") do |v|
+        options[:role_size] = v
+    end
+
+    opts.on("--policy P", ['ANTI_AFFINED', 'AFFINED', 'NONE'],
+            "Policy of the roles (#{options[:policy]})") do |v|
+        options[:policy] = v
+    end
+
+    opts.separator ""
+
+    opts.on("--seed N", Integer,
+            "Seed of the random values (#{options[:seed]})") do |v|
+        options[:seed] = v
+    end
+
+    opts.on("-h", "--help", "Show this message") do
+        puts opts
+        exit 0
+    end
+end
+
+begin
+    parser.parse!
+rescue OptionParser::ParseError => e
+    STDERR.puts e.message
+    STDERR.puts parser.banner
+    exit(-1)
+end
+
+if ARGV.length != 1
+    STDERR.puts parser.banner
+    exit(-1)
+end
+
+dir = ARGV[0]
+
+if options[:clusters] < 1 || options[:hosts] < 0 || options[:vms] < 0
+    STDERR.puts "Wrong number of hosts, VMs or clusters"
+    exit(-1)
+end
+
+if options[:groups] * options[:roles] * options[:role_size] > options[:vms]
+    STDERR.puts "Not enough VMs for the VM groups"
+    exit(-1)
+end
+
+srand(options[:seed])
+
+FileUtils.mkdir_p(dir)
+
+def write_pool(dir, file, pool, objects)
+    File.open(File.join(dir, file), 'w') do |f|
+        f << "<#{pool}>"
+        objects.each {|o| f << o }
+        f << "</#{pool}>\n"
+    end
+end
+
+def xml_escape(str)
+    str.gsub('&', '&amp;').gsub('<', '&lt;').gsub('>', '&gt;')
+end
+
+PERMISSIONS = '<PERMISSIONS><OWNER_U>1</OWNER_U><OWNER_M>1</OWNER_M>' \
+              '<OWNER_A>0</OWNER_A><GROUP_U>0</GROUP_U><GROUP_M>0</GROUP_M>' \
+              '<GROUP_A>0</GROUP_A><OTHER_U>0</OTHER_U><OTHER_M>0</OTHER_M>' \
+              '<OTHER_A>0</OTHER_A></PERMISSIONS>'
+
+clusters = (0...options[:clusters]).to_a
+
+# ---------------------------------------------------------------------------- #
+# Hosts. CPU in percentage, memory in KB                                       #
+# ---------------------------------------------------------------------------- #
+max_cpu = options[:host_cpus] * 100
+max_mem = options[:host_mem] * 1024 * 1024
+
+hosts = []
+
+options[:hosts].times do |id|
+    cid  = clusters[id % clusters.length]
+    load = rand * options[:host_load]
+
+    cpu_usage = (max_cpu * load).to_i
+    mem_usage = (max_mem * load).to_i
+
+    pci = ''
+
+    options[:pci].times do |i|
+        address = format('0000:%02x:00.0', i + 1)
+
+        pci << "<PCI><ADDRESS>#{address}</ADDRESS><BUS>#{format('%02x', i + 1)}</BUS>" \
+               "<CLASS>0300</CLASS><CLASS_NAME>VGA compatible controller</CLASS_NAME>" \
+               "<DEVICE>1db4</DEVICE><DEVICE_NAME>GV100GL</DEVICE_NAME>" \
+               "<DOMAIN>0000</DOMAIN><FUNCTION>0</FUNCTION>" \
+               "<SHORT_ADDRESS>#{format('%02x', i + 1)}:00.0</SHORT_ADDRESS>" \
+               "<SLOT>00</SLOT><TYPE>10de:1db4:0300</TYPE><VENDOR>10de</VENDOR>" \
+               "<VENDOR_NAME>NVIDIA Corporation</VENDOR_NAME><VMID>-1</VMID></PCI>"
+    end
+
+    # Two threads per core, the cores split evenly among the nodes
+    numa = ''
+
+    if options[:numa_nodes] > 0
+        cores    = options[:host_cpus] / 2
+        per_node = cores / options[:numa_nodes]
+        node_mem = max_mem / options[:numa_nodes]
+
+        options[:numa_nodes].times do |n|
+            numa << "<NODE><NODE_ID>#{n}</NODE_ID>"
+
+            per_node.times do |c|
+                core = n * per_node + c
+
+                numa << "<CORE><ID>#{core}</ID>" \
+                        "<CPUS>#{core}:-1,#{core + cores}:-1</CPUS>" \
+                        "<DEDICATED>NO</DEDICATED><FREE>2</FREE></CORE>"
+            end
+
+            distance = (0...options[:numa_nodes]).to_a.rotate(n).join(' ')
+
+            numa << "<MEMORY><DISTANCE>#{distance}</DISTANCE>" \
+                    "<TOTAL>#{node_mem}</TOTAL><FREE>#{node_mem}</FREE>" \
+                    "<USED>0</USED><USAGE>0</USAGE></MEMORY></NODE>"
+        end
+    end
+
+    hosts << "<HOST><ID>#{id}</ID><NAME>host#{id}</NAME><STATE>2</STATE>" \
+             "<IM_MAD>kvm</IM_MAD><VM_MAD>kvm</VM_MAD>" \
+             "<CLUSTER_ID>#{cid}</CLUSTER_ID><CLUSTER>cluster#{cid}</CLUSTER>" \
+             "<HOST_SHARE><DISK_USAGE>0</DISK_USAGE>" \
+             "<MEM_USAGE>#{mem_usage}</MEM_USAGE><CPU_USAGE>#{cpu_usage}</CPU_USAGE>" \
+             "<TOTAL_MEM>#{max_mem}</TOTAL_MEM><TOTAL_CPU>#{max_cpu}</TOTAL_CPU>" \
+             "<MAX_DISK>1048576</MAX_DISK><MAX_MEM>#{max_mem}</MAX_MEM>" \
+             "<MAX_CPU>#{max_cpu}</MAX_CPU><FREE_DISK>1048576</FREE_DISK>" \
+             "<FREE_MEM>#{max_mem - mem_usage}</FREE_MEM>" \
+             "<FREE_CPU>#{max_cpu - cpu_usage}</FREE_CPU><USED_DISK>0</USED_DISK>" \
+             "<USED_MEM>#{mem_usage}</USED_MEM><USED_CPU>#{cpu_usage}</USED_CPU>" \
+             "<RUNNING_VMS>0</RUNNING_VMS><VMS_THREAD>1</VMS_THREAD>" \
+             "<DATASTORES/><PCI_DEVICES>#{pci}</PCI_DEVICES>" \
+             "<NUMA_NODES>#{numa}</NUMA_NODES></HOST_SHARE><VMS/>" \
+             "<TEMPLATE><HYPERVISOR>kvm</HYPERVISOR></TEMPLATE></HOST>"
+end
+
+write_pool(dir, 'host.xml', 'HOST_POOL', hosts)
+
+# ---------------------------------------------------------------------------- #
+# Clusters, with a shared system datastore (ID 100 + cluster) each            #
+# ---------------------------------------------------------------------------- #
+cluster_xml = clusters.map do |cid|
+    "<CLUSTER><ID>#{cid}</ID><NAME>cluster#{cid}</NAME><HOSTS/>" \
+    "<DATASTORES><ID>1</ID><ID>#{100 + cid}</ID></DATASTORES><VNETS/>" \
+    "<TEMPLATE/></CLUSTER>"
+end
+
+write_pool(dir, 'cluster.xml', 'CLUSTER_POOL', cluster_xml)
+
+datastores = ["<DATASTORE><ID>1</ID><UID>0</UID><GID>0</GID>" \
+              "<NAME>default</NAME>#{PERMISSIONS}<DS_MAD>fs</DS_MAD>" \
+              "<TM_MAD>shared</TM_MAD><TYPE>0</TYPE><STATE>0</STATE>" \
+              "<CLUSTERS>#{clusters.map {|c| "<ID>#{c}</ID>" }.join}</CLUSTERS>" \
+              "<TOTAL_MB>104857600</TOTAL_MB><FREE_MB>104857600</FREE_MB>" \
+              "<USED_MB>0</USED_MB><TEMPLATE><SHARED>YES</SHARED>" \
+              "<TYPE>IMAGE_DS</TYPE></TEMPLATE></DATASTORE>"]
+
+clusters.each do |cid|
+    datastores << "<DATASTORE><ID>#{100 + cid}</ID><UID>0</UID><GID>0</GID>" \
+                  "<NAME>system#{cid}</NAME>#{PERMISSIONS}<DS_MAD>-</DS_MAD>" \
+                  "<TM_MAD>shared</TM_MAD><TYPE>1</TYPE><STATE>0</STATE>" \
+                  "<CLUSTERS><ID>#{cid}</ID></CLUSTERS>" \
+                  "<TOTAL_MB>104857600</TOTAL_MB><FREE_MB>104857600</FREE_MB>" \
+                  "<USED_MB>0</USED_MB><TEMPLATE><SHARED>YES</SHARED>" \
+                  "<TYPE>SYSTEM_DS</TYPE></TEMPLATE></DATASTORE>"
+end
+
+write_pool(dir, 'datastore.xml', 'DATASTORE_POOL', datastores)
+
+# ---------------------------------------------------------------------------- #
+# VM groups, the roles take the first pending VMs                             #
+# ---------------------------------------------------------------------------- #
+vm_role = {}
+groups  = []
+next_vm = 0
+
+options[:groups].times do |gid|
+    roles = ''
+
+    options[:roles].times do |rid|
+        vms = (next_vm...(next_vm + options[:role_size])).to_a
+
+        vms.each {|vid| vm_role[vid] = [gid, "role#{rid}"] }
+
+        next_vm += options[:role_size]
+
+        roles << "<ROLE><ID>#{rid}</ID><NAME>role#{rid}</NAME>" \
+                 "<POLICY>#{options[:policy]}</POLICY>" \
+                 "<VMS>#{vms.join(',')}</VMS></ROLE>"
+    end
+
+    groups << "<VM_GROUP><ID>#{gid}</ID><UID>0</UID><GID>0</GID>" \
+              "<NAME>group#{gid}</NAME>#{PERMISSIONS}" \
+              "<LOCK/><ROLES>#{roles}</ROLES><TEMPLATE/></VM_GROUP>"
+end
+
+write_pool(dir, 'vmgroup.xml', 'VM_GROUP_POOL', groups)
+
+# ---------------------------------------------------------------------------- #
+# Pending VMs                                                                 #
+# ---------------------------------------------------------------------------- #
+reqs    = clusters.map {|c| "CLUSTER_ID = #{c}" }.join(' | ')
+ds_reqs = clusters.map {|c| "\"CLUSTERS/ID\" @> #{c}" }.join(' | ')
+
+auto_reqs    = xml_escape("(#{reqs}) & !(PUBLIC_CLOUD = YES)")
+auto_ds_reqs = xml_escape("(#{ds_reqs})")
+
+vms   = []
+stime = Time.now.to_i
+
+options[:vms].times do |id|
+    extra = ''
+
+    if vm_role[id]
+        extra << "<VMGROUP><ROLE>#{vm_role[id][1]}</ROLE>" \
+                 "<VMGROUP_ID>#{vm_role[id][0]}</VMGROUP_ID></VMGROUP>"
+    end
+
+    if rand < options[:vm_pci]
+        extra << "<PCI><CLASS>0300</CLASS><DEVICE>1db4</DEVICE>" \
+                 "<VENDOR>10de</VENDOR></PCI>"
+    end
+
+    vcpu = [options[:vm_cpu].ceil, 1].max
+
+    if options[:numa_nodes] > 0 && rand < options[:vm_numa]
+        extra << "<TOPOLOGY><CORES>#{vcpu}</CORES><PIN_POLICY>THREAD</PIN_POLICY>" \
+                 "<SOCKETS>1</SOCKETS><THREADS>1</THREADS></TOPOLOGY>" \
+                 "<NUMA_NODE><MEMORY>#{options[:vm_mem] * 1024}</MEMORY>" \
+                 "<TOTAL_CPUS>#{vcpu}</TOTAL_CPUS></NUMA_NODE>"
+    end
+
+    vms << "<VM><ID>#{id}</ID><UID>0</UID><GID>0</GID><UNAME>oneadmin</UNAME>" \
+           "<GNAME>oneadmin</GNAME><NAME>vm#{id}</NAME>#{PERMISSIONS}" \
+           "<LAST_POLL>0</LAST_POLL><STATE>1</STATE><LCM_STATE>0</LCM_STATE>" \
+           "<PREV_STATE>1</PREV_STATE><PREV_LCM_STATE>0</PREV_LCM_STATE>" \
+           "<RESCHED>0</RESCHED><STIME>#{stime + id}</STIME><ETIME>0</ETIME>" \
+           "<DEPLOY_ID/><TEMPLATE>" \
+           "<AUTOMATIC_DS_REQUIREMENTS>#{auto_ds_reqs}</AUTOMATIC_DS_REQUIREMENTS>" \
+           "<AUTOMATIC_REQUIREMENTS>#{auto_reqs}</AUTOMATIC_REQUIREMENTS>" \
+           "<CPU>#{options[:vm_cpu]}</CPU><MEMORY>#{options[:vm_mem]}</MEMORY>" \
+           "<VCPU>#{vcpu}</VCPU><VMID>#{id}</VMID>#{extra}</TEMPLATE>" \
+           "<USER_TEMPLATE/><HISTORY_RECORDS/></VM>"
+end
+
+write_pool(dir, 'vm.xml', 'VM_POOL', vms)
+
+# ---------------------------------------------------------------------------- #
+# oneadmin user, no ACLs or virtual networks                                  #
+# ---------------------------------------------------------------------------- #
+write_pool(dir, 'user.xml', 'USER_POOL',
+           ["<USER><ID>0</ID><GID>0</GID><GROUPS><ID>0</ID></GROUPS>" \
+            "<GNAME>oneadmin</GNAME><NAME>oneadmin</NAME><ENABLED>1</ENABLED>" \
+            "<TEMPLATE/></USER>"])
+
+write_pool(dir, 'acl.xml', 'ACL_POOL', [])
+
+write_pool(dir, 'vnet.xml', 'VNET_POOL', [])
+
+puts "#{options[:hosts]} hosts, #{options[:vms]} VMs, #{groups.length} VM " \
+     "groups written to #{dir}"
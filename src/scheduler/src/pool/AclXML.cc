@@ -17,6 +17,8 @@
 #include "AclXML.h"
 #include "ObjectXML.h"
 #include <vector>
+#include <fstream>
+#include <functional>
 
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
@@ -25,6 +27,27 @@ int AclXML::set_up()
 {
     xmlrpc_c::value result;
 
+    if ( !fixture.empty() )
+    {
+        ifstream      file(fixture.c_str());
+        ostringstream oss;
+
+        flush_rules();
+
+        if ( !file.good() )
+        {
+            oss << "Cannot open " << fixture << ", using an empty ACL set.";
+
+            NebulaLog::log("ACL", Log::WARNING, oss);
+
+            return 0;
+        }
+
+        oss << file.rdbuf();
+
+        return load_rules(oss.str());
+    }
+
     try
     {
         client->call("one.acl.info", "", &result);
@@ -89,6 +112,8 @@ int AclXML::load_rules(const string& xml_str)
 
     acl_xml.free_nodes(rules);
 
+    signature = std::hash<string>()(xml_str);
+
     return 0;
 }
 
@@ -106,5 +131,7 @@ void AclXML::flush_rules()
 
     acl_rules.clear();
     acl_rules_oids.clear();
+
+    signature = 0;
 }
 
@@ -16,6 +16,23 @@
 
 #include "DatastorePoolXML.h"
 
+#include <algorithm>
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int DatastorePoolXML::set_up()
+{
+    int rc = PoolXML::set_up();
+
+    if ( rc == 0 )
+    {
+        build_capacity_index();
+    }
+
+    return rc;
+}
+
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
@@ -58,3 +75,54 @@ int DatastorePoolXML::load_info(xmlrpc_c::value &result)
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void DatastorePoolXML::build_capacity_index()
+{
+    capacity_index.clear();
+    unchecked.clear();
+
+    for (auto it = objects.begin(); it != objects.end(); ++it)
+    {
+        DatastoreXML * ds = static_cast<DatastoreXML *>(it->second);
+
+        if ( ds->is_shared() && ds->is_monitored() )
+        {
+            capacity_index.push_back(ds);
+        }
+        else
+        {
+            unchecked.push_back(ds);
+        }
+    }
+
+    std::stable_sort(capacity_index.begin(), capacity_index.end(),
+        [](DatastoreXML * a, DatastoreXML * b)
+        {
+            return a->get_free_mb() > b->get_free_mb();
+        });
+}
+
+/* -------------------------------------------------------------------------- */
+
+void DatastorePoolXML::get_fitting_datastores(long long vm_disk_mb,
+        vector<DatastoreXML *>& datastores) const
+{
+    datastores = unchecked;
+
+    // First datastore without enough space, see DatastoreXML::test_capacity
+    auto last = std::partition_point(capacity_index.begin(),
+        capacity_index.end(), [vm_disk_mb](DatastoreXML * ds)
+        {
+            return vm_disk_mb < ds->get_free_mb() || vm_disk_mb == 0;
+        });
+
+    datastores.insert(datastores.end(), capacity_index.begin(), last);
+
+    std::sort(datastores.begin(), datastores.end(),
+        [](DatastoreXML * a, DatastoreXML * b)
+        {
+            return a->get_oid() < b->get_oid();
+        });
+}
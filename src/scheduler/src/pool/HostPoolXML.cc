@@ -16,6 +16,8 @@
 
 #include "HostPoolXML.h"
 
+#include <algorithm>
+
 int HostPoolXML::set_up()
 {
     ostringstream   oss;
@@ -25,6 +27,8 @@ int HostPoolXML::set_up()
 
     if ( rc == 0 )
     {
+        build_capacity_index();
+
         if (NebulaLog::log_level() >= Log::DDDEBUG)
         {
             oss << "Discovered Hosts (enabled):" << endl;
@@ -128,3 +132,73 @@ void HostPoolXML::merge_clusters(ClusterPoolXML * clpool)
 
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
+
+void HostPoolXML::update_signatures()
+{
+    map<int,ObjectXML*>::iterator it;
+
+    for (it=objects.begin(); it!=objects.end(); it++)
+    {
+        static_cast<HostXML*>(it->second)->update_signature();
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void HostPoolXML::build_capacity_index()
+{
+    capacity_index.clear();
+
+    capacity_index.reserve(objects.size());
+
+    for (auto it = objects.begin(); it != objects.end(); ++it)
+    {
+        HostXML * host = static_cast<HostXML *>(it->second);
+
+        HostCapacity hc;
+
+        hc.cpu  = host->get_free_cpu();
+        hc.mem  = host->get_free_mem();
+        hc.host = host;
+
+        capacity_index.push_back(hc);
+    }
+
+    std::stable_sort(capacity_index.begin(), capacity_index.end(),
+        [](const HostCapacity& a, const HostCapacity& b)
+        {
+            return a.cpu > b.cpu;
+        });
+}
+
+/* -------------------------------------------------------------------------- */
+
+void HostPoolXML::get_fitting_hosts(const HostShareCapacity& sr,
+        vector<HostXML *>& hosts) const
+{
+    hosts.clear();
+
+    // First host without enough CPU, the hosts before it have enough CPU
+    auto last = std::partition_point(capacity_index.begin(),
+        capacity_index.end(), [&sr](const HostCapacity& hc)
+        {
+            return hc.cpu >= sr.cpu;
+        });
+
+    for (auto it = capacity_index.begin(); it != last; ++it)
+    {
+        if ( it->mem >= sr.mem )
+        {
+            hosts.push_back(it->host);
+        }
+    }
+
+    std::sort(hosts.begin(), hosts.end(), [](HostXML * a, HostXML * b)
+        {
+            return a->get_hid() < b->get_hid();
+        });
+}
@@ -18,6 +18,8 @@
 #include <sstream>
 #include <stdexcept>
 #include <iomanip>
+#include <pthread.h>
+#include <functional>
 
 #include "HostXML.h"
 #include "NebulaUtil.h"
@@ -96,10 +98,25 @@ void HostShareXML::init_attributes(ObjectXML * host)
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+/**
+ *  The NUMA test uses the node allocation counters of the host, it needs to be
+ *  serialized when VMs are matched in parallel
+ */
+static pthread_mutex_t numa_test_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 bool HostShareXML::test_capacity(HostShareCapacity &sr, string & error)
 {
     bool pci_fit  = pci.test(sr.pci);
-    bool numa_fit = numa.test(sr);
+    bool numa_fit = true;
+
+    if ( sr.topology != 0 && !sr.nodes.empty() )
+    {
+        pthread_mutex_lock(&numa_test_mutex);
+
+        numa_fit = numa.test(sr);
+
+        pthread_mutex_unlock(&numa_test_mutex);
+    }
     bool cpu_fit  = (max_cpu  - cpu_usage ) >= sr.cpu;
     bool mem_fit  = (max_mem  - mem_usage ) >= sr.mem;
 
@@ -181,6 +198,8 @@ void HostXML::init_attributes()
 
     share.init_attributes(this);
 
+    signature = 0;
+
     //-------------------- Init search xpath routes ---------------------------
     ObjectXML::paths     = host_paths;
     ObjectXML::num_paths = host_num_paths;
@@ -213,3 +232,14 @@ void HostXML::get_permissions(PoolObjectAuth& auth)
     auth.obj_type = PoolObjectSQL::HOST;
 }
 
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void HostXML::update_signature()
+{
+    ostringstream oss;
+
+    oss << static_cast<ObjectXML&>(*this);
+
+    signature = std::hash<std::string>()(oss.str());
+}
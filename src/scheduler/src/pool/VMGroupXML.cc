@@ -519,3 +519,189 @@ ostream& operator<<(ostream& os, VMGroupXML& vmg)
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+
+/**
+ *  Looks for a host for a VM of the role, moving the VM that holds a host to
+ *  other of its candidates if needed (augmenting path).
+ *    @param vm index of the VM
+ *    @param candidates hosts of each VM, higher ranked first
+ *    @param host_vm VM assigned to each host
+ *    @param vm_host host assigned to each VM (-1 if none)
+ *    @param visited hosts already considered for this augmenting path
+ *    @return true if a host was assigned to the VM
+ */
+static bool place_role_vm(unsigned int vm,
+    const std::vector<std::vector<int> >& candidates,
+    std::map<int, unsigned int>& host_vm, std::vector<int>& vm_host,
+    std::set<int>& visited)
+{
+    std::vector<int>::const_iterator it;
+
+    for ( it = candidates[vm].begin() ; it != candidates[vm].end() ; ++it )
+    {
+        if ( visited.insert(*it).second == false )
+        {
+            continue;
+        }
+
+        std::map<int, unsigned int>::iterator ht = host_vm.find(*it);
+
+        if ( ht == host_vm.end() ||
+             place_role_vm(ht->second, candidates, host_vm, vm_host, visited) )
+        {
+            host_vm[*it] = vm;
+            vm_host[vm]  = *it;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void VMGroupXML::place_antiaffined_roles(VirtualMachinePoolXML * vmpool,
+        HostPoolXML * hpool, unsigned int host_limit,
+        std::map<int, HostReservation>& reserved,
+        std::vector<std::vector<int> >& placed, std::ostringstream& oss)
+{
+    VMGroupRoles::role_iterator it;
+
+    oss << "\n";
+    oss << setfill('-') << setw(80) << '-' << setfill(' ') << "\n";
+    oss << "Anti-affined role placement\n";
+    oss << left << setw(8)<< "ROLE" << " " << left << setw(8) <<"VM"
+        << " " << left << "HOST\n"
+        << setfill('-') << setw(80) << '-' << setfill(' ') << "\n";
+
+    for ( it = roles.begin(); it != roles.end() ; ++it )
+    {
+        VMGroupRole * r = *it;
+
+        if ( r->policy() != VMGroupPolicy::ANTI_AFFINED || r->size_vms() <= 1 )
+        {
+            continue;
+        }
+
+        /* ------------------------------------------------------------------ */
+        /* Candidate hosts of the pending VMs, in ranking order               */
+        /* ------------------------------------------------------------------ */
+        std::vector<VirtualMachineXML *> vms;
+        std::vector<HostShareCapacity>   capacities;
+        std::vector<std::vector<int> >   candidates;
+
+        const std::set<int>& role_vms = r->get_vms();
+        std::set<int>::const_iterator jt;
+
+        for ( jt = role_vms.begin() ; jt != role_vms.end(); ++jt )
+        {
+            VirtualMachineXML * vm = vmpool->get(*jt);
+
+            if ( vm == 0 )
+            {
+                continue;
+            }
+
+            HostShareCapacity sr;
+            std::string       error;
+
+            std::vector<int> hosts;
+
+            const vector<Resource *> resources = vm->get_match_hosts();
+            vector<Resource *>::const_reverse_iterator rt;
+
+            vm->get_capacity(sr);
+
+            for ( rt = resources.rbegin() ; rt != resources.rend() ; ++rt )
+            {
+                HostXML * host = hpool->get((*rt)->oid);
+
+                if ( host == 0 )
+                {
+                    continue;
+                }
+
+                HostReservation& hr = reserved[host->get_hid()];
+
+                if ( host->dispatched() + hr.vms >= host_limit )
+                {
+                    continue;
+                }
+
+                // The host has to fit the VM and the ones reserved before
+                HostShareCapacity tr = sr;
+
+                tr.cpu += hr.capacity.cpu;
+                tr.mem += hr.capacity.mem;
+
+                tr.pci.insert(tr.pci.end(), hr.capacity.pci.begin(),
+                        hr.capacity.pci.end());
+
+                if ( !host->test_capacity(tr, error) )
+                {
+                    continue;
+                }
+
+                hosts.push_back(host->get_hid());
+            }
+
+            vms.push_back(vm);
+            capacities.push_back(sr);
+            candidates.push_back(hosts);
+        }
+
+        if ( vms.size() <= 1 )
+        {
+            continue;
+        }
+
+        /* ------------------------------------------------------------------ */
+        /* Assign a different host to each VM                                 */
+        /* ------------------------------------------------------------------ */
+        std::map<int, unsigned int> host_vm;
+        std::vector<int> vm_host(vms.size(), -1);
+
+        for ( unsigned int i = 0 ; i < vms.size() ; ++i )
+        {
+            std::set<int> visited;
+
+            place_role_vm(i, candidates, host_vm, vm_host, visited);
+        }
+
+        std::vector<int> role_placed;
+
+        for ( unsigned int i = 0 ; i < vms.size() ; ++i )
+        {
+            oss << left << setw(8) << r->id() << left << setw(8)
+                << vms[i]->get_oid();
+
+            if ( vm_host[i] == -1 )
+            {
+                oss << "-\n";
+                continue;
+            }
+
+            oss << vm_host[i] << "\n";
+
+            vms[i]->set_preferred_host(vm_host[i]);
+
+            HostReservation& hr = reserved[vm_host[i]];
+
+            hr.vms++;
+
+            hr.capacity.cpu += capacities[i].cpu;
+            hr.capacity.mem += capacities[i].mem;
+
+            hr.capacity.pci.insert(hr.capacity.pci.end(),
+                    capacities[i].pci.begin(), capacities[i].pci.end());
+
+            role_placed.push_back(vms[i]->get_oid());
+        }
+
+        if ( !role_placed.empty() )
+        {
+            placed.push_back(role_placed);
+        }
+    }
+}
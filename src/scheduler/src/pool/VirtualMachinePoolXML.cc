@@ -150,6 +150,11 @@ int VirtualMachinePoolXML::dispatch(int vid, int hid, int dsid, bool resched,con
 {
     xmlrpc_c::value deploy_result;
 
+    if ( is_offline() )
+    {
+        return 0;
+    }
+
     VirtualMachineXML* vm = get(vid);
 
     if (vm != 0 && vm->clear_log())
@@ -216,11 +221,203 @@ int VirtualMachinePoolXML::dispatch(int vid, int hid, int dsid, bool resched,con
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+void VirtualMachinePoolXML::queue_dispatch(int vid, int hid, int dsid,
+        bool resched, const string& extra_template)
+{
+    DispatchArgs da;
+
+    da.vid     = vid;
+    da.hid     = hid;
+    da.dsid    = dsid;
+    da.resched = resched;
+
+    da.extra_template = extra_template;
+
+    dispatch_queue.push_back(da);
+}
+
+/* -------------------------------------------------------------------------- */
+
+int VirtualMachinePoolXML::dispatch_queued(set<int>& failed)
+{
+    vector<DispatchArgs>::const_iterator first = dispatch_queue.begin();
+    vector<DispatchArgs>::const_iterator last;
+
+    if ( is_offline() )
+    {
+        first = dispatch_queue.end();
+    }
+
+    while ( deploy_multi && first != dispatch_queue.end() )
+    {
+        if ( dispatch_queue.end() - first > (long) MAX_DISPATCH_BATCH )
+        {
+            last = first + MAX_DISPATCH_BATCH;
+        }
+        else
+        {
+            last = dispatch_queue.end();
+        }
+
+        if ( dispatch_batch(first, last, failed) != 0 )
+        {
+            break;
+        }
+
+        first = last;
+    }
+
+    // Dispatch the remaining VMs one by one if the batch call failed
+    for (; first != dispatch_queue.end(); ++first)
+    {
+        if ( dispatch(first->vid, first->hid, first->dsid, first->resched,
+                    first->extra_template) != 0 )
+        {
+            failed.insert(first->vid);
+        }
+    }
+
+    int dispatched = dispatch_queue.size() - failed.size();
+
+    dispatch_queue.clear();
+
+    return dispatched;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int VirtualMachinePoolXML::dispatch_batch(
+        vector<DispatchArgs>::const_iterator first,
+        vector<DispatchArgs>::const_iterator last,
+        set<int>& failed)
+{
+    xmlrpc_c::value result;
+
+    vector<xmlrpc_c::value> vms;
+
+    for (vector<DispatchArgs>::const_iterator it = first; it != last; ++it)
+    {
+        vector<xmlrpc_c::value> vm_args;
+
+        VirtualMachineXML* vm = get(it->vid);
+
+        bool clear = vm != 0 && vm->clear_log();
+
+        vm_args.push_back(xmlrpc_c::value_int(it->vid));
+        vm_args.push_back(xmlrpc_c::value_int(it->hid));
+        vm_args.push_back(xmlrpc_c::value_int(it->dsid));
+        vm_args.push_back(xmlrpc_c::value_string(it->extra_template));
+        vm_args.push_back(xmlrpc_c::value_boolean(it->resched));
+        vm_args.push_back(xmlrpc_c::value_boolean(live_resched));
+        vm_args.push_back(xmlrpc_c::value_boolean(clear));
+
+        vms.push_back(xmlrpc_c::value_array(vm_args));
+    }
+
+    try
+    {
+        client->call("one.vm.deploymulti", "A", &result, &vms);
+    }
+    catch (exception const& e)
+    {
+        ostringstream   oss;
+
+        const ClientFault * f = dynamic_cast<const ClientFault *>(&e);
+
+        oss << "Exception raised: " << e.what() << ". Dispatching VMs with "
+            << "one.vm.deploy and one.vm.migrate";
+
+        // Only stop using the bulk call if oned does not implement it
+        if ( f != 0 && f->get_code() == xmlrpc_c::fault::CODE_NO_SUCH_METHOD )
+        {
+            deploy_multi = false;
+        }
+        else
+        {
+            oss << " in this cycle";
+        }
+
+        oss << ".";
+
+        NebulaLog::log("VM",Log::ERROR,oss);
+
+        return -1;
+    }
+
+    vector<xmlrpc_c::value> values =
+                    xmlrpc_c::value_array(result).vectorValueValue();
+
+    bool   success = xmlrpc_c::value_boolean(values[0]);
+    string message = xmlrpc_c::value_string(values[1]);
+
+    if ( !success )
+    {
+        ostringstream oss;
+
+        oss << "Error dispatching virtual machines. Reason: " << message;
+
+        NebulaLog::log("VM",Log::ERROR,oss);
+
+        for (vector<DispatchArgs>::const_iterator it = first; it != last; ++it)
+        {
+            failed.insert(it->vid);
+        }
+
+        return 0;
+    }
+
+    ObjectXML results(message);
+
+    vector<xmlNodePtr> nodes;
+
+    results.get_nodes("/DEPLOY_RESULTS/VM", nodes);
+
+    for (vector<xmlNodePtr>::iterator it = nodes.begin(); it != nodes.end();
+            ++it)
+    {
+        ObjectXML vm_result(*it);
+
+        int    vid;
+        int    vm_success;
+        string error;
+
+        vm_result.xpath(vid, "/VM/ID", -1);
+        vm_result.xpath(vm_success, "/VM/SUCCESS", 0);
+        vm_result.xpath(error, "/VM/ERROR", "");
+
+        if ( vm_success == 1 )
+        {
+            continue;
+        }
+
+        ostringstream oss;
+
+        oss << "Error deploying virtual machine " << vid << ". Reason: "
+            << error;
+
+        NebulaLog::log("VM",Log::ERROR,oss);
+
+        failed.insert(vid);
+    }
+
+    results.free_nodes(nodes);
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 int VirtualMachinePoolXML::update(int vid, const string &st) const
 {
     xmlrpc_c::value result;
     bool            success;
 
+    if ( is_offline() )
+    {
+        return 0;
+    }
+
     try
     {
         client->call("one.vm.update", "isi", &result, vid, st.c_str(), 1);
@@ -243,6 +243,8 @@ void VirtualMachineXML::init_attributes()
 
     only_public_cloud = false;
 
+    match_cache = 0;
+
     if (vm_template != 0)
     {
         init_storage_usage();
@@ -21,12 +21,16 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/types.h>
+#include <sys/resource.h>
 #include <pwd.h>
 
 #include <pthread.h>
+#include <atomic>
+#include <functional>
 
 #include <cmath>
 #include <iomanip>
+#include <iostream>
 
 #include "Scheduler.h"
 #include "SchedulerTemplate.h"
@@ -143,21 +147,7 @@ void Scheduler::start()
         throw runtime_error("Error reading configuration file.");
     }
 
-    conf.get("ONE_XMLRPC", one_xmlrpc);
-
-    conf.get("SCHED_INTERVAL", timer);
-
-    conf.get("MAX_VM", machines_limit);
-
-    conf.get("MAX_DISPATCH", dispatch_limit);
-
-    conf.get("MAX_HOST", host_dispatch_limit);
-
-    conf.get("LIVE_RESCHEDS", live_rescheds);
-
-    conf.get("MEMORY_SYSTEM_DS_SCALE", mem_ds_scale);
-
-    conf.get("DIFFERENT_VNETS", diff_vnets);
+    get_configuration(conf, live_rescheds);
 
     // -----------------------------------------------------------
     // Log system & Configuration File
@@ -313,25 +303,7 @@ void Scheduler::start()
     // -------------------------------------------------------------------------
     // Pools
     // -------------------------------------------------------------------------
-    Client * client = Client::client();
-
-    acls  = new AclXML(client, zone_id);
-    upool = new UserPoolXML(client);
-
-    hpool  = new HostPoolXML(client);
-    clpool = new ClusterPoolXML(client);
-
-    dspool     = new SystemDatastorePoolXML(client);
-    img_dspool = new ImageDatastorePoolXML(client);
-
-    vm_roles_pool = new VirtualMachineRolePoolXML(client, machines_limit);
-    vmpool = new VirtualMachinePoolXML(client, machines_limit, live_rescheds==1);
-
-    vnetpool = new VirtualNetworkPoolXML(client);
-
-    vmgpool = new VMGroupPoolXML(client);
-
-    vmapool = new VirtualMachineActionsPoolXML(client, machines_limit);
+    create_pools(Client::client(), live_rescheds == 1);
 
     // -----------------------------------------------------------
     // Load scheduler policies
@@ -410,6 +382,245 @@ void Scheduler::start()
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+int Scheduler::simulate(const string& dir)
+{
+    int    rc;
+    double t;
+
+    string etc_path;
+    unsigned int live_rescheds;
+
+    const char * nl = getenv("ONE_LOCATION");
+
+    if (nl == 0) //OpenNebula installed under root directory
+    {
+        etc_path = "/etc/one/";
+    }
+    else
+    {
+        etc_path = string(nl) + "/etc/";
+    }
+
+    SchedulerTemplate conf(etc_path);
+
+    if ( conf.load_configuration() != 0 )
+    {
+        cerr << "Error reading configuration file." << endl;
+        return -1;
+    }
+
+    get_configuration(conf, live_rescheds);
+
+    // -----------------------------------------------------------
+    // Log to the standard error, keep stdout for the results
+    // -----------------------------------------------------------
+    Log::MessageType clevel = Log::ERROR;
+
+    const VectorAttribute * log = conf.get("LOG");
+
+    if ( log != 0 )
+    {
+        int ilevel = atoi(log->vector_value("DEBUG_LEVEL").c_str());
+
+        if (Log::ERROR <= ilevel && ilevel <= Log::DDDEBUG)
+        {
+            clevel = static_cast<Log::MessageType>(ilevel);
+        }
+    }
+
+    NebulaLog::init_log_system(NebulaLog::STD, clevel, "", ios_base::trunc,
+            "mm_sched");
+
+    xmlInitParser();
+
+    // -----------------------------------------------------------
+    // Pools, loaded from the files in dir
+    // -----------------------------------------------------------
+    zone_id = 0;
+
+    create_pools(0, live_rescheds == 1);
+
+    acls->set_fixture(dir + "/acl.xml");
+    upool->set_fixture(dir + "/user.xml");
+
+    hpool->set_fixture(dir + "/host.xml");
+    clpool->set_fixture(dir + "/cluster.xml");
+
+    dspool->set_fixture(dir + "/datastore.xml");
+    img_dspool->set_fixture(dir + "/datastore.xml");
+
+    vmpool->set_fixture(dir + "/vm.xml");
+    vm_roles_pool->set_fixture(dir + "/vm.xml");
+    vmapool->set_fixture(dir + "/vm.xml");
+
+    vnetpool->set_fixture(dir + "/vnet.xml");
+
+    vmgpool->set_fixture(dir + "/vmgroup.xml");
+
+    register_policies(conf);
+
+    // -----------------------------------------------------------
+    // Scheduling cycle
+    // -----------------------------------------------------------
+    cout << fixed << setprecision(6);
+
+    profile(true);
+    rc = set_up_pools();
+    t = profile(false);
+
+    cout << "Loading pools:        " << t << "s" << endl;
+
+    if ( rc == -2 )
+    {
+        cout << "No pending VMs." << endl;
+    }
+
+    if ( rc != 0 )
+    {
+        xmlCleanupParser();
+
+        NebulaLog::finalize_log_system();
+
+        return rc == -2 ? 0 : -1;
+    }
+
+    profile(true);
+    do_vm_groups();
+    t = profile(false);
+
+    cout << "VM groups placement:  " << t << "s" << endl;
+
+    profile(true);
+    match_schedule();
+    t = profile(false);
+
+    cout << "Matching VMs:         " << t << "s" << endl;
+
+    profile(true);
+    dispatch();
+    t = profile(false);
+
+    cout << "Dispatching VMs:      " << t << "s" << endl;
+
+    // -----------------------------------------------------------
+    // Placement results
+    // -----------------------------------------------------------
+    const map<int, ObjectXML*>& vms   = vmpool->get_objects();
+    const map<int, ObjectXML*>& hosts = hpool->get_objects();
+
+    unsigned int matched    = 0;
+    unsigned int dispatched = 0;
+    unsigned int used_hosts = 0;
+    unsigned int max_vms    = 0;
+
+    map<int, ObjectXML*>::const_iterator it;
+
+    for (it = vms.begin(); it != vms.end(); ++it)
+    {
+        VirtualMachineXML * vm = static_cast<VirtualMachineXML *>(it->second);
+
+        if ( !vm->get_match_hosts().empty() )
+        {
+            matched++;
+        }
+    }
+
+    for (it = hosts.begin(); it != hosts.end(); ++it)
+    {
+        unsigned int host_vms = static_cast<HostXML *>(it->second)->dispatched();
+
+        if ( host_vms == 0 )
+        {
+            continue;
+        }
+
+        dispatched += host_vms;
+        used_hosts++;
+
+        if ( host_vms > max_vms )
+        {
+            max_vms = host_vms;
+        }
+    }
+
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+
+    cout << "Pending VMs:          " << vms.size() << endl;
+    cout << "VMs with hosts:       " << matched << endl;
+    cout << "Dispatched VMs:       " << dispatched << endl;
+    cout << "Hosts used:           " << used_hosts << " of " << hosts.size()
+         << endl;
+    cout << "Max. VMs per host:    " << max_vms << endl;
+    cout << "Peak memory:          " << usage.ru_maxrss << " KB" << endl;
+
+    xmlCleanupParser();
+
+    NebulaLog::finalize_log_system();
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void Scheduler::get_configuration(const SchedulerTemplate& conf,
+        unsigned int& live_rescheds)
+{
+    conf.get("ONE_XMLRPC", one_xmlrpc);
+
+    conf.get("SCHED_INTERVAL", timer);
+
+    conf.get("MAX_VM", machines_limit);
+
+    conf.get("MAX_DISPATCH", dispatch_limit);
+
+    conf.get("MAX_HOST", host_dispatch_limit);
+
+    conf.get("LIVE_RESCHEDS", live_rescheds);
+
+    conf.get("MEMORY_SYSTEM_DS_SCALE", mem_ds_scale);
+
+    conf.get("DIFFERENT_VNETS", diff_vnets);
+
+    conf.get("SCHED_THREADS", sched_threads);
+
+    if ( sched_threads == 0 )
+    {
+        sched_threads = 1;
+    }
+
+    conf.get("ROLE_PLACEMENT", role_placement);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void Scheduler::create_pools(Client * client, bool live_resched)
+{
+    acls  = new AclXML(client, zone_id);
+    upool = new UserPoolXML(client);
+
+    hpool  = new HostPoolXML(client);
+    clpool = new ClusterPoolXML(client);
+
+    dspool     = new SystemDatastorePoolXML(client);
+    img_dspool = new ImageDatastorePoolXML(client);
+
+    vm_roles_pool = new VirtualMachineRolePoolXML(client, machines_limit);
+    vmpool = new VirtualMachinePoolXML(client, machines_limit, live_resched);
+
+    vnetpool = new VirtualNetworkPoolXML(client);
+
+    vmgpool = new VMGroupPoolXML(client);
+
+    vmapool = new VirtualMachineActionsPoolXML(client, machines_limit);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 int Scheduler::set_up_pools()
 {
     int                             rc;
@@ -465,6 +676,8 @@ int Scheduler::set_up_pools()
 
     hpool->merge_clusters(clpool);
 
+    hpool->update_signatures();
+
     rc = acls->set_up();
 
     if ( rc != 0 )
@@ -620,6 +833,71 @@ static bool match_host(AclXML * acls, UserPoolXML * upool, VirtualMachineXML* vm
     return true;
 };
 
+/**
+ *  Computes the signature of a VM for the match cache. It includes all the VM
+ *  attributes used to match and rank hosts, the groups of the VM owner and
+ *  the ACL rules.
+ *
+ *  @param acl pool
+ *  @param users the user pool
+ *  @param vm the virtual machine
+ *  @param sr share capacity request
+ *  @return the signature
+ */
+static size_t vm_signature(AclXML * acls, UserPoolXML * upool,
+    VirtualMachineXML* vm, const HostShareCapacity &sr)
+{
+    ostringstream oss;
+
+    oss << acls->get_signature() << ":" << vm->get_uid() << ":"
+        << vm->get_gid() << ":";
+
+    UserXML * user = upool->get(vm->get_uid());
+
+    if ( user != 0 )
+    {
+        const vector<int> gids = user->get_gids();
+
+        for (auto it = gids.begin(); it != gids.end(); ++it)
+        {
+            oss << *it << ",";
+        }
+    }
+
+    oss << ":" << vm->is_resched() << ":" << vm->get_hid() << ":"
+        << vm->is_only_public_cloud() << ":" << sr.cpu << ":" << sr.mem << ":"
+        << sr.vcpu << ":" << vm->get_requirements() << ":" << vm->get_rank();
+
+    for (auto it = sr.pci.begin(); it != sr.pci.end(); ++it)
+    {
+        string * pci = (*it)->marshall();
+
+        oss << ":" << *pci;
+
+        delete pci;
+    }
+
+    if ( sr.topology != 0 )
+    {
+        string * topology = sr.topology->marshall();
+
+        oss << ":" << *topology;
+
+        delete topology;
+    }
+
+    for (auto it = sr.nodes.begin(); it != sr.nodes.end(); ++it)
+    {
+        string * node = (*it)->marshall();
+
+        oss << ":" << *node;
+
+        delete node;
+    }
+
+    return std::hash<string>()(oss.str());
+}
+
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
@@ -828,149 +1106,384 @@ static bool match_network(AclXML * acls, UserPoolXML * upool,
 
 /* -------------------------------------------------------------------------- */
 
-static void log_match(int vid, const string& msg)
+static void log_match(Scheduler::MatchContext& mc, int vid, const string& msg)
 {
     ostringstream oss;
 
     oss << "Match-making results for VM " << vid << ":\n\t" << msg << endl;
 
-    NebulaLog::log("SCHED", Log::DEBUG, oss);
+    mc.log(Log::DEBUG, oss.str());
 }
 
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
-void Scheduler::match_schedule()
+/**
+ *  Arguments of the match threads. VMs are taken in order from the pending
+ *  list, next is the index of the next VM to match.
+ */
+struct MatchThreadArgs
 {
-    VirtualMachineXML * vm;
+    Scheduler * sched;
 
-    HostShareCapacity sr;
+    const vector<VirtualMachineXML *> * vms;
 
-    int n_resources;
-    int n_matched;
-    int n_auth;
-    int n_error;
-    int n_fits;
+    std::atomic<size_t> * next;
 
-    HostXML * host;
-    DatastoreXML *ds;
-    VirtualNetworkXML *net;
+    Scheduler::MatchContext * mc;
+};
 
-    string m_error;
+extern "C" void * scheduler_match_loop(void *arg)
+{
+    MatchThreadArgs * margs = static_cast<MatchThreadArgs *>(arg);
 
-    map<int, ObjectXML*>::const_iterator  vm_it;
-    map<int, ObjectXML*>::const_iterator  obj_it;
+    size_t i;
 
-    vector<SchedulerPolicy *>::iterator it;
+    while ((i = margs->next->fetch_add(1)) < margs->vms->size())
+    {
+        margs->sched->match_vm((*margs->vms)[i], *(margs->mc));
 
-    const map<int, ObjectXML*> pending_vms = vmpool->get_objects();
-    const map<int, ObjectXML*> hosts       = hpool->get_objects();
-    const map<int, ObjectXML*> datastores  = dspool->get_objects();
-    const map<int, ObjectXML*> users       = upool->get_objects();
-    const map<int, ObjectXML*> nets        = vnetpool->get_objects();
+        margs->sched->flush_match_log(*(margs->mc));
+    }
 
-    double total_cl_match_time = 0;
-    double total_host_match_time = 0;
-    double total_host_rank_time = 0;
-    double total_ds_match_time = 0;
-    double total_ds_rank_time = 0;
-    double total_net_match_time = 0;
-    double total_net_rank_time = 0;
+    return 0;
+}
 
-    time_t stime = time(0);
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
 
-    for (vm_it=pending_vms.begin(); vm_it != pending_vms.end(); vm_it++)
+void Scheduler::flush_match_log(MatchContext& mc)
+{
+    if ( mc.logs.empty() )
     {
-        vm = static_cast<VirtualMachineXML*>(vm_it->second);
+        return;
+    }
 
-        vm->get_capacity(sr);
+    pthread_mutex_lock(&match_log_mutex);
 
-        n_resources = 0;
-        n_fits    = 0;
-        n_matched = 0;
-        n_auth    = 0;
-        n_error   = 0;
+    for (auto it = mc.logs.begin(); it != mc.logs.end(); ++it)
+    {
+        NebulaLog::log("SCHED", it->first, it->second);
+    }
 
-        //----------------------------------------------------------------------
-        // Test Image Datastore capacity, but not for migrations or resume
-        //----------------------------------------------------------------------
-        if (!vm->is_resched() && !vm->is_resume())
+    pthread_mutex_unlock(&match_log_mutex);
+
+    mc.logs.clear();
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void Scheduler::match_vm(VirtualMachineXML * vm, MatchContext& mc)
+{
+    HostShareCapacity sr;
+
+    int n_resources;
+    int n_matched;
+    int n_auth;
+    int n_error;
+    int n_fits;
+
+    HostXML * host;
+    DatastoreXML *ds;
+    VirtualNetworkXML *net;
+
+    string m_error;
+
+    map<int, ObjectXML*>::const_iterator  obj_it;
+
+    vector<SchedulerPolicy *>::iterator it;
+
+    const map<int, ObjectXML*>& hosts      = hpool->get_objects();
+    const map<int, ObjectXML*>& datastores = dspool->get_objects();
+    const map<int, ObjectXML*>& nets       = vnetpool->get_objects();
+
+    vector<HostXML *>      host_candidates;
+    vector<DatastoreXML *> ds_candidates;
+
+    // Hosts and DS without capacity are discarded by the pool capacity
+    // indexes, all are evaluated when debugging to log the reason
+    bool full_scan = NebulaLog::log_level() >= Log::DDEBUG;
+
+    struct timespec estart;
+
+    mc.vms++;
+
+    vm->get_capacity(sr);
+
+    n_resources = 0;
+    n_fits    = 0;
+    n_matched = 0;
+    n_auth    = 0;
+    n_error   = 0;
+
+    //--------------------------------------------------------------------------
+    // Test Image Datastore capacity, but not for migrations or resume
+    //--------------------------------------------------------------------------
+    if (!vm->is_resched() && !vm->is_resume())
+    {
+        if (vm->test_image_datastore_capacity(img_dspool, m_error) == false)
         {
-            if (vm->test_image_datastore_capacity(img_dspool, m_error) == false)
+            if (vm->is_public_cloud()) //No capacity needed for public cloud
+            {
+                vm->set_only_public_cloud();
+            }
+            else
             {
-                if (vm->is_public_cloud()) //No capacity needed for public cloud
+                log_match(mc, vm->get_oid(), "Cannot schedule VM. "+ m_error);
+
+                vm->log("Cannot schedule VM. "+ m_error);
+                mc.updates.push_back(vm);
+
+                return;
+            }
+        }
+    }
+
+    // -------------------------------------------------------------------------
+    // Match hosts for this VM.
+    // -------------------------------------------------------------------------
+    Log::start_timer(&estart);
+
+    if (full_scan)
+    {
+        for (obj_it=hosts.begin(); obj_it != hosts.end(); obj_it++)
+        {
+            host_candidates.push_back(static_cast<HostXML *>(obj_it->second));
+        }
+    }
+    else
+    {
+        hpool->get_fitting_hosts(sr, host_candidates);
+    }
+
+    // Matches from previous cycles are reused while the VM and the host do
+    // not change, not when debugging to log the reason of each discard
+    MatchCache::VMMatch * cache = 0;
+
+    if (!full_scan)
+    {
+        cache = match_cache.get(vm->get_oid(),
+                vm_signature(acls, upool, vm, sr));
+    }
+
+    vm->set_match_cache(cache);
+
+    for (auto h_it = host_candidates.begin(); h_it != host_candidates.end();
+            ++h_it)
+    {
+        host = *h_it;
+
+        if ( cache != 0 )
+        {
+            MatchCache::HostMatch * hm = cache->get(host->get_hid(),
+                    host->get_signature());
+
+            if ( hm != 0 )
+            {
+                n_auth    += hm->stage >= MatchCache::AUTH;
+                n_fits    += hm->stage >= MatchCache::FITS;
+                n_matched += hm->stage >= MatchCache::MATCHED;
+
+                if ( hm->stage == MatchCache::MATCHED )
                 {
-                    vm->set_only_public_cloud();
+                    vm->add_match_host(host->get_hid());
+
+                    n_resources++;
                 }
-                else
-                {
-                    log_match(vm->get_oid(), "Cannot schedule VM. "+ m_error);
 
-                    vm->log("Cannot schedule VM. "+ m_error);
-                    vmpool->update(vm);
+                continue;
+            }
+        }
 
-                    continue;
-                }
+        int stage = n_auth + n_fits + n_matched;
+
+        bool matched = match_host(acls, upool, vm, sr, host, n_auth, n_error,
+                n_fits, n_matched, m_error);
+
+        if ( cache != 0 && n_error == 0 )
+        {
+            stage = n_auth + n_fits + n_matched - stage;
+
+            cache->set(host->get_hid(), host->get_signature(),
+                    static_cast<MatchCache::MatchStage>(stage));
+        }
+
+        if (matched)
+        {
+            vm->add_match_host(host->get_hid());
+
+            n_resources++;
+        }
+        else
+        {
+            if ( n_error > 0 )
+            {
+                log_match(mc, vm->get_oid(), "Cannot schedule VM. " + m_error);
+                break;
+            }
+            else if (NebulaLog::log_level() >= Log::DDEBUG)
+            {
+                ostringstream oss;
+                oss << "Host " << host->get_hid() << " discarded for VM "
+                    << vm->get_oid() << ". " << m_error;
+
+                mc.log(Log::DDEBUG, oss.str());
             }
         }
+    }
 
-        // ---------------------------------------------------------------------
-        // Match hosts for this VM.
-        // ---------------------------------------------------------------------
-        profile(true);
+    mc.host_match += Log::stop_timer(&estart);
 
-        for (obj_it=hosts.begin(); obj_it != hosts.end(); obj_it++)
+    // -------------------------------------------------------------------------
+    // Log scheduling errors to VM user if any
+    // -------------------------------------------------------------------------
+
+    if (n_resources == 0) //No hosts assigned, let's see why
+    {
+        if (n_error == 0) //No syntax error
         {
-            host = static_cast<HostXML *>(obj_it->second);
+            if (hosts.size() == 0)
+            {
+                vm->log("No hosts enabled to run VMs");
+            }
+            else if (n_auth == 0 && host_candidates.size() == hosts.size())
+            {
+                vm->log("User is not authorized to use any host");
+            }
+            else if (n_fits == 0)
+            {
+                ostringstream oss;
+
+                oss << "No host with enough capacity to deploy the VM";
 
-            if (match_host(acls, upool, vm, sr, host, n_auth, n_error, n_fits,
-                        n_matched, m_error))
+                vm->log(oss.str());
+            }
+            else if (n_matched == 0)
             {
-                vm->add_match_host(host->get_hid());
+                ostringstream oss;
 
-                n_resources++;
+                oss << "No host meets capacity and SCHED_REQUIREMENTS: "
+                    << vm->get_requirements();
+
+                vm->log(oss.str());
             }
-            else
+        }
+
+        mc.updates.push_back(vm);
+
+        log_match(mc, vm->get_oid(),
+                "Cannot schedule VM, there is no suitable host.");
+
+        return;
+    }
+
+    // -------------------------------------------------------------------------
+    // Schedule matched hosts
+    // -------------------------------------------------------------------------
+    Log::start_timer(&estart);
+
+    for (it=host_policies.begin() ; it != host_policies.end() ; it++)
+    {
+        (*it)->schedule(vm);
+    }
+
+    vm->sort_match_hosts();
+
+    mc.host_rank += Log::stop_timer(&estart);
+
+    if (vm->is_resched())//Will use same system DS for migrations
+    {
+        vm->add_match_datastore(vm->get_dsid());
+
+        return;
+    }
+
+    // -------------------------------------------------------------------------
+    // Match datastores for this VM
+    // -------------------------------------------------------------------------
+
+    Log::start_timer(&estart);
+
+    n_resources = 0;
+    n_auth    = 0;
+    n_matched = 0;
+    n_error   = 0;
+    n_fits    = 0;
+
+    if (full_scan || vm->is_resume())
+    {
+        for (obj_it=datastores.begin(); obj_it != datastores.end(); obj_it++)
+        {
+            ds_candidates.push_back(static_cast<DatastoreXML *>(obj_it->second));
+        }
+    }
+    else
+    {
+        dspool->get_fitting_datastores(sr.disk, ds_candidates);
+    }
+
+    for (auto ds_it = ds_candidates.begin(); ds_it != ds_candidates.end();
+            ++ds_it)
+    {
+        ds = *ds_it;
+
+        if (match_system_ds(acls, upool, vm, sr.disk, ds, n_auth, n_error,
+                    n_fits, n_matched, m_error))
+        {
+            vm->add_match_datastore(ds->get_oid());
+
+            n_resources++;
+        }
+        else
+        {
+            if (n_error > 0)
             {
-                if ( n_error > 0 )
-                {
-                    log_match(vm->get_oid(), "Cannot schedule VM. " + m_error);
-                    break;
-                }
-                else if (NebulaLog::log_level() >= Log::DDEBUG)
-                {
-                    ostringstream oss;
-                    oss << "Host " << host->get_hid() << " discarded for VM "
-                        << vm->get_oid() << ". " << m_error;
+                log_match(mc, vm->get_oid(), "Cannot schedule VM. " + m_error);
+                break;
+            }
+            else if (NebulaLog::log_level() >= Log::DDEBUG)
+            {
+                ostringstream oss;
+                oss << "System DS " << ds->get_oid() << " discarded for VM "
+                    << vm->get_oid() << ". " << m_error;
 
-                    NebulaLog::log("SCHED", Log::DDEBUG, oss);
-                }
+                mc.log(Log::DDEBUG, oss.str());
             }
         }
+    }
 
-        total_host_match_time += profile(false);
+    mc.ds_match += Log::stop_timer(&estart);
 
-        // ---------------------------------------------------------------------
-        // Log scheduling errors to VM user if any
-        // ---------------------------------------------------------------------
+    // -------------------------------------------------------------------------
+    // Log scheduling errors to VM user if any
+    // -------------------------------------------------------------------------
 
-        if (n_resources == 0) //No hosts assigned, let's see why
+    if (n_resources == 0)
+    {
+        if (vm->is_public_cloud())//Public clouds don't need a system DS
+        {
+            vm->set_only_public_cloud();
+
+            return;
+        }
+        else//No datastores assigned, let's see why
         {
-            if (n_error == 0) //No syntax error
+            if (n_error == 0)//No syntax error
             {
-                if (hosts.size() == 0)
+                if (datastores.size() == 0)
                 {
-                    vm->log("No hosts enabled to run VMs");
+                    vm->log("No system datastores found to run VMs");
                 }
-                else if (n_auth == 0)
+                else if (n_auth == 0 &&
+                         ds_candidates.size() == datastores.size())
                 {
-                    vm->log("User is not authorized to use any host");
+                    vm->log("User is not authorized to use any system datastore");
                 }
                 else if (n_fits == 0)
                 {
                     ostringstream oss;
-
-                    oss << "No host with enough capacity to deploy the VM";
+                    oss <<  "No system datastore with enough capacity for the VM";
 
                     vm->log(oss.str());
                 }
@@ -978,62 +1491,68 @@ void Scheduler::match_schedule()
                 {
                     ostringstream oss;
 
-                    oss << "No host meets capacity and SCHED_REQUIREMENTS: "
-                        << vm->get_requirements();
+                    oss << "No system datastore meets capacity "
+                        << "and SCHED_DS_REQUIREMENTS: "
+                        << vm->get_ds_requirements();
 
                     vm->log(oss.str());
                 }
             }
 
-            vmpool->update(vm);
+            vm->clear_match_hosts();
 
-            log_match(vm->get_oid(),
-                    "Cannot schedule VM, there is no suitable host.");
+            mc.updates.push_back(vm);
 
-            continue;
+            log_match(mc, vm->get_oid(), "Cannot schedule VM, there is no "
+                "suitable system ds.");
+
+            return;
         }
+    }
 
-        // ---------------------------------------------------------------------
-        // Schedule matched hosts
-        // ---------------------------------------------------------------------
-        profile(true);
+    // -------------------------------------------------------------------------
+    // Schedule matched datastores
+    // -------------------------------------------------------------------------
 
-        for (it=host_policies.begin() ; it != host_policies.end() ; it++)
-        {
-            (*it)->schedule(vm);
-        }
+    Log::start_timer(&estart);
 
-        vm->sort_match_hosts();
+    for (it=ds_policies.begin() ; it != ds_policies.end() ; it++)
+    {
+        (*it)->schedule(vm);
+    }
 
-        total_host_rank_time += profile(false);
+    vm->sort_match_datastores();
 
-        if (vm->is_resched())//Will use same system DS for migrations
-        {
-            vm->add_match_datastore(vm->get_dsid());
+    mc.ds_rank += Log::stop_timer(&estart);
 
-            continue;
-        }
+    // -------------------------------------------------------------------------
+    // Match Networks for this VM
+    // -------------------------------------------------------------------------
 
-        // ---------------------------------------------------------------------
-        // Match datastores for this VM
-        // ---------------------------------------------------------------------
+    set<int>::iterator it_nic;
+    set<int> nics_ids = vm->get_nics_ids();
 
-        profile(true);
+    for (it_nic = nics_ids.begin(); it_nic != nics_ids.end(); ++it_nic)
+    {
+        Log::start_timer(&estart);
 
         n_resources = 0;
+
         n_auth    = 0;
         n_matched = 0;
         n_error   = 0;
         n_fits    = 0;
 
-        for (obj_it=datastores.begin(); obj_it != datastores.end(); obj_it++)
+        int nic_id = *it_nic;
+
+        for (obj_it = nets.begin(); obj_it != nets.end(); ++obj_it)
         {
-            ds = static_cast<DatastoreXML *>(obj_it->second);
+            net = static_cast<VirtualNetworkXML *>(obj_it->second);
 
-            if (match_system_ds(acls, upool, vm, sr.disk, ds, n_auth, n_error,
+            if (match_network(acls, upool, vm, nic_id, net, n_auth, n_error,
                         n_fits, n_matched, m_error))
             {
-                vm->add_match_datastore(ds->get_oid());
+                vm->add_match_network(net->get_oid(), nic_id);
 
                 n_resources++;
             }
@@ -1041,226 +1560,214 @@ void Scheduler::match_schedule()
             {
                 if (n_error > 0)
                 {
-                    log_match(vm->get_oid(), "Cannot schedule VM. " + m_error);
+                    log_match(mc, vm->get_oid(), "Cannot schedule VM. " + m_error);
                     break;
                 }
                 else if (NebulaLog::log_level() >= Log::DDEBUG)
                 {
                     ostringstream oss;
-                    oss << "System DS " << ds->get_oid() << " discarded for VM "
-                        << vm->get_oid() << ". " << m_error;
+                    oss << "Network " << net->get_oid() << " discarded for VM "
+                        << vm->get_oid() << " and NIC " << nic_id << ". " << m_error;
 
-                    NebulaLog::log("SCHED", Log::DDEBUG, oss);
+                    mc.log(Log::DDEBUG, oss.str());
                 }
             }
         }
 
-        total_ds_match_time += profile(false);
-
-        // ---------------------------------------------------------------------
-        // Log scheduling errors to VM user if any
-        // ---------------------------------------------------------------------
+        mc.net_match += Log::stop_timer(&estart);
 
         if (n_resources == 0)
         {
-            if (vm->is_public_cloud())//Public clouds don't need a system DS
-            {
-                vm->set_only_public_cloud();
-
-                continue;
-            }
-            else//No datastores assigned, let's see why
+            if (n_error == 0)//No syntax error
             {
-                if (n_error == 0)//No syntax error
+                if (nets.size() == 0)
                 {
-                    if (datastores.size() == 0)
-                    {
-                        vm->log("No system datastores found to run VMs");
-                    }
-                    else if (n_auth == 0)
-                    {
-                        vm->log("User is not authorized to use any system datastore");
-                    }
-                    else if (n_fits == 0)
-                    {
-                        ostringstream oss;
-                        oss <<  "No system datastore with enough capacity for the VM";
-
-                        vm->log(oss.str());
-                    }
-                    else if (n_matched == 0)
-                    {
-                        ostringstream oss;
+                    vm->log("No networks found to run VMs");
+                }
+                else if (n_auth == 0)
+                {
+                    vm->log("User is not authorized to use any network");
+                }
+                else if (n_fits == 0)
+                {
+                    vm->log("No network with enough capacity for the VM");
+                }
+                else if (n_matched == 0)
+                {
+                    ostringstream oss;
 
-                        oss << "No system datastore meets capacity "
-                            << "and SCHED_DS_REQUIREMENTS: "
-                            << vm->get_ds_requirements();
+                    oss << "No network meet leases "
+                        << "and SCHED_NIC_REQUIREMENTS: "
+                        << vm->get_nic_requirements(nic_id);
 
-                        vm->log(oss.str());
-                    }
+                    vm->log(oss.str());
                 }
+            }
 
-                vm->clear_match_hosts();
+            vm->clear_match_hosts();
+            vm->clear_match_datastores();
 
-                vmpool->update(vm);
+            mc.updates.push_back(vm);
 
-                log_match(vm->get_oid(), "Cannot schedule VM, there is no suitable "
-                    "system ds.");
+            log_match(mc, vm->get_oid(), "Cannot schedule VM, there is no "
+                "suitable network.");
 
-                continue;
-            }
+            break;
         }
 
-        // ---------------------------------------------------------------------
-        // Schedule matched datastores
-        // ---------------------------------------------------------------------
-
-        profile(true);
+        Log::start_timer(&estart);
 
-        for (it=ds_policies.begin() ; it != ds_policies.end() ; it++)
+        for (it = nic_policies.begin() ; it != nic_policies.end() ; it++)
         {
-            (*it)->schedule(vm);
+            (*it)->schedule(vm->get_nic(nic_id));
         }
 
-        vm->sort_match_datastores();
+        vm->sort_match_networks(nic_id);
 
-        total_ds_rank_time += profile(false);
-
-        // ---------------------------------------------------------------------
-        // Match Networks for this VM
-        // ---------------------------------------------------------------------
-
-        profile(true);
+        mc.net_rank += Log::stop_timer(&estart);
+    }
+}
 
-        set<int>::iterator it_nic;
-        set<int> nics_ids = vm->get_nics_ids();
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
 
-        bool not_matched = false;
+void Scheduler::match_schedule()
+{
+    VirtualMachineXML * vm;
 
-        for (it_nic = nics_ids.begin(); it_nic != nics_ids.end(); ++it_nic)
-        {
-            n_resources = 0;
+    map<int, ObjectXML*>::const_iterator  vm_it;
 
-            n_auth    = 0;
-            n_matched = 0;
-            n_error   = 0;
-            n_fits    = 0;
+    const map<int, ObjectXML*> pending_vms = vmpool->get_objects();
 
-            int nic_id = *it_nic;
+    vector<VirtualMachineXML *> vms;
 
-            for (obj_it = nets.begin(); obj_it != nets.end(); ++obj_it)
-            {
-                net = static_cast<VirtualNetworkXML *>(obj_it->second);
+    std::atomic<size_t> next(0);
 
-                if (match_network(acls, upool, vm, nic_id, net, n_auth, n_error,
-                            n_fits, n_matched, m_error))
-                {
-                    vm->add_match_network(net->get_oid(), nic_id);
+    struct timespec estart;
 
-                    n_resources++;
-                }
-                else
-                {
-                    if (n_error > 0)
-                    {
-                        log_match(vm->get_oid(), "Cannot schedule VM. " + m_error);
-                        break;
-                    }
-                    else if (NebulaLog::log_level() >= Log::DDEBUG)
-                    {
-                        ostringstream oss;
-                        oss << "Network " << net->get_oid() << " discarded for VM "
-                            << vm->get_oid() << " and NIC " << nic_id << ". " << m_error;
-
-                        NebulaLog::log("SCHED", Log::DDEBUG, oss);
-                    }
-                }
-            }
-
-            if (n_resources == 0)
-            {
-                if (n_error == 0)//No syntax error
-                {
-                    if (nets.size() == 0)
-                    {
-                        vm->log("No networks found to run VMs");
-                    }
-                    else if (n_auth == 0)
-                    {
-                        vm->log("User is not authorized to use any network");
-                    }
-                    else if (n_fits == 0)
-                    {
-                        vm->log("No network with enough capacity for the VM");
-                    }
-                    else if (n_matched == 0)
-                    {
-                        ostringstream oss;
+    for (vm_it=pending_vms.begin(); vm_it != pending_vms.end(); vm_it++)
+    {
+        vms.push_back(static_cast<VirtualMachineXML*>(vm_it->second));
+    }
 
-                        oss << "No network meet leases "
-                            << "and SCHED_NIC_REQUIREMENTS: "
-                            << vm->get_nic_requirements(nic_id);
+    match_cache.set_up(pending_vms);
 
-                        vm->log(oss.str());
-                    }
-                }
+    unsigned int num_threads = sched_threads;
 
-                vm->clear_match_hosts();
-                vm->clear_match_datastores();
+    if ( num_threads > vms.size() )
+    {
+        num_threads = vms.size();
+    }
 
-                vmpool->update(vm);
+    if ( num_threads == 0 )
+    {
+        num_threads = 1;
+    }
 
-                log_match(vm->get_oid(), "Cannot schedule VM, there is no "
-                    "suitable network.");
+    vector<MatchContext>    contexts(num_threads);
+    vector<MatchThreadArgs> margs(num_threads);
+    vector<pthread_t>       threads(num_threads);
+    vector<bool>            started(num_threads, false);
 
-                break;
+    Log::start_timer(&estart);
 
-                not_matched = true;
-            }
+    // -------------------------------------------------------------------------
+    // Match the pending VMs, the calling thread is the first match thread
+    // -------------------------------------------------------------------------
+    for (unsigned int i = 0; i < num_threads; i++)
+    {
+        margs[i].sched = this;
+        margs[i].vms   = &vms;
+        margs[i].next  = &next;
+        margs[i].mc    = &contexts[i];
+    }
 
-            profile(true);
+    for (unsigned int i = 1; i < num_threads; i++)
+    {
+        if (pthread_create(&threads[i], 0, scheduler_match_loop, &margs[i])!=0)
+        {
+            NebulaLog::log("SCHED", Log::ERROR, "Could not start match thread");
+            break;
+        }
 
-            for (it = nic_policies.begin() ; it != nic_policies.end() ; it++)
-            {
-                (*it)->schedule(vm->get_nic(nic_id));
-            }
+        started[i] = true;
+    }
 
-            vm->sort_match_networks(nic_id);
+    scheduler_match_loop(&margs[0]);
 
-            total_net_rank_time += profile(false);
+    for (unsigned int i = 1; i < num_threads; i++)
+    {
+        if (started[i])
+        {
+            pthread_join(threads[i], 0);
         }
+    }
+
+    double total_time = Log::stop_timer(&estart);
 
-        if ( not_matched )
+    // -------------------------------------------------------------------------
+    // Update the scheduling messages of the VMs in oned
+    // -------------------------------------------------------------------------
+    for (auto mc = contexts.begin(); mc != contexts.end(); ++mc)
+    {
+        for (auto uvm = mc->updates.begin(); uvm != mc->updates.end(); ++uvm)
         {
-            continue;
+            vmpool->update(*uvm);
         }
-
-        total_net_match_time += profile(false);
     }
 
     if (NebulaLog::log_level() >= Log::DDEBUG)
     {
         ostringstream oss;
 
+        MatchContext total;
+
+        for (auto mc = contexts.begin(); mc != contexts.end(); ++mc)
+        {
+            total.vms        += mc->vms;
+            total.host_match += mc->host_match;
+            total.host_rank  += mc->host_rank;
+            total.ds_match   += mc->ds_match;
+            total.ds_rank    += mc->ds_rank;
+            total.net_match  += mc->net_match;
+            total.net_rank   += mc->net_rank;
+        }
+
         oss << "Match Making statistics:\n"
             << "\tNumber of VMs:             "
             << pending_vms.size() << endl
+            << "\tNumber of threads:         "
+            << num_threads << endl
             << "\tTotal time:                "
-            << one_util::float_to_str(time(0) - stime)       << "s" << endl
-            << "\tTotal Cluster Match time:  "
-            << one_util::float_to_str(total_cl_match_time)   << "s" << endl
+            << one_util::float_to_str(total_time)       << "s" << endl
             << "\tTotal Host Match time:     "
-            << one_util::float_to_str(total_host_match_time) << "s" << endl
+            << one_util::float_to_str(total.host_match) << "s" << endl
             << "\tTotal Host Ranking time:   "
-            << one_util::float_to_str(total_host_rank_time)  << "s" << endl
+            << one_util::float_to_str(total.host_rank)  << "s" << endl
             << "\tTotal DS Match time:       "
-            << one_util::float_to_str(total_ds_match_time)   << "s" << endl
+            << one_util::float_to_str(total.ds_match)   << "s" << endl
             << "\tTotal DS Ranking time:     "
-            << one_util::float_to_str(total_ds_rank_time)    << "s" << endl
+            << one_util::float_to_str(total.ds_rank)    << "s" << endl
             << "\tTotal Network Match time:  "
-            << one_util::float_to_str(total_net_match_time)   << "s" << endl
+            << one_util::float_to_str(total.net_match)  << "s" << endl
             << "\tTotal Network Ranking time:"
-            << one_util::float_to_str(total_net_rank_time)    << "s" << endl;
+            << one_util::float_to_str(total.net_rank)   << "s" << endl;
+
+        if ( num_threads > 1 )
+        {
+            for (unsigned int i = 0; i < num_threads; i++)
+            {
+                oss << "\tThread " << i << ": "
+                    << contexts[i].vms << " VMs"
+                    << ", host match " << one_util::float_to_str(contexts[i].host_match)
+                    << "s, host rank " << one_util::float_to_str(contexts[i].host_rank)
+                    << "s, ds match "  << one_util::float_to_str(contexts[i].ds_match)
+                    << "s, ds rank "   << one_util::float_to_str(contexts[i].ds_rank)
+                    << "s, net match " << one_util::float_to_str(contexts[i].net_match)
+                    << "s, net rank "  << one_util::float_to_str(contexts[i].net_rank)
+                    << "s" << endl;
+            }
+        }
 
         NebulaLog::log("SCHED", Log::DDEBUG, oss);
     }
@@ -1304,7 +1811,8 @@ void Scheduler::dispatch()
     bool dispatched, matched;
     char * estr;
 
-    vector<Resource *>::const_reverse_iterator i, j, k, n;
+    vector<Resource *>::const_reverse_iterator i, j, n;
+    vector<Resource *>::const_iterator k;
 
     vector<SchedulerPolicy *>::iterator sp_it;
 
@@ -1322,6 +1830,85 @@ void Scheduler::dispatch()
 
     const vector<Resource *> vm_rs = vmpool->get_vm_resources();
 
+    //--------------------------------------------------------------------------
+    // Dispatch order by priority. The VMs of a placed role are dispatched
+    // together when the first one is reached (role_start holds its size)
+    //--------------------------------------------------------------------------
+    vector<Resource *>     vm_order;
+    map<int, unsigned int> role_start;
+
+    unsigned int role_left = 0;
+
+    vector<vector<int> > placed;
+
+    if ( role_placement )
+    {
+        place_vm_groups(placed);
+    }
+
+    if ( placed.empty() )
+    {
+        vm_order.assign(vm_rs.rbegin(), vm_rs.rend());
+    }
+    else
+    {
+        map<int, Resource *> vm_index;
+        map<int, unsigned int> vm_role;
+
+        set<unsigned int> added_roles;
+
+        for (k = vm_rs.begin(); k != vm_rs.end(); ++k)
+        {
+            vm_index.insert(make_pair((*k)->oid, *k));
+        }
+
+        for (unsigned int r = 0; r < placed.size(); ++r)
+        {
+            for (auto it = placed[r].begin(); it != placed[r].end(); ++it)
+            {
+                vm_role.insert(make_pair(*it, r));
+            }
+        }
+
+        for (i = vm_rs.rbegin(); i != vm_rs.rend(); ++i)
+        {
+            auto rt = vm_role.find((*i)->oid);
+
+            if ( rt == vm_role.end() )
+            {
+                vm_order.push_back(*i);
+                continue;
+            }
+
+            if ( added_roles.insert(rt->second).second == false )
+            {
+                continue;
+            }
+
+            unsigned int role_size = 1;
+
+            vm_order.push_back(*i);
+
+            const vector<int>& role_vms = placed[rt->second];
+
+            for (auto it = role_vms.begin(); it != role_vms.end(); ++it)
+            {
+                auto vt = vm_index.find(*it);
+
+                if ( *it == (*i)->oid || vt == vm_index.end() )
+                {
+                    continue;
+                }
+
+                vm_order.push_back(vt->second);
+
+                role_size++;
+            }
+
+            role_start.insert(make_pair((*i)->oid, role_size));
+        }
+    }
+
     //--------------------------------------------------------------------------
     dss << "Dispatching VMs to hosts:\n"
         << "\tVMID\tPriority\tHost\tSystem DS\n"
@@ -1329,13 +1916,27 @@ void Scheduler::dispatch()
     //--------------------------------------------------------------------------
 
     //--------------------------------------------------------------------------
-    // Dispatch each VM till we reach the dispatch limit
+    // Dispatch each VM till we reach the dispatch limit, roles are not split
     //--------------------------------------------------------------------------
-    for (k = vm_rs.rbegin(); k != vm_rs.rend() &&
-            ( dispatch_limit <= 0 || dispatched_vms < dispatch_limit ); ++k)
+    for (k = vm_order.begin(); k != vm_order.end() && ( role_left > 0 ||
+            dispatch_limit <= 0 || dispatched_vms < dispatch_limit ); ++k)
     {
         dispatched = false;
 
+        if ( role_left > 0 )
+        {
+            role_left--;
+        }
+        else
+        {
+            auto rs = role_start.find((*k)->oid);
+
+            if ( rs != role_start.end() )
+            {
+                role_left = rs->second - 1;
+            }
+        }
+
         vm = vmpool->get((*k)->oid);
 
         const vector<Resource *> resources = vm->get_match_hosts();
@@ -1606,21 +2207,12 @@ void Scheduler::dispatch()
             }
 
             //------------------------------------------------------------------
-            // Dispatch and update host and DS capacity, and dispatch counters
+            // Dispatch and update host and DS capacity, and dispatch counters.
+            // VMs are dispatched in batches at the end of the loop, the
+            // capacity of VMs that fail to deploy is released next cycle
             //------------------------------------------------------------------
-            if (vmpool->dispatch((*k)->oid, hid, dsid, vm->is_resched(), extra.str()) != 0)
-            {
-                map<int,int>::iterator it;
-
-                for ( it = matched_networks.begin(); it != matched_networks.end(); it++)
-                {
-                    net = vnetpool->get(it->first);
-
-                    net->rollback_leases(it->second);
-                }
-
-                continue;
-            }
+            vmpool->queue_dispatch((*k)->oid, hid, dsid, vm->is_resched(),
+                    extra.str());
 
             //------------------------------------------------------------------
             dss << "\t" << (*k)->oid << "\t" << (*k)->priority << "\t\t" << hid
@@ -1694,10 +2286,24 @@ void Scheduler::dispatch()
         }
     }
 
-    if (k != vm_rs.rend())
+    set<int> failed;
+
+    vmpool->dispatch_queued(failed);
+
+    if (!failed.empty())
+    {
+        dss << endl << failed.size() << " VMs failed to deploy:";
+
+        for (set<int>::iterator it = failed.begin(); it != failed.end(); ++it)
+        {
+            dss << " " << *it;
+        }
+    }
+
+    if (k != vm_order.end())
     {
         dss << endl << "MAX_DISPATCH limit of " << dispatch_limit << " reached, "
-            << std::distance(k, vm_rs.rend())
+            << std::distance(k, vm_order.cend())
             << " VMs were not dispatched";
     }
 
@@ -1829,6 +2435,33 @@ void Scheduler::do_vm_groups()
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+void Scheduler::place_vm_groups(vector<vector<int> >& placed)
+{
+    map<int, ObjectXML*>::const_iterator it;
+    const map<int, ObjectXML*> vmgrps = vmgpool->get_objects();
+
+    map<int, VMGroupXML::HostReservation> reserved;
+
+    ostringstream oss;
+
+    oss << "VM Group role placement\n";
+
+    for (it = vmgrps.begin(); it != vmgrps.end() ; ++it)
+    {
+        VMGroupXML * grp = static_cast<VMGroupXML*>(it->second);
+
+        oss << "VM GROUP " << grp->get_oid() << ", " << grp->get_name();
+
+        grp->place_antiaffined_roles(vmpool, hpool, host_dispatch_limit,
+                reserved, placed, oss);
+    }
+
+    NebulaLog::log("VMGRP", Log::DDDEBUG, oss);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 void Scheduler::timer_action(const ActionRequest& ar)
 {
     int rc;
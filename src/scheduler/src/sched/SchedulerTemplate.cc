@@ -44,6 +44,8 @@ void SchedulerTemplate::set_conf_default()
 #  DEFAULT_SCHED
 #  DEFAULT_DS_SCHED
 #  LIVE_RESCHEDS
+#  SCHED_THREADS
+#  ROLE_PLACEMENT
 #  LOG
 #-------------------------------------------------------------------------------
 */
@@ -95,6 +97,12 @@ void SchedulerTemplate::set_conf_default()
     attribute = new SingleAttribute("LIVE_RESCHEDS",value);
     conf_default.insert(make_pair(attribute->name(),attribute));
 
+    //SCHED_THREADS
+    value = "1";
+
+    attribute = new SingleAttribute("SCHED_THREADS",value);
+    conf_default.insert(make_pair(attribute->name(),attribute));
+
     //DEFAULT_SCHED
     vvalue.clear();
     vvalue.insert(make_pair("POLICY","1"));
@@ -128,6 +136,12 @@ void SchedulerTemplate::set_conf_default()
     attribute = new SingleAttribute("DIFFERENT_VNETS",value);
     conf_default.insert(make_pair(attribute->name(),attribute));
 
+    //ROLE_PLACEMENT
+    value = "NO";
+
+    attribute = new SingleAttribute("ROLE_PLACEMENT",value);
+    conf_default.insert(make_pair(attribute->name(),attribute));
+
     //LOG CONFIGURATION
     vvalue.clear();
     vvalue.insert(make_pair("SYSTEM","file"));
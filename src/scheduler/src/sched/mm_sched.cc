@@ -20,16 +20,73 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <getopt.h>
 
 #include <iostream>
 #include <sstream>
 
+static void print_usage(ostream& str)
+{
+    str << "Usage: mm_sched [-h] [-s <dir>]\n";
+}
+
+static void print_help()
+{
+    print_usage(cout);
+
+    cout << "\n"
+         << "SYNOPSIS\n"
+         << "  Starts the OpenNebula scheduler\n\n"
+         << "OPTIONS\n"
+         << "  -h, --help\tdisplay this help and exit\n"
+         << "  -s, --simulate <dir>\trun a scheduling cycle with the pools in\n"
+         << "\t\t\tthe XML files of <dir>, nothing is sent to oned\n";
+}
+
+/* ------------------------------------------------------------------------- */
+/* ------------------------------------------------------------------------- */
+
 int main(int argc, char **argv)
 {
+    int    opt;
+    string simulate;
+
+    static struct option long_options[] = {
+        {"help",     no_argument,       0, 'h'},
+        {"simulate", required_argument, 0, 's'},
+        {0,          0,                 0, 0}
+    };
+
+    int long_index = 0;
+
+    while ((opt = getopt_long(argc, argv, "hs:",
+                    long_options, &long_index)) != -1)
+    {
+        switch(opt)
+        {
+            case 'h':
+                print_help();
+                exit(0);
+                break;
+            case 's':
+                simulate = optarg;
+                break;
+            default:
+                print_usage(cerr);
+                exit(-1);
+                break;
+        }
+    }
+
     Scheduler& sched = Scheduler::instance(new RankScheduler());
 
     try
     {
+        if ( !simulate.empty() )
+        {
+            return sched.simulate(simulate);
+        }
+
         sched.start();
     }
     catch (exception &e)
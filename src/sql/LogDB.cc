@@ -22,11 +22,23 @@
 #include "RaftManager.h"
 #include "FedReplicaManager.h"
 
+#include <fstream>
+#include <errno.h>
+#include <algorithm>
+
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
 const char * LogDB::table = "logdb";
 
+const unsigned int LogDB::max_apply_group = 100;
+
+const unsigned int LogDB::purge_chunk = 1000;
+
+const unsigned int LogDB::tail_size = 1000;
+
+const size_t LogDB::snapshot_batch = 1048576;
+
 const char * LogDB::db_names = "log_index, term, sqlcmd, timestamp, fed_index, applied";
 
 const char * LogDB::db_bootstrap = "CREATE TABLE IF NOT EXISTS "
@@ -66,8 +78,6 @@ int LogDBRecord::select_cb(void *nil, int num, char **values, char **names)
         return -1;
     }
 
-    std::string zsql;
-
     std::string * _sql;
 
     std::istringstream iss;
@@ -121,14 +131,87 @@ int LogDBRecord::select_cb(void *nil, int num, char **values, char **names)
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+int LogDBRecord::get_zsql(std::string& data) const
+{
+    if ( !zsql.empty() || sql.empty() )
+    {
+        data = zsql;
+        return 0;
+    }
+
+    std::string * _zsql = one_util::zlib_compress(sql, true);
+
+    if ( _zsql == 0 )
+    {
+        return -1;
+    }
+
+    data = *_zsql;
+
+    delete _zsql;
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int LogDBRecord::set_sql(const std::string& data, int format)
+{
+    zsql.clear();
+
+    switch (format)
+    {
+        case SQL_PLAIN:
+            sql = data;
+            return 0;
+
+        case SQL_ZLIB:
+            if ( data.empty() )
+            {
+                sql.clear();
+                return 0;
+            }
+            break;
+
+        default:
+            return -1;
+    }
+
+    std::string * _sql = one_util::zlib_decompress(data, true);
+
+    if ( _sql == 0 )
+    {
+        return -1;
+    }
+
+    sql  = *_sql;
+    zsql = data;
+
+    delete _sql;
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 LogDB::LogDB(SqlDB * _db, bool _solo, bool _cache, uint64_t _lret, uint64_t _lp):
     solo(_solo), cache(_cache), db(_db), next_index(0), last_applied(-1),
-    last_index(-1), last_term(-1), log_retention(_lret), limit_purge(_lp)
+    last_index(-1), last_term(-1), log_retention(_lret), limit_purge(_lp),
+    purging(false), purge_next(0), purge_end(0), fed_purge_end(0), purged(0),
+    fed_purged(0)
 {
     uint64_t r, i;
 
     pthread_mutex_init(&mutex, 0);
 
+    pthread_mutex_init(&tail_mutex, 0);
+
+    pthread_cond_init(&last_cond, 0);
+
+    tail.resize(tail_size);
+
     LogDBRecord lr;
 
     if ( get_log_record(0, lr) != 0 )
@@ -146,6 +229,10 @@ LogDB::LogDB(SqlDB * _db, bool _solo, bool _cache, uint64_t _lret, uint64_t _lp)
 LogDB::~LogDB()
 {
     delete db;
+
+    pthread_mutex_destroy(&tail_mutex);
+
+    pthread_cond_destroy(&last_cond);
 };
 
 /* -------------------------------------------------------------------------- */
@@ -159,7 +246,7 @@ int LogDB::setup_index(uint64_t& _last_applied, uint64_t& _last_index)
 
     single_cb<uint64_t> cb;
 
-    LogDBRecord lr;
+    unsigned int _last_term;
 
     _last_applied = 0;
     _last_index   = UINT64_MAX;
@@ -195,11 +282,11 @@ int LogDB::setup_index(uint64_t& _last_applied, uint64_t& _last_index)
         last_applied = _last_applied;
     }
 
-    rc += get_log_record(last_index, lr);
+    rc += get_log_term(last_index, _last_term);
 
     if ( rc == 0 )
     {
-        last_term = lr.term;
+        last_term = _last_term;
     }
 
     build_federated_index();
@@ -216,6 +303,11 @@ int LogDB::get_log_record(uint64_t index, LogDBRecord& lr)
 {
     ostringstream oss;
 
+    if ( tail_get(index, lr) )
+    {
+        return 0;
+    }
+
     uint64_t prev_index = index - 1;
 
     if ( index == 0 )
@@ -245,6 +337,62 @@ int LogDB::get_log_record(uint64_t index, LogDBRecord& lr)
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+int LogDB::get_log_term(uint64_t index, unsigned int& term)
+{
+    ostringstream oss;
+
+    single_cb<unsigned int> cb;
+
+    oss << "SELECT term FROM logdb WHERE log_index = " << index;
+
+    cb.set_callback(&term);
+
+    int rc = db->exec_rd(oss, &cb);
+
+    cb.unset_callback();
+
+    if ( cb.get_affected_rows() == 0 )
+    {
+        rc = -1;
+    }
+
+    return rc;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+uint64_t LogDB::get_first_index()
+{
+    ostringstream oss;
+
+    single_cb<uint64_t> cb;
+
+    uint64_t index = 0;
+
+    // Last record without its previous one, those up to it cannot be sent
+    oss << "SELECT c.log_index FROM logdb c WHERE c.log_index > 0"
+        << " AND NOT EXISTS (SELECT p.log_index FROM logdb p"
+        << " WHERE p.log_index = c.log_index - 1)"
+        << " ORDER BY c.log_index DESC LIMIT 1";
+
+    cb.set_callback(&index);
+
+    int rc = db->exec_rd(oss, &cb);
+
+    cb.unset_callback();
+
+    if ( rc != 0 || index == 0 )
+    {
+        return 0;
+    }
+
+    return index + 1;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 void LogDB::get_last_record_index(uint64_t& _i, unsigned int& _t)
 {
     pthread_mutex_lock(&mutex);
@@ -305,11 +453,9 @@ int LogDB::update_raft_state(std::string name, std::string& raft_xml)
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
-int LogDB::insert(uint64_t index, unsigned int term, const std::string& sql,
-    time_t tstamp, uint64_t fed_index, bool replace)
+int LogDB::to_values(uint64_t index, unsigned int term, const std::string& sql,
+    time_t tstamp, uint64_t fed_index, std::ostringstream& oss)
 {
-    std::ostringstream oss;
-
     std::string * zsql;
 
     zsql = one_util::zlib_compress(sql, true);
@@ -319,10 +465,22 @@ int LogDB::insert(uint64_t index, unsigned int term, const std::string& sql,
         return -1;
     }
 
-    char * sql_db = db->escape_str(*zsql);
+    int rc = to_zvalues(index, term, *zsql, tstamp, fed_index, oss);
 
     delete zsql;
 
+    return rc;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int LogDB::to_zvalues(uint64_t index, unsigned int term,
+    const std::string& zsql, time_t tstamp, uint64_t fed_index,
+    std::ostringstream& oss)
+{
+    char * sql_db = db->escape_str(zsql);
+
     if ( sql_db == 0 )
     {
         return -1;
@@ -330,6 +488,27 @@ int LogDB::insert(uint64_t index, unsigned int term, const std::string& sql,
 
     bool applied = tstamp != 0;
 
+    oss << "("
+        <<        index     << ","
+        <<        term      << ","
+        << "'" << sql_db    << "',"
+        <<        tstamp    << ","
+        <<        fed_index << ","
+        <<        applied   << ")";
+
+    db->free_str(sql_db);
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int LogDB::insert(uint64_t index, unsigned int term, const std::string& sql,
+    time_t tstamp, uint64_t fed_index, bool replace)
+{
+    std::ostringstream oss;
+
     if (replace)
     {
         oss << "REPLACE";
@@ -339,16 +518,30 @@ int LogDB::insert(uint64_t index, unsigned int term, const std::string& sql,
         oss << "INSERT";
     }
 
-    oss << " INTO " << table << " ("<< db_names <<") VALUES ("
-            <<        index     << ","
-            <<        term      << ","
-            << "'" << sql_db    << "',"
-            <<        tstamp    << ","
-            <<        fed_index << ","
-            <<        applied   << ")";
+    oss << " INTO " << table << " ("<< db_names <<") VALUES ";
+
+    std::string * zsql = one_util::zlib_compress(sql, true);
+
+    if ( zsql == 0 )
+    {
+        return -1;
+    }
+
+    if ( to_zvalues(index, term, *zsql, tstamp, fed_index, oss) != 0 )
+    {
+        delete zsql;
+        return -1;
+    }
 
     int rc = db->exec_wr(oss);
 
+    if ( rc == 0 )
+    {
+        tail_add(index, term, sql, *zsql, tstamp, fed_index);
+    }
+
+    delete zsql;
+
     if ( rc != 0 )
     {
         //Check for duplicate (leader retrying i.e. xmlrpc client timeout)
@@ -365,8 +558,6 @@ int LogDB::insert(uint64_t index, unsigned int term, const std::string& sql,
         }
     }
 
-    db->free_str(sql_db);
-
     return rc;
 }
 
@@ -483,6 +674,143 @@ int LogDB::insert_log_record(uint64_t index, unsigned int term,
         {
             fed_log.insert(fed_index);
         }
+
+        pthread_cond_broadcast(&last_cond);
+    }
+
+    pthread_mutex_unlock(&mutex);
+
+    return rc;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+bool LogDB::wait_log_record(uint64_t index, time_t wait_ms)
+{
+    struct timespec timeout;
+
+    clock_gettime(CLOCK_REALTIME, &timeout);
+
+    timeout.tv_sec  += wait_ms / 1000;
+    timeout.tv_nsec += (wait_ms % 1000) * 1000000;
+
+    if ( timeout.tv_nsec >= 1000000000 )
+    {
+        timeout.tv_sec  += 1;
+        timeout.tv_nsec -= 1000000000;
+    }
+
+    pthread_mutex_lock(&mutex);
+
+    while ( last_index < index )
+    {
+        if ( pthread_cond_timedwait(&last_cond, &mutex, &timeout) == ETIMEDOUT )
+        {
+            break;
+        }
+    }
+
+    bool found = last_index >= index;
+
+    pthread_mutex_unlock(&mutex);
+
+    return found;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int LogDB::insert_log_records(const std::vector<LogDBRecord *>& lrs)
+{
+    std::ostringstream oss;
+
+    std::vector<std::string> cmds;
+
+    std::vector<LogDBRecord *>::const_iterator it;
+
+    bool multi = db->multiple_values_support();
+
+    if ( lrs.empty() )
+    {
+        return 0;
+    }
+
+    if ( multi )
+    {
+        oss << "REPLACE INTO " << table << " (" << db_names << ") VALUES ";
+    }
+
+    for ( it = lrs.begin() ; it != lrs.end() ; ++it )
+    {
+        if ( multi && it != lrs.begin() )
+        {
+            oss << ",";
+        }
+        else if ( !multi )
+        {
+            oss.str("");
+
+            oss << "REPLACE INTO " << table << " (" << db_names << ") VALUES ";
+        }
+
+        // Records received compressed from the leader are stored as is, the
+        // rest are compressed here
+        if ( (*it)->get_zsql((*it)->zsql) != 0 )
+        {
+            return -1;
+        }
+
+        if ( to_zvalues((*it)->index, (*it)->term, (*it)->zsql,
+                    (*it)->timestamp, (*it)->fed_index, oss) != 0 )
+        {
+            return -1;
+        }
+
+        if ( !multi )
+        {
+            cmds.push_back(oss.str());
+        }
+    }
+
+    int rc;
+
+    pthread_mutex_lock(&mutex);
+
+    // Without multi-row support records are written in a single transaction,
+    // rolled back if any of them fails
+    if ( multi )
+    {
+        rc = db->exec_wr(oss);
+    }
+    else
+    {
+        rc = db->exec_transaction(cmds);
+    }
+
+    if ( rc == 0 )
+    {
+        for ( it = lrs.begin() ; it != lrs.end() ; ++it )
+        {
+            if ( (*it)->index > last_index )
+            {
+                last_index = (*it)->index;
+
+                last_term  = (*it)->term;
+
+                next_index = last_index + 1;
+            }
+
+            if ( (*it)->fed_index != UINT64_MAX )
+            {
+                fed_log.insert((*it)->fed_index);
+            }
+
+            tail_add((*it)->index, (*it)->term, (*it)->sql, (*it)->zsql,
+                    (*it)->timestamp, (*it)->fed_index);
+        }
+
+        pthread_cond_broadcast(&last_cond);
     }
 
     pthread_mutex_unlock(&mutex);
@@ -557,17 +885,19 @@ int LogDB::delete_log_records(uint64_t start_index)
 
     rc = db->exec_wr(oss);
 
+    tail_delete(start_index);
+
     if ( rc == 0 )
     {
-        LogDBRecord lr;
+        unsigned int _last_term;
 
         next_index = start_index;
 
         last_index = start_index - 1;
 
-        if ( get_log_record(last_index, lr) == 0 )
+        if ( get_log_term(last_index, _last_term) == 0 )
         {
-            last_term = lr.term;
+            last_term = _last_term;
         }
     }
 
@@ -579,165 +909,278 @@ int LogDB::delete_log_records(uint64_t start_index)
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
-int LogDB::apply_log_records(uint64_t commit_index)
+int LogDB::apply_log_group(const std::vector<LogDBRecord *>& lrs)
 {
-    pthread_mutex_lock(&mutex);
+    std::vector<LogDBRecord *>::const_iterator it;
 
-    while (last_applied < commit_index )
+    std::vector<std::string> cmds;
+
+    bool group = lrs.size() > 1;
+
+    for ( it = lrs.begin() ; it != lrs.end() && group ; ++it )
     {
-        LogDBRecord lr;
+        // Records with its own transaction cannot be nested
+        group = (*it)->sql.compare(0, 5, "BEGIN") != 0;
+
+        cmds.push_back((*it)->sql);
+    }
+
+    if ( group )
+    {
+        std::ostringstream oss;
 
-        if ( get_log_record(last_applied + 1, lr) != 0 )
+        uint64_t first = lrs.front()->index;
+        uint64_t last  = lrs.back()->index;
+
+        oss << "UPDATE logdb SET timestamp = " << time(0) << ", applied = 1"
+            << " WHERE log_index >= " << first << " AND log_index <= " << last
+            << " AND timestamp = 0";
+
+        cmds.push_back(oss.str());
+
+        if ( db->exec_transaction(cmds) == SqlDB::SUCCESS )
         {
-            pthread_mutex_unlock(&mutex);
-            return -1;
+            last_applied = last;
+
+            return 0;
         }
 
-        if ( apply_log_record(&lr) != 0 )
+        oss.str("");
+
+        oss << "Cannot apply log records " << first << " - " << last
+            << " in a single transaction, applying them one by one";
+
+        NebulaLog::log("DBM", Log::DEBUG, oss);
+    }
+
+    for ( it = lrs.begin() ; it != lrs.end() ; ++it )
+    {
+        if ( apply_log_record(*it) != 0 )
         {
-            pthread_mutex_unlock(&mutex);
             return -1;
         }
     }
 
-    pthread_mutex_unlock(&mutex);
-
     return 0;
 }
 
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
-int LogDB::purge_log()
+int LogDB::apply_log_records(uint64_t commit_index)
 {
-    std::ostringstream oss, foss;
-
-    empty_cb cb;
-
-    multiple_cb<std::vector, uint64_t> cb_info;
-    single_cb<string> cb_min_idx;
-    std::vector<uint64_t> maxmin_i;
-    std::vector<uint64_t> maxmin_e;
-    string min_idx;
+    std::vector<LogDBRecord *> lrs;
+    std::vector<LogDBRecord *>::iterator it;
 
-    int rc  = 0;
-    int frc = 0;
+    int rc = 0;
 
     pthread_mutex_lock(&mutex);
 
-    /* ---------------- Record log state -------------------- */
+    while ( last_applied < commit_index && rc == 0 )
+    {
+        uint64_t index = last_applied + 1;
 
-    oss << "SELECT MIN(log_index), MAX(log_index) FROM logdb WHERE log_index >= 0";
+        for (; index <= commit_index && lrs.size() < max_apply_group; ++index)
+        {
+            LogDBRecord * lr = new LogDBRecord;
 
-    cb_info.set_callback(&maxmin_i);
+            if ( get_log_record(index, *lr) != 0 )
+            {
+                delete lr;
 
-    db->exec_rd(oss, &cb_info);
+                rc = -1;
+                break;
+            }
 
-    cb_info.unset_callback();
+            lrs.push_back(lr);
+        }
+
+        if ( !lrs.empty() && apply_log_group(lrs) != 0 )
+        {
+            rc = -1;
+        }
+
+        for ( it = lrs.begin() ; it != lrs.end() ; ++it )
+        {
+            delete *it;
+        }
+
+        lrs.clear();
+    }
+
+    pthread_mutex_unlock(&mutex);
+
+    return rc;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+bool LogDB::start_purge()
+{
+    std::ostringstream oss;
+
+    single_cb<uint64_t> cb_idx;
+
+    purge_end     = 0;
+    fed_purge_end = 0;
+    purged        = 0;
+    fed_purged    = 0;
 
     /* ---------------------------------------------------------------------- */
     /* Non-federated records. Keep last log_retention records                 */
     /* ---------------------------------------------------------------------- */
-
-    oss.str("");
     oss << "  SELECT MIN(i.log_index) FROM ("
         << "    SELECT log_index FROM logdb WHERE fed_index = " << UINT64_MAX
         << "      AND applied = 1 AND log_index >= 0 "
         << "      ORDER BY log_index DESC LIMIT " << log_retention
         << "  ) AS i";
 
-    cb_min_idx.set_callback(&min_idx);
+    cb_idx.set_callback(&purge_end);
 
-    db->exec_rd(oss, &cb_min_idx);
+    db->exec_rd(oss, &cb_idx);
 
-    cb_min_idx.unset_callback();
+    cb_idx.unset_callback();
 
-    cb.set_affected_rows(0);
+    /* ---------------------------------------------------------------------- */
+    /* Federated records. Keep last log_retention federated records           */
+    /* ---------------------------------------------------------------------- */
+    if ( fed_log.size() >= log_retention )
+    {
+        oss.str("");
+        oss << "  SELECT MIN(i.log_index) FROM ("
+            << "    SELECT log_index FROM logdb WHERE fed_index != " << UINT64_MAX
+            << "      AND applied = 1 AND log_index >= 0 "
+            << "      ORDER BY log_index DESC LIMIT " << log_retention
+            << "  ) AS i";
 
-    oss.str("");
-    oss << "DELETE FROM logdb WHERE applied = 1 AND log_index >= 0 "
-        << "AND fed_index = " << UINT64_MAX << " AND log_index < " << min_idx;
+        cb_idx.set_callback(&fed_purge_end);
 
-    if ( db->limit_support() )
-    {
-        oss << " LIMIT " << limit_purge;
-    }
+        db->exec_rd(oss, &cb_idx);
 
-    if ( db->exec_wr(oss, &cb) != -1 )
-    {
-        rc = cb.get_affected_rows();
+        cb_idx.unset_callback();
     }
 
-    /* ---------------- Record log state -------------------- */
+    /* ---------------------------------------------------------------------- */
+    /* First record to purge                                                  */
+    /* ---------------------------------------------------------------------- */
+    purge_next = next_purge_index(0);
 
-    oss.str("");
-    oss << "SELECT MIN(log_index), MAX(log_index) FROM logdb WHERE log_index >= 0";
+    return purge_next != UINT64_MAX;
+}
 
-    cb_info.set_callback(&maxmin_e);
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+uint64_t LogDB::next_purge_index(uint64_t index)
+{
+    std::ostringstream oss;
 
-    db->exec_rd(oss, &cb_info);
+    single_cb<uint64_t> cb_idx;
 
-    cb_info.unset_callback();
+    uint64_t next = UINT64_MAX;
 
-    oss.str("");
-    oss << "Purging obsolete LogDB records: " << rc << " records purged. Log state: "
-        << maxmin_i[0] << "," << maxmin_i[1] << " - " << maxmin_e[0] << "," << maxmin_e[1];
+    oss << "SELECT log_index FROM logdb WHERE applied = 1"
+        << " AND log_index >= " << index << " AND ("
+        << "(fed_index = "  << UINT64_MAX << " AND log_index < " << purge_end
+        << ") OR (fed_index != " << UINT64_MAX << " AND log_index < "
+        << fed_purge_end << ")) ORDER BY log_index LIMIT 1";
 
-    NebulaLog::log("DBM", Log::INFO, oss);
+    cb_idx.set_callback(&next);
 
-    /* ---------------------------------------------------------------------- */
-    /* Federated records. Keep last log_retention federated records           */
-    /* ---------------------------------------------------------------------- */
+    int rc = db->exec_rd(oss, &cb_idx);
 
-    foss << "Purging obsolete federated LogDB records: ";
+    cb_idx.unset_callback();
 
-    if ( fed_log.size() < log_retention )
+    if ( rc != 0 )
     {
-        foss << "0 records purged. Federated log size: " << fed_log.size();
+        return UINT64_MAX;
+    }
 
-        NebulaLog::log("DBM", Log::INFO, foss);
+    return next;
+}
 
-        pthread_mutex_unlock(&mutex);
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
 
-        return rc;
-    }
+int LogDB::purge_log()
+{
+    std::ostringstream oss;
 
-    oss.str("");
-    oss << "  SELECT MIN(i.log_index) FROM ("
-        << "    SELECT log_index FROM logdb WHERE fed_index != " << UINT64_MAX
-        << "      AND applied = 1 AND log_index >= 0 "
-        << "      ORDER BY log_index DESC LIMIT " << log_retention
-        << "  ) AS i";
+    empty_cb cb;
+
+    pthread_mutex_lock(&mutex);
+
+    if ( !purging && !start_purge() )
+    {
+        pthread_mutex_unlock(&mutex);
+        return 0;
+    }
 
-    cb_min_idx.set_callback(&min_idx);
+    purging = true;
 
-    db->exec_rd(oss, &cb_min_idx);
+    /* ---------------------------------------------------------------------- */
+    /* Purge the records of the chunk [purge_next, chunk_end)                 */
+    /* ---------------------------------------------------------------------- */
+    uint64_t chunk_end = purge_next + purge_chunk;
 
-    cb_min_idx.unset_callback();
+    if ( purge_next < purge_end )
+    {
+        cb.set_affected_rows(0);
 
-    cb.set_affected_rows(0);
+        oss << "DELETE FROM logdb WHERE applied = 1 AND fed_index = "
+            << UINT64_MAX << " AND log_index >= " << purge_next
+            << " AND log_index < " << std::min(chunk_end, purge_end);
 
-    oss.str("");
-    oss << "DELETE FROM logdb WHERE applied = 1 AND log_index >= 0 "
-        << "AND fed_index != " << UINT64_MAX << " AND log_index < " << min_idx;
+        if ( db->exec_wr(oss, &cb) != -1 )
+        {
+            purged += cb.get_affected_rows();
+        }
+    }
 
-    if ( db->limit_support() )
+    if ( purge_next < fed_purge_end )
     {
-        oss << " LIMIT " << limit_purge;
+        cb.set_affected_rows(0);
+
+        oss.str("");
+        oss << "DELETE FROM logdb WHERE applied = 1 AND fed_index != "
+            << UINT64_MAX << " AND log_index >= " << purge_next
+            << " AND log_index < " << std::min(chunk_end, fed_purge_end);
+
+        if ( db->exec_wr(oss, &cb) != -1 )
+        {
+            fed_purged += cb.get_affected_rows();
+        }
     }
 
-    if ( db->exec_wr(oss, &cb) != -1 )
+    // Skip the ranges without records to purge
+    purge_next = next_purge_index(chunk_end);
+
+    int rc = purged + fed_purged;
+
+    if ( purge_next != UINT64_MAX && static_cast<uint64_t>(rc) < limit_purge )
     {
-        frc = cb.get_affected_rows();
+        pthread_mutex_unlock(&mutex);
 
-        rc += frc;
+        return rc;
     }
 
-    build_federated_index();
+    /* ---------------------------------------------------------------------- */
+    /* Purge complete, the federated index is rebuilt once for all chunks     */
+    /* ---------------------------------------------------------------------- */
+    purging = false;
+
+    if ( fed_purged > 0 )
+    {
+        build_federated_index();
+    }
 
-    foss << frc << " records purged. Federated log size: " << fed_log.size();
+    oss.str("");
+    oss << "Purging obsolete LogDB records: " << purged << " records purged, "
+        << fed_purged << " federated records purged. Federated log size: "
+        << fed_log.size();
 
-    NebulaLog::log("DBM", Log::INFO, foss);
+    NebulaLog::log("DBM", Log::INFO, oss);
 
     pthread_mutex_unlock(&mutex);
 
@@ -747,6 +1190,20 @@ int LogDB::purge_log()
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+bool LogDB::is_purging()
+{
+    pthread_mutex_lock(&mutex);
+
+    bool _purging = purging;
+
+    pthread_mutex_unlock(&mutex);
+
+    return _purging;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 int LogDB::replicate(uint64_t rindex)
 {
     int rc;
@@ -768,7 +1225,16 @@ int LogDB::replicate(uint64_t rindex)
     }
     else if ( rr.result == true ) //Record replicated on majority of followers
     {
-        rc = apply_log_records(rindex);
+        // Apply every committed record, writers of the records replicated
+        // along with this one will find them already applied
+        uint64_t commit = raftm->get_commit();
+
+        if ( commit < rindex )
+        {
+            commit = rindex;
+        }
+
+        rc = apply_log_records(commit);
     }
     else
     {
@@ -784,6 +1250,399 @@ int LogDB::replicate(uint64_t rindex)
     return rc;
 }
 
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+/* Snapshots. The file is a sequence of SQL commands, each one preceded by its */
+/* length in its own line                                                     */
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+static void write_snapshot_cmd(std::ofstream& out, const std::string& cmd)
+{
+    out << cmd.size() << "\n" << cmd;
+}
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ *  Reads the commands of a snapshot file in batches of up to max_size bytes
+ *  (at least one command each)
+ */
+class SnapshotReader : public SqlCmdReader
+{
+public:
+    SnapshotReader(const std::string& file, size_t _max_size):
+        in(file.c_str(), std::ios::in | std::ios::binary), max_size(_max_size){};
+
+    bool good()
+    {
+        return in.good();
+    }
+
+    /**
+     *  Adds a command to be executed after the ones in the file
+     */
+    void append(const std::string& cmd)
+    {
+        tail.push_back(cmd);
+    }
+
+    int next(std::vector<std::string>& cmds) override
+    {
+        size_t size;
+        size_t batch = 0;
+
+        while ( batch < max_size && in >> size )
+        {
+            std::string cmd(size, '\0');
+
+            in.get();
+
+            if ( size > 0 && !in.read(&cmd[0], size) )
+            {
+                return -1;
+            }
+
+            batch += size;
+
+            cmds.push_back(cmd);
+        }
+
+        if ( !cmds.empty() )
+        {
+            return 0;
+        }
+
+        if ( !in.eof() )
+        {
+            return -1;
+        }
+
+        cmds.swap(tail);
+
+        return 0;
+    }
+
+private:
+    std::ifstream in;
+
+    size_t max_size;
+
+    std::vector<std::string> tail;
+};
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ *  Writes a REPLACE command for each row of a table to the snapshot file
+ */
+class SnapshotRows : public Callbackable
+{
+public:
+    SnapshotRows(SqlDB * _db, const std::string& _table, std::ofstream& _out):
+        db(_db), table(_table), out(_out){};
+
+    void set_callback()
+    {
+        Callbackable::set_callback(
+                static_cast<Callbackable::Callback>(&SnapshotRows::select_cb));
+    }
+
+private:
+    SqlDB * db;
+
+    std::string table;
+
+    std::ofstream& out;
+
+    int select_cb(void *nil, int num, char **values, char **names)
+    {
+        std::ostringstream cols;
+        std::ostringstream vals;
+
+        for (int i = 0; i < num; ++i)
+        {
+            if ( i > 0 )
+            {
+                cols << ",";
+                vals << ",";
+            }
+
+            cols << names[i];
+
+            if ( values[i] == 0 )
+            {
+                vals << "NULL";
+                continue;
+            }
+
+            char * value_db = db->escape_str(values[i]);
+
+            if ( value_db == 0 )
+            {
+                return -1;
+            }
+
+            vals << "'" << value_db << "'";
+
+            db->free_str(value_db);
+        }
+
+        write_snapshot_cmd(out, "REPLACE INTO " + table + " (" + cols.str() +
+                ") VALUES (" + vals.str() + ")");
+
+        return 0;
+    }
+};
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int LogDB::create_snapshot(const std::string& file, const std::string& raft_state,
+        const std::set<std::string>& local, uint64_t& index, unsigned int& term,
+        uint64_t& fed_index)
+{
+    std::vector<std::string> tables;
+    std::vector<std::string>::iterator it;
+
+    std::vector<std::string>    cmds;
+    std::vector<Callbackable *> objs;
+
+    std::ofstream out(file.c_str(), std::ios::out | std::ios::trunc |
+            std::ios::binary);
+
+    if ( !out.good() )
+    {
+        NebulaLog::log("DBM", Log::ERROR, "Cannot open snapshot file " + file);
+        return -1;
+    }
+
+    if ( db->get_tables(tables) != 0 )
+    {
+        NebulaLog::log("DBM", Log::ERROR, "Cannot get the DB tables");
+        return -1;
+    }
+
+    for ( it = tables.begin() ; it != tables.end() ; ++it )
+    {
+        std::string where;
+
+        if ( *it == table || local.count(*it) > 0 )
+        {
+            continue;
+        }
+        else if ( *it == "system_attributes" )
+        {
+            where = " WHERE name <> '" + raft_state + "'";
+        }
+
+        write_snapshot_cmd(out, "DELETE FROM " + *it + where);
+
+        SnapshotRows * rows = new SnapshotRows(db, *it, out);
+
+        rows->set_callback();
+
+        cmds.push_back("SELECT * FROM " + *it + where);
+        objs.push_back(rows);
+    }
+
+    // Records are applied with the mutex locked, it is held just until the
+    // read view is taken so the view matches last_applied
+    pthread_mutex_lock(&mutex);
+
+    index = last_applied;
+
+    int rc = get_log_term(index, term);
+
+    std::set<uint64_t>::iterator fit = fed_log.upper_bound(index);
+
+    if ( fit == fed_log.begin() )
+    {
+        fed_index = UINT64_MAX;
+    }
+    else
+    {
+        fed_index = *(--fit);
+    }
+
+    if ( rc == 0 )
+    {
+        rc = db->exec_rd_transaction(cmds, objs, &mutex);
+    }
+    else
+    {
+        pthread_mutex_unlock(&mutex);
+    }
+
+    for (size_t i = 0; i < objs.size(); ++i)
+    {
+        objs[i]->unset_callback();
+
+        delete objs[i];
+    }
+
+    out.close();
+
+    if ( rc != 0 || out.fail() )
+    {
+        NebulaLog::log("DBM", Log::ERROR, "Error writing snapshot file " + file);
+        return -1;
+    }
+
+    std::ostringstream oss;
+
+    oss << "Snapshot of the DB state at log index " << index << " (term "
+        << term << ") written to " << file;
+
+    NebulaLog::log("DBM", Log::INFO, oss);
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int LogDB::install_snapshot(const std::string& file, uint64_t index,
+        unsigned int term, uint64_t fed_index)
+{
+    std::ostringstream oss;
+
+    SnapshotReader reader(file, snapshot_batch);
+
+    if ( !reader.good() )
+    {
+        NebulaLog::log("DBM", Log::ERROR, "Error reading snapshot file " + file);
+        return -1;
+    }
+
+    // Reset the log to the snapshot record, record 0 is kept
+    oss << "DELETE FROM " << table << " WHERE log_index > 0";
+
+    reader.append(oss.str());
+
+    oss.str("");
+
+    oss << "INSERT INTO " << table << " (" << db_names << ") VALUES ";
+
+    if ( to_values(index, term, "", time(0), fed_index, oss) != 0 )
+    {
+        return -1;
+    }
+
+    reader.append(oss.str());
+
+    pthread_mutex_lock(&mutex);
+
+    int rc = db->exec_transaction(reader);
+
+    tail_delete(0);
+
+    if ( rc == SqlDB::SUCCESS )
+    {
+        last_applied = index;
+        last_index   = index;
+        last_term    = term;
+        next_index   = index + 1;
+
+        purging = false;
+
+        build_federated_index();
+    }
+
+    pthread_mutex_unlock(&mutex);
+
+    oss.str("");
+
+    if ( rc != SqlDB::SUCCESS )
+    {
+        oss << "Error installing snapshot at log index " << index;
+
+        NebulaLog::log("DBM", Log::ERROR, oss);
+
+        return -1;
+    }
+
+    oss << "Installed snapshot of the DB state at log index " << index
+        << " (term " << term << ")";
+
+    NebulaLog::log("DBM", Log::INFO, oss);
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void LogDB::tail_add(uint64_t index, unsigned int term, const std::string& sql,
+        const std::string& zsql, time_t ts, uint64_t fed_index)
+{
+    pthread_mutex_lock(&tail_mutex);
+
+    TailRecord& tr = tail[index % tail_size];
+
+    tr.valid     = true;
+    tr.index     = index;
+    tr.term      = term;
+    tr.sql       = sql;
+    tr.zsql      = zsql;
+    tr.timestamp = ts;
+    tr.fed_index = fed_index;
+
+    pthread_mutex_unlock(&tail_mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+bool LogDB::tail_get(uint64_t index, LogDBRecord& lr)
+{
+    uint64_t prev_index = index == 0 ? 0 : index - 1;
+
+    pthread_mutex_lock(&tail_mutex);
+
+    const TailRecord& tr = tail[index % tail_size];
+    const TailRecord& pr = tail[prev_index % tail_size];
+
+    if ( !tr.valid || tr.index != index || !pr.valid || pr.index != prev_index )
+    {
+        pthread_mutex_unlock(&tail_mutex);
+        return false;
+    }
+
+    lr.index      = tr.index;
+    lr.term       = tr.term;
+    lr.sql        = tr.sql;
+    lr.zsql       = tr.zsql;
+    lr.timestamp  = tr.timestamp;
+    lr.fed_index  = tr.fed_index;
+    lr.prev_index = pr.index;
+    lr.prev_term  = pr.term;
+
+    pthread_mutex_unlock(&tail_mutex);
+
+    return true;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void LogDB::tail_delete(uint64_t start_index)
+{
+    std::vector<TailRecord>::iterator it;
+
+    pthread_mutex_lock(&tail_mutex);
+
+    for ( it = tail.begin() ; it != tail.end() ; ++it )
+    {
+        if ( it->valid && it->index >= start_index )
+        {
+            *it = TailRecord();
+        }
+    }
+
+    pthread_mutex_unlock(&tail_mutex);
+}
+
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
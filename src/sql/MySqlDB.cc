@@ -402,6 +402,253 @@ int MySqlDB::exec_ext(std::ostringstream& cmd, Callbackable *obj, bool quiet)
 
 /* -------------------------------------------------------------------------- */
 
+int MySqlDB::exec_transaction(const std::vector<std::string>& cmds)
+{
+    int ec = SqlDB::SUCCESS;
+
+    MYSQL * db = get_db_connection();
+
+    std::vector<std::string>::const_iterator it;
+
+    if ( mysql_query(db, "START TRANSACTION") != 0 )
+    {
+        ec = SqlDB::SQL;
+    }
+
+    for ( it = cmds.begin() ; it != cmds.end() && ec == SqlDB::SUCCESS ; ++it )
+    {
+        if ( mysql_query(db, it->c_str()) != 0 )
+        {
+            ec = SqlDB::SQL;
+        }
+    }
+
+    if ( ec == SqlDB::SUCCESS && mysql_query(db, "COMMIT") != 0 )
+    {
+        ec = SqlDB::SQL;
+    }
+
+    if ( ec != SqlDB::SUCCESS )
+    {
+        ostringstream oss;
+
+        int err_num = mysql_errno(db);
+
+        switch(err_num)
+        {
+            case CR_SERVER_GONE_ERROR:
+            case CR_SERVER_LOST:
+                ec = SqlDB::CONNECTION;
+                break;
+
+            case ER_DUP_ENTRY:
+                ec = SqlDB::SQL_DUP_KEY;
+                break;
+        }
+
+        oss << "SQL transaction failed, error " << err_num << " : "
+            << mysql_error(db);
+
+        NebulaLog::log("ONE", Log::DEBUG, oss);
+
+        if ( ec != SqlDB::CONNECTION )
+        {
+            mysql_query(db, "ROLLBACK");
+        }
+    }
+
+    free_db_connection(db);
+
+    return ec;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int MySqlDB::exec_transaction(SqlCmdReader& reader)
+{
+    int ec = SqlDB::SUCCESS;
+
+    MYSQL * db = get_db_connection();
+
+    std::vector<std::string> cmds;
+    std::vector<std::string>::iterator it;
+
+    if ( mysql_query(db, "START TRANSACTION") != 0 )
+    {
+        ec = SqlDB::SQL;
+    }
+
+    while ( ec == SqlDB::SUCCESS )
+    {
+        cmds.clear();
+
+        if ( reader.next(cmds) != 0 )
+        {
+            mysql_query(db, "ROLLBACK");
+
+            free_db_connection(db);
+
+            return SqlDB::INTERNAL;
+        }
+
+        if ( cmds.empty() )
+        {
+            break;
+        }
+
+        for ( it = cmds.begin() ; it != cmds.end() && ec == SqlDB::SUCCESS ; ++it )
+        {
+            if ( mysql_query(db, it->c_str()) != 0 )
+            {
+                ec = SqlDB::SQL;
+            }
+        }
+    }
+
+    if ( ec == SqlDB::SUCCESS && mysql_query(db, "COMMIT") != 0 )
+    {
+        ec = SqlDB::SQL;
+    }
+
+    if ( ec != SqlDB::SUCCESS )
+    {
+        ostringstream oss;
+
+        int err_num = mysql_errno(db);
+
+        switch(err_num)
+        {
+            case CR_SERVER_GONE_ERROR:
+            case CR_SERVER_LOST:
+                ec = SqlDB::CONNECTION;
+                break;
+
+            case ER_DUP_ENTRY:
+                ec = SqlDB::SQL_DUP_KEY;
+                break;
+        }
+
+        oss << "SQL transaction failed, error " << err_num << " : "
+            << mysql_error(db);
+
+        NebulaLog::log("ONE", Log::DEBUG, oss);
+
+        if ( ec != SqlDB::CONNECTION )
+        {
+            mysql_query(db, "ROLLBACK");
+        }
+    }
+
+    free_db_connection(db);
+
+    return ec;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int MySqlDB::exec_rd_transaction(const std::vector<std::string>& cmds,
+        const std::vector<Callbackable *>& objs, pthread_mutex_t * ready)
+{
+    int ec = SqlDB::SUCCESS;
+
+    MYSQL * db = get_db_connection();
+
+    // The snapshot needs REPEATABLE READ, it only applies to this transaction
+    if ( mysql_query(db, "SET TRANSACTION ISOLATION LEVEL REPEATABLE READ") != 0
+        || mysql_query(db, "START TRANSACTION WITH CONSISTENT SNAPSHOT") != 0 )
+    {
+        ec = SqlDB::SQL;
+    }
+
+    if ( ready != 0 )
+    {
+        pthread_mutex_unlock(ready);
+    }
+
+    for (size_t i = 0; i < cmds.size() && ec == SqlDB::SUCCESS; ++i)
+    {
+        if ( mysql_query(db, cmds[i].c_str()) != 0 )
+        {
+            ec = SqlDB::SQL;
+            break;
+        }
+
+        // Rows are fetched from the server as they are processed
+        MYSQL_RES * result = mysql_use_result(db);
+
+        if ( result == NULL )
+        {
+            ec = SqlDB::SQL;
+            break;
+        }
+
+        MYSQL_ROW     row;
+        MYSQL_FIELD * fields;
+
+        unsigned int num_fields = mysql_num_fields(result);
+
+        fields = mysql_fetch_fields(result);
+
+        std::vector<char *> names(num_fields);
+
+        for(unsigned int j = 0; j < num_fields; j++)
+        {
+            names[j] = fields[j].name;
+        }
+
+        while((row = mysql_fetch_row(result)))
+        {
+            if ( objs[i]->do_callback(num_fields, row, names.data()) != 0 )
+            {
+                ec = SqlDB::SQL;
+                break;
+            }
+        }
+
+        if ( ec == SqlDB::SUCCESS && mysql_errno(db) != 0 )
+        {
+            ec = SqlDB::SQL;
+        }
+
+        mysql_free_result(result);
+    }
+
+    if ( ec != SqlDB::SUCCESS )
+    {
+        ostringstream oss;
+
+        oss << "SQL read transaction failed, error " << mysql_errno(db)
+            << " : " << mysql_error(db);
+
+        NebulaLog::log("ONE", Log::ERROR, oss);
+    }
+
+    mysql_query(db, "COMMIT");
+
+    free_db_connection(db);
+
+    return ec;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int MySqlDB::get_tables(std::vector<std::string>& tables)
+{
+    std::ostringstream oss("SHOW TABLES");
+
+    vector_cb<std::string> cb;
+
+    cb.set_callback(&tables);
+
+    int rc = exec_rd(oss, &cb);
+
+    cb.unset_callback();
+
+    return rc;
+}
+
+/* -------------------------------------------------------------------------- */
+
 char * MySqlDB::escape_str(const string& str)
 {
     char * result = new char[str.size()*2+1];
@@ -17,6 +17,8 @@
 
 #include "SqliteDB.h"
 
+#include <strings.h>
+
 using namespace std;
 
 /* -------------------------------------------------------------------------- */
@@ -41,8 +43,10 @@ extern "C" int sqlite_callback (
 
 /* -------------------------------------------------------------------------- */
 
-SqliteDB::SqliteDB(const string& db_name)
+SqliteDB::SqliteDB(const string& _db_name):db_name(_db_name), wal(false)
 {
+    sqlite3_stmt * stmt;
+
     pthread_mutex_init(&mutex,0);
 
     int rc = sqlite3_open(db_name.c_str(), &db);
@@ -52,6 +56,18 @@ SqliteDB::SqliteDB(const string& db_name)
         throw runtime_error("Could not open database.");
     }
 
+    if ( sqlite3_prepare_v2(db, "PRAGMA journal_mode", -1, &stmt, 0) == SQLITE_OK )
+    {
+        if ( sqlite3_step(stmt) == SQLITE_ROW )
+        {
+            const unsigned char * mode = sqlite3_column_text(stmt, 0);
+
+            wal = mode != 0 && strcasecmp((const char *) mode, "wal") == 0;
+        }
+
+        sqlite3_finalize(stmt);
+    }
+
     enable_limit = sqlite3_compileoption_used("SQLITE_ENABLE_UPDATE_DELETE_LIMIT");
 
     if (enable_limit)
@@ -184,6 +200,295 @@ int SqliteDB::exec_ext(std::ostringstream& cmd, Callbackable *obj, bool quiet)
 
 /* -------------------------------------------------------------------------- */
 
+int SqliteDB::exec_transaction(const std::vector<std::string>& cmds)
+{
+    int rc, ec;
+
+    int    counter = 0;
+    char * err_msg = 0;
+
+    std::ostringstream cmd;
+
+    cmd << "BEGIN TRANSACTION; ";
+
+    for (std::vector<std::string>::const_iterator it = cmds.begin();
+            it != cmds.end() ; ++it)
+    {
+        cmd << *it << "; ";
+    }
+
+    cmd << "COMMIT";
+
+    string str         = cmd.str();
+    const char * c_str = str.c_str();
+
+    lock();
+
+    do
+    {
+        counter++;
+
+        if ( err_msg != 0 )
+        {
+            sqlite3_free(err_msg);
+            err_msg = 0;
+        }
+
+        rc = sqlite3_exec(db, c_str, 0, 0, &err_msg);
+
+        // Failed statement leaves the transaction open
+        if ( rc != SQLITE_OK && sqlite3_get_autocommit(db) == 0 )
+        {
+            sqlite3_exec(db, "ROLLBACK", 0, 0, 0);
+        }
+
+        if (rc == SQLITE_BUSY || rc == SQLITE_IOERR)
+        {
+            struct timeval timeout;
+
+            timeout.tv_sec  = 0;
+            timeout.tv_usec = 250000;
+
+            select(0, NULL, NULL, NULL, &timeout);
+        }
+    }while((rc == SQLITE_BUSY || rc == SQLITE_IOERR) && (counter < 10));
+
+    unlock();
+
+    switch(rc)
+    {
+        case SQLITE_BUSY:
+        case SQLITE_IOERR:
+            ec = SqlDB::CONNECTION;
+            break;
+
+        case SQLITE_OK:
+            ec = SqlDB::SUCCESS;
+            break;
+
+        case SQLITE_CONSTRAINT_UNIQUE:
+            ec = SqlDB::SQL_DUP_KEY;
+            break;
+
+        default:
+            ec = SqlDB::SQL;
+            break;
+    }
+
+    if ( ec != SqlDB::SUCCESS && err_msg != NULL )
+    {
+        std::ostringstream oss;
+
+        oss << "SQL transaction failed, error: " << err_msg;
+        NebulaLog::log("ONE", Log::DEBUG, oss);
+
+        sqlite3_free(err_msg);
+    }
+
+    return ec;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int SqliteDB::exec_transaction(SqlCmdReader& reader)
+{
+    int rc;
+    int ec = SqlDB::SUCCESS;
+
+    char * err_msg = 0;
+
+    std::vector<std::string> cmds;
+    std::vector<std::string>::iterator it;
+
+    lock();
+
+    rc = sqlite3_exec(db, "BEGIN TRANSACTION", 0, 0, &err_msg);
+
+    while ( rc == SQLITE_OK )
+    {
+        cmds.clear();
+
+        if ( reader.next(cmds) != 0 )
+        {
+            ec = SqlDB::INTERNAL;
+            break;
+        }
+
+        if ( cmds.empty() )
+        {
+            rc = sqlite3_exec(db, "COMMIT", 0, 0, &err_msg);
+            break;
+        }
+
+        std::ostringstream cmd;
+
+        for ( it = cmds.begin() ; it != cmds.end() ; ++it )
+        {
+            cmd << *it << "; ";
+        }
+
+        rc = sqlite3_exec(db, cmd.str().c_str(), 0, 0, &err_msg);
+    }
+
+    if ( (rc != SQLITE_OK || ec != SqlDB::SUCCESS) &&
+            sqlite3_get_autocommit(db) == 0 )
+    {
+        sqlite3_exec(db, "ROLLBACK", 0, 0, 0);
+    }
+
+    unlock();
+
+    if ( ec != SqlDB::SUCCESS )
+    {
+        return ec;
+    }
+
+    switch(rc)
+    {
+        case SQLITE_BUSY:
+        case SQLITE_IOERR:
+            ec = SqlDB::CONNECTION;
+            break;
+
+        case SQLITE_OK:
+            ec = SqlDB::SUCCESS;
+            break;
+
+        case SQLITE_CONSTRAINT_UNIQUE:
+            ec = SqlDB::SQL_DUP_KEY;
+            break;
+
+        default:
+            ec = SqlDB::SQL;
+            break;
+    }
+
+    if ( err_msg != 0 )
+    {
+        std::ostringstream oss;
+
+        oss << "SQL transaction failed, error: " << err_msg;
+        NebulaLog::log("ONE", Log::DEBUG, oss);
+
+        sqlite3_free(err_msg);
+    }
+
+    return ec;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int SqliteDB::exec_rd_transaction(const std::vector<std::string>& cmds,
+        const std::vector<Callbackable *>& objs, pthread_mutex_t * ready)
+{
+    int rc;
+
+    char * err_msg = 0;
+
+    sqlite3 * rd_db;
+
+    // -------------------------------------------------------------------------
+    // Take the read view on a second connection, so writes are not blocked
+    // while the queries run:
+    //   - WAL: a read transaction sees the DB as of its first read
+    //   - Otherwise a reader blocks the writers, the DB is copied in memory
+    // -------------------------------------------------------------------------
+    if ( wal )
+    {
+        rc = sqlite3_open_v2(db_name.c_str(), &rd_db, SQLITE_OPEN_READONLY, 0);
+
+        if ( rc == SQLITE_OK )
+        {
+            sqlite3_busy_timeout(rd_db, 2500);
+
+            rc = sqlite3_exec(rd_db, "BEGIN; SELECT COUNT(*) FROM sqlite_master",
+                    0, 0, &err_msg);
+        }
+    }
+    else
+    {
+        rc = sqlite3_open(":memory:", &rd_db);
+
+        if ( rc == SQLITE_OK )
+        {
+            lock();
+
+            sqlite3_backup * backup = sqlite3_backup_init(rd_db, "main", db,
+                    "main");
+
+            if ( backup != 0 )
+            {
+                sqlite3_backup_step(backup, -1);
+
+                rc = sqlite3_backup_finish(backup);
+            }
+            else
+            {
+                rc = sqlite3_errcode(rd_db);
+            }
+
+            unlock();
+        }
+    }
+
+    if ( ready != 0 )
+    {
+        pthread_mutex_unlock(ready);
+    }
+
+    for (size_t i = 0; i < cmds.size() && rc == SQLITE_OK; ++i)
+    {
+        rc = sqlite3_exec(rd_db, cmds[i].c_str(), sqlite_callback,
+                static_cast<void *>(objs[i]), &err_msg);
+    }
+
+    if ( err_msg == 0 && rc != SQLITE_OK )
+    {
+        err_msg = sqlite3_mprintf("%s", sqlite3_errmsg(rd_db));
+    }
+
+    sqlite3_close(rd_db);
+
+    if ( rc == SQLITE_OK )
+    {
+        return SqlDB::SUCCESS;
+    }
+
+    if ( err_msg != 0 )
+    {
+        std::ostringstream oss;
+
+        oss << "SQL read transaction failed, error: " << err_msg;
+        NebulaLog::log("ONE", Log::ERROR, oss);
+
+        sqlite3_free(err_msg);
+    }
+
+    return SqlDB::SQL;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int SqliteDB::get_tables(std::vector<std::string>& tables)
+{
+    std::ostringstream oss;
+
+    vector_cb<std::string> cb;
+
+    oss << "SELECT name FROM sqlite_master WHERE type = 'table'"
+        << " AND name NOT LIKE 'sqlite_%'";
+
+    cb.set_callback(&tables);
+
+    int rc = exec_rd(oss, &cb);
+
+    cb.unset_callback();
+
+    return rc;
+}
+
+/* -------------------------------------------------------------------------- */
+
 char * SqliteDB::escape_str(const string& str)
 {
     return sqlite3_mprintf("%q",str.c_str());
@@ -357,16 +357,11 @@ void Quotas::ds_del_recreate(int uid, int gid, vector<Template *>& ds_quotas)
 
         if ( img_owner )
         {
-            Image* img = ipool->get_ro(image_id);
+            std::shared_ptr<const Image> img = ipool->get_ro_shared(image_id);
 
-            if(img != 0)
+            if( img )
             {
-                int img_uid = img->get_uid();
-                int img_gid = img->get_gid();
-
-                img->unlock();
-
-                quota_del(DATASTORE, img_uid, img_gid, tmpl);
+                quota_del(DATASTORE, img->get_uid(), img->get_gid(), tmpl);
             }
         }
 
@@ -52,7 +52,7 @@ string UserPool::oneadmin_name;
 /* -------------------------------------------------------------------------- */
 
 UserPool::UserPool(SqlDB * db, time_t __session_expiration_time, bool is_slave,
-        vector<const SingleAttribute *>& restricted_attrs):PoolSQL(db, User::table)
+        vector<const SingleAttribute *>& restricted_attrs):PoolSQL(db, User::table, !is_slave)
 {
     int one_uid    = -1;
     int server_uid = -1;
@@ -527,7 +527,11 @@ int UserPool::update(PoolObjectSQL * objsql)
 
 int UserPool::update_quotas(User * user)
 {
-    return user->update_quotas(db);
+    int rc = user->update_quotas(db);
+
+    record_change(user->get_oid());
+
+    return rc;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -25,7 +25,8 @@ const int    VdcPool::DEFAULT_ID   = 0;
 
 /* -------------------------------------------------------------------------- */
 
-VdcPool::VdcPool(SqlDB * db, bool is_federation_slave): PoolSQL(db, Vdc::table)
+VdcPool::VdcPool(SqlDB * db, bool is_federation_slave):
+    PoolSQL(db, Vdc::table, !is_federation_slave)
 {
     string error_str;
 
@@ -262,6 +262,45 @@ int History::select(SqlDB * db)
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+int History::select(const string& body)
+{
+    int bseq = seq;
+
+    if ( from_xml(body) != 0 || seq != bseq || hostname.empty() )
+    {
+        return -1;
+    }
+
+    non_persistent_data();
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int History::select_records(SqlDB * db, const string& vids,
+        map<int, vector<string> >& records)
+{
+    ostringstream oss;
+
+    map_vector_cb<int> cb;
+
+    oss << "SELECT vid, body FROM " << table << " WHERE vid IN (" << vids
+        << ") ORDER BY vid, seq";
+
+    cb.set_callback(&records);
+
+    int rc = db->exec_rd(oss, &cb);
+
+    cb.unset_callback();
+
+    return rc;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 int History::drop(SqlDB * db)
 {
     ostringstream   oss;
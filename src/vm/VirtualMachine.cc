@@ -538,6 +538,23 @@ int VirtualMachine::select(SqlDB * db)
     //Get History Records.
     if ( hasHistory() )
     {
+        std::map<int, std::vector<string> > db_history;
+
+        std::vector<string>& records = db_history[oid];
+
+        // Read all the records with one query, and cache them with the body
+        if ( !get_db_records(records) )
+        {
+            oss << oid;
+
+            if ( History::select_records(db, oss.str(), db_history) != 0 )
+            {
+                goto error_previous_history;
+            }
+
+            cache_db_records(records);
+        }
+
         last_seq = history->seq;
 
         delete history_records[last_seq];
@@ -549,7 +566,19 @@ int VirtualMachine::select(SqlDB * db)
             hp = new History(oid, i);
             history_records[i] = hp;
 
-            rc = hp->select(db);
+            if ( static_cast<size_t>(i) < records.size() )
+            {
+                rc = hp->select(records[i]);
+            }
+            else
+            {
+                rc = -1;
+            }
+
+            if ( rc != 0 )
+            {
+                rc = hp->select(db);
+            }
 
             if ( rc != 0)
             {
@@ -575,13 +604,17 @@ int VirtualMachine::select(SqlDB * db)
     }
 
     //--------------------------------------------------------------------------
-    //Create support directories for this VM
+    //Create support directories for this VM, read-only objects do not use
+    //them (they are created by any previous read-write access)
     //--------------------------------------------------------------------------
-    oss.str("");
-    oss << nd.get_vms_location() << oid;
+    if ( !ro )
+    {
+        oss.str("");
+        oss << nd.get_vms_location() << oid;
 
-    mkdir(oss.str().c_str(), 0700);
-    chmod(oss.str().c_str(), 0700);
+        mkdir(oss.str().c_str(), 0700);
+        chmod(oss.str().c_str(), 0700);
+    }
 
     //--------------------------------------------------------------------------
     //Create Log support for this VM
@@ -2431,6 +2464,7 @@ string& VirtualMachine::to_xml_short(string& xml)
 int VirtualMachine::from_xml(const string &xml_str)
 {
     vector<xmlNodePtr> content;
+    xmlNodePtr         node;
 
     int istate;
     int ilcmstate;
@@ -2444,35 +2478,38 @@ int VirtualMachine::from_xml(const string &xml_str)
         return -1;
     }
 
+    // Index the VM elements, fields are read in a single pass
+    ObjectXML::ChildIndex vm_xml(*this);
+
     // Get class base attributes
-    rc += xpath(oid,       "/VM/ID",    -1);
+    rc += vm_xml.get(oid,       "ID",    -1);
 
-    rc += xpath(uid,       "/VM/UID",   -1);
-    rc += xpath(gid,       "/VM/GID",   -1);
+    rc += vm_xml.get(uid,       "UID",   -1);
+    rc += vm_xml.get(gid,       "GID",   -1);
 
-    rc += xpath(uname,     "/VM/UNAME", "not_found");
-    rc += xpath(gname,     "/VM/GNAME", "not_found");
-    rc += xpath(name,      "/VM/NAME",  "not_found");
+    rc += vm_xml.get(uname,     "UNAME", "not_found");
+    rc += vm_xml.get(gname,     "GNAME", "not_found");
+    rc += vm_xml.get(name,      "NAME",  "not_found");
 
-    rc += xpath<time_t>(last_poll, "/VM/LAST_POLL", 0);
-    rc += xpath(resched, "/VM/RESCHED", 0);
+    rc += vm_xml.get<time_t>(last_poll, "LAST_POLL", 0);
+    rc += vm_xml.get(resched, "RESCHED", 0);
 
-    rc += xpath<time_t>(stime, "/VM/STIME", 0);
-    rc += xpath<time_t>(etime, "/VM/ETIME", 0);
-    rc += xpath(deploy_id, "/VM/DEPLOY_ID","");
+    rc += vm_xml.get<time_t>(stime, "STIME", 0);
+    rc += vm_xml.get<time_t>(etime, "ETIME", 0);
+    rc += vm_xml.get(deploy_id, "DEPLOY_ID","");
 
     // Permissions
     rc += perms_from_xml();
 
     //VM states
-    rc += xpath(istate,    "/VM/STATE",     0);
-    rc += xpath(ilcmstate, "/VM/LCM_STATE", 0);
+    rc += vm_xml.get(istate,    "STATE",     0);
+    rc += vm_xml.get(ilcmstate, "LCM_STATE", 0);
 
     state     = static_cast<VmState>(istate);
     lcm_state = static_cast<LcmState>(ilcmstate);
 
-    xpath(istate,    "/VM/PREV_STATE",     istate);
-    xpath(ilcmstate, "/VM/PREV_LCM_STATE", ilcmstate);
+    vm_xml.get(istate,    "PREV_STATE",     istate);
+    vm_xml.get(ilcmstate, "PREV_LCM_STATE", ilcmstate);
 
     prev_state     = static_cast<VmState>(istate);
     prev_lcm_state = static_cast<LcmState>(ilcmstate);
@@ -2482,13 +2519,14 @@ int VirtualMachine::from_xml(const string &xml_str)
     // -------------------------------------------------------------------------
     // Virtual Machine template and attributes
     // -------------------------------------------------------------------------
-    ObjectXML::get_nodes("/VM/TEMPLATE", content);
+    node = vm_xml.node("TEMPLATE");
 
-    if (content.empty())
+    if (node == 0)
     {
         return -1;
     }
-    rc += obj_template->from_xml_node(content[0]);
+
+    rc += obj_template->from_xml_node(node);
 
     vector<VectorAttribute *> vdisks, vnics, alias, pcis;
     vector<VectorAttribute *>::iterator it;
@@ -2518,46 +2556,39 @@ int VirtualMachine::from_xml(const string &xml_str)
 
     nics.init(vnics, true);
 
-    ObjectXML::free_nodes(content);
-    content.clear();
-
     // -------------------------------------------------------------------------
     // Virtual Machine Monitoring
     // -------------------------------------------------------------------------
-    ObjectXML::get_nodes("/VM/MONITORING", content);
+    node = vm_xml.node("MONITORING");
 
-    if (content.empty())
+    if (node == 0)
     {
         return -1;
     }
 
-    rc += monitoring.from_xml_node(content[0]);
-
-    ObjectXML::free_nodes(content);
-    content.clear();
+    rc += monitoring.from_xml_node(node);
 
     // -------------------------------------------------------------------------
     // Virtual Machine user template
     // -------------------------------------------------------------------------
-    ObjectXML::get_nodes("/VM/USER_TEMPLATE", content);
+    node = vm_xml.node("USER_TEMPLATE");
 
-    if (content.empty())
+    if (node == 0)
     {
         return -1;
     }
 
-    rc += user_obj_template->from_xml_node(content[0]);
-
-    ObjectXML::free_nodes(content);
-    content.clear();
+    rc += user_obj_template->from_xml_node(node);
 
     // -------------------------------------------------------------------------
     // Last history entry
     // -------------------------------------------------------------------------
     int last_seq;
 
-    if ( xpath(last_seq,"/VM/HISTORY_RECORDS/HISTORY/SEQ", -1) == 0 &&
-            last_seq != -1 )
+    ObjectXML::ChildIndex hrs(vm_xml.node("HISTORY_RECORDS"));
+    ObjectXML::ChildIndex hr(hrs.node("HISTORY"));
+
+    if ( hr.get(last_seq, "SEQ", -1) == 0 && last_seq != -1 )
     {
         history_records.resize(last_seq + 1);
 
@@ -2574,7 +2605,7 @@ int VirtualMachine::from_xml(const string &xml_str)
     // -------------------------------------------------------------------------
     // Virtual Machine Snapshots
     // -------------------------------------------------------------------------
-    ObjectXML::get_nodes("/VM/SNAPSHOTS", content);
+    vm_xml.nodes("SNAPSHOTS", content);
 
     for (vector<xmlNodePtr>::iterator it=content.begin();it!=content.end();it++)
     {
@@ -2591,12 +2622,6 @@ int VirtualMachine::from_xml(const string &xml_str)
         disks.set_snapshots(snap->get_disk_id(), snap);
     }
 
-    if (!content.empty())
-    {
-        ObjectXML::free_nodes(content);
-        content.clear();
-    }
-
     // -------------------------------------------------------------------------
     // -------------------------------------------------------------------------
     if (rc != 0)
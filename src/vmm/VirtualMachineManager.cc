@@ -1508,6 +1508,9 @@ void VirtualMachineManager::timer_action(const ActionRequest& ar)
         return;
     }
 
+    // Read the VMs in batches, each VM is then locked from the pool cache
+    vmpool->prefetch(oids);
+
     for ( it = oids.begin(); it != oids.end(); it++ )
     {
         vm = vmpool->get(*it);
@@ -67,7 +67,7 @@ VirtualNetwork::VirtualNetwork(int                      _uid,
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
-void VirtualNetwork::get_permissions(PoolObjectAuth& auths)
+void VirtualNetwork::get_permissions(PoolObjectAuth& auths) const
 {
     PoolObjectSQL::get_permissions(auths);
 
@@ -695,7 +695,7 @@ string& VirtualNetwork::to_xml_extended(string& xml, bool extended_and_check,
 
 int VirtualNetwork::from_xml(const string &xml_str)
 {
-    vector<xmlNodePtr> content;
+    xmlNodePtr node;
 
     int rc = 0;
 
@@ -705,31 +705,34 @@ int VirtualNetwork::from_xml(const string &xml_str)
     // Initialize the internal XML object
     update_from_str(xml_str);
 
+    // Index the VNET elements, fields are read in a single pass
+    ObjectXML::ChildIndex vnet_xml(*this);
+
     // Get class base attributes
-    rc += xpath(oid,    "/VNET/ID",  -1);
-    rc += xpath(uid,    "/VNET/UID", -1);
-    rc += xpath(gid,    "/VNET/GID", -1);
-    rc += xpath(uname,  "/VNET/UNAME", "not_found");
-    rc += xpath(gname,  "/VNET/GNAME", "not_found");
-    rc += xpath(name,   "/VNET/NAME",  "not_found");
-    rc += xpath(bridge, "/VNET/BRIDGE","not_found");
+    rc += vnet_xml.get(oid,    "ID",  -1);
+    rc += vnet_xml.get(uid,    "UID", -1);
+    rc += vnet_xml.get(gid,    "GID", -1);
+    rc += vnet_xml.get(uname,  "UNAME", "not_found");
+    rc += vnet_xml.get(gname,  "GNAME", "not_found");
+    rc += vnet_xml.get(name,   "NAME",  "not_found");
+    rc += vnet_xml.get(bridge, "BRIDGE","not_found");
 
     rc += lock_db_from_xml();
 
     // Permissions
     rc += perms_from_xml();
 
-    xpath(vn_mad, "/VNET/VN_MAD", "");
-    xpath(phydev, "/VNET/PHYDEV", "");
-    xpath(bridge_type, "/VNET/BRIDGE_TYPE", "");
+    vnet_xml.get(vn_mad, "VN_MAD", "");
+    vnet_xml.get(phydev, "PHYDEV", "");
+    vnet_xml.get(bridge_type, "BRIDGE_TYPE", "");
 
-    xpath(vlan_id, "/VNET/VLAN_ID", "");
-    xpath(outer_vlan_id, "/VNET/OUTER_VLAN_ID", "");
+    vnet_xml.get(vlan_id, "VLAN_ID", "");
+    vnet_xml.get(outer_vlan_id, "OUTER_VLAN_ID", "");
 
-    xpath(int_vlan_id_automatic, "/VNET/VLAN_ID_AUTOMATIC", 0);
-    xpath(int_outer_vlan_id_automatic, "/VNET/OUTER_VLAN_ID_AUTOMATIC", 0);
+    vnet_xml.get(int_vlan_id_automatic, "VLAN_ID_AUTOMATIC", 0);
+    vnet_xml.get(int_outer_vlan_id_automatic, "OUTER_VLAN_ID_AUTOMATIC", 0);
 
-    xpath(parent_vid,"/VNET/PARENT_NETWORK_ID",-1);
+    vnet_xml.get(parent_vid, "PARENT_NETWORK_ID", -1);
 
     vlan_id_automatic = int_vlan_id_automatic;
     outer_vlan_id_automatic = int_outer_vlan_id_automatic;
@@ -741,17 +744,14 @@ int VirtualNetwork::from_xml(const string &xml_str)
     rc += vrouters.from_xml(this, "/VNET/");
 
     // Virtual Network template
-    ObjectXML::get_nodes("/VNET/TEMPLATE", content);
+    node = vnet_xml.node("TEMPLATE");
 
-    if (content.empty())
+    if (node == 0)
     {
         return -1;
     }
 
-    rc += obj_template->from_xml_node(content[0]);
-
-    ObjectXML::free_nodes(content);
-    content.clear();
+    rc += obj_template->from_xml_node(node);
 
     //Security groups internal attribute (from /VNET/TEMPLATE/SECURITY_GROUPS)
     string sg_str;
@@ -761,17 +761,15 @@ int VirtualNetwork::from_xml(const string &xml_str)
     one_util::split_unique(sg_str, ',', security_groups);
 
     // Address Range Pool
-    ObjectXML::get_nodes("/VNET/AR_POOL", content);
+    node = vnet_xml.node("AR_POOL");
 
-    if (content.empty())
+    if (node == 0)
     {
         return -1;
     }
 
     // Address Ranges of the Virtual Network
-    rc += ar_pool.from_xml_node(content[0]);
-
-    ObjectXML::free_nodes(content);
+    rc += ar_pool.from_xml_node(node);
 
     if (rc != 0)
     {
@@ -19,7 +19,13 @@
 #include <cstring>
 #include <iostream>
 #include <sstream>
+#include <pthread.h>
+#include <memory>
+#include <set>
+#include <cstdlib>
+#include <atomic>
 
+#include "Expression.h"
 #include "expr_arith.h"
 #include "expr_bool.h"
 #include "expr_parser.h"
@@ -29,8 +35,10 @@ using namespace std;
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
-ObjectXML::ObjectXML(const std::string &xml_doc):paths(0),num_paths(0),xml(0),ctx(0)
+ObjectXML::ObjectXML(const std::string &xml_doc):paths(0),num_paths(0),xml(0)
 {
+    pthread_mutex_init(&search_mutex, 0);
+
     try
     {
         xml_parse(xml_doc);
@@ -44,8 +52,10 @@ ObjectXML::ObjectXML(const std::string &xml_doc):paths(0),num_paths(0),xml(0),ct
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
-ObjectXML::ObjectXML(const xmlNodePtr node):paths(0),num_paths(0),xml(0),ctx(0)
+ObjectXML::ObjectXML(const xmlNodePtr node):paths(0),num_paths(0),xml(0)
 {
+    pthread_mutex_init(&search_mutex, 0);
+
     xml = xmlNewDoc(reinterpret_cast<const xmlChar *>("1.0"));
 
     if (xml == 0)
@@ -53,19 +63,10 @@ ObjectXML::ObjectXML(const xmlNodePtr node):paths(0),num_paths(0),xml(0),ctx(0)
         throw("Error allocating XML Document");
     }
 
-    ctx = xmlXPathNewContext(xml);
-
-    if (ctx == 0)
-    {
-        xmlFreeDoc(xml);
-        throw("Unable to create new XPath context");
-    }
-
     xmlNodePtr root_node = xmlDocCopyNode(node,xml,1);
 
     if (root_node == 0)
     {
-        xmlXPathFreeContext(ctx);
         xmlFreeDoc(xml);
         throw("Unable to allocate node");
     }
@@ -83,10 +84,7 @@ ObjectXML::~ObjectXML()
         xmlFreeDoc(xml);
     }
 
-    if ( ctx != 0)
-    {
-        xmlXPathFreeContext(ctx);
-    }
+    pthread_mutex_destroy(&search_mutex);
 };
 
 /* -------------------------------------------------------------------------- */
@@ -100,7 +98,7 @@ void ObjectXML::xpaths(std::vector<std::string>& content, const char * expr)
     xmlNodePtr    cur;
     xmlChar *     str_ptr;
 
-    obj = xmlXPathEvalExpression(reinterpret_cast<const xmlChar *>(expr), ctx);
+    obj = eval_xpath(expr);
 
     if (obj == 0)
     {
@@ -211,8 +209,7 @@ int ObjectXML::get_nodes(const string& xpath_expr,
 {
     xmlXPathObjectPtr obj;
 
-    obj = xmlXPathEvalExpression(
-        reinterpret_cast<const xmlChar *>(xpath_expr.c_str()), ctx);
+    obj = eval_xpath(xpath_expr.c_str());
 
     if (obj == 0)
     {
@@ -260,8 +257,9 @@ int ObjectXML::add_node(
     xmlXPathObjectPtr obj;
     vector<string>    content;
 
-    obj = xmlXPathEvalExpression(
-        reinterpret_cast<const xmlChar *>(xpath_expr), ctx);
+    clear_search_cache();
+
+    obj = eval_xpath(xpath_expr);
 
     if (obj == 0 || obj->nodesetval == 0)
     {
@@ -311,25 +309,159 @@ int ObjectXML::add_node(
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
-int ObjectXML::update_from_str(const string &xml_doc)
+/**
+ *  Gets the value of the ID child of an element
+ *    @return 0 on success, -1 if the element has no ID
+ */
+static int element_id(const xmlNodePtr node, int& id)
 {
-    if (xml != 0)
+    for (xmlNodePtr cur = node->children; cur != 0; cur = cur->next)
     {
-        xmlFreeDoc(xml);
+        if ( cur->type != XML_ELEMENT_NODE ||
+             xmlStrcmp(cur->name, reinterpret_cast<const xmlChar *>("ID")) != 0)
+        {
+            continue;
+        }
+
+        xmlChar * str = xmlNodeGetContent(cur);
+
+        if ( str == 0 )
+        {
+            return -1;
+        }
+
+        char * end;
+
+        id = strtol(reinterpret_cast<const char *>(str), &end, 10);
+
+        int rc = (*end == '\0' && end != reinterpret_cast<char *>(str)) ? 0:-1;
+
+        xmlFree(str);
+
+        return rc;
     }
 
-    if ( ctx != 0)
+    return -1;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int ObjectXML::merge_by_id(const xmlNodePtr src, const vector<int>& ids)
+{
+    xmlNodePtr root = xml != 0 ? xmlDocGetRootElement(xml) : 0;
+
+    if ( root == 0 )
     {
-        xmlXPathFreeContext(ctx);
+        return -1;
     }
 
-    try
+    clear_search_cache();
+
+    set<int> removed(ids.begin(), ids.end());
+
+    map<int, xmlNodePtr>    elements;
+    map<string, xmlNodePtr> others;
+
+    xmlNodePtr next;
+    int        id;
+
+    for (xmlNodePtr cur = root->children; cur != 0; cur = next)
     {
-        xml_parse(xml_doc);
+        next = cur->next;
+
+        if ( cur->type != XML_ELEMENT_NODE )
+        {
+            continue;
+        }
+
+        if ( element_id(cur, id) != 0 )
+        {
+            others.insert(make_pair(
+                    reinterpret_cast<const char *>(cur->name), cur));
+        }
+        else if ( removed.count(id) != 0 )
+        {
+            xmlUnlinkNode(cur);
+            xmlFreeNode(cur);
+        }
+        else
+        {
+            elements.insert(make_pair(id, cur));
+        }
     }
-    catch(runtime_error& re)
+
+    if ( src == 0 )
     {
-        return -1;
+        return 0;
+    }
+
+    for (xmlNodePtr cur = src->children; cur != 0; cur = cur->next)
+    {
+        if ( cur->type != XML_ELEMENT_NODE )
+        {
+            continue;
+        }
+
+        xmlNodePtr node = xmlDocCopyNode(cur, xml, 1);
+
+        if ( node == 0 )
+        {
+            continue;
+        }
+
+        if ( element_id(cur, id) != 0 )
+        {
+            auto it = others.find(reinterpret_cast<const char *>(cur->name));
+
+            if ( it != others.end() )
+            {
+                xmlReplaceNode(it->second, node);
+                xmlFreeNode(it->second);
+
+                it->second = node;
+            }
+            else
+            {
+                xmlAddChild(root, node);
+            }
+
+            continue;
+        }
+
+        auto it = elements.lower_bound(id);
+
+        if ( it != elements.end() && it->first == id )
+        {
+            xmlReplaceNode(it->second, node);
+            xmlFreeNode(it->second);
+
+            it->second = node;
+        }
+        else if ( it != elements.end() )
+        {
+            xmlAddPrevSibling(it->second, node);
+
+            elements.insert(it, make_pair(id, node));
+        }
+        else if ( !elements.empty() )
+        {
+            xmlAddNextSibling(elements.rbegin()->second, node);
+
+            elements.insert(make_pair(id, node));
+        }
+        else
+        {
+            if ( root->children != 0 )
+            {
+                xmlAddPrevSibling(root->children, node);
+            }
+            else
+            {
+                xmlAddChild(root, node);
+            }
+
+            elements.insert(make_pair(id, node));
+        }
     }
 
     return 0;
@@ -338,30 +470,43 @@ int ObjectXML::update_from_str(const string &xml_doc)
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
-int ObjectXML::update_from_node(const xmlNodePtr node)
+int ObjectXML::update_from_str(const string &xml_doc)
 {
+    clear_search_cache();
+
     if (xml != 0)
     {
         xmlFreeDoc(xml);
     }
 
-    if ( ctx != 0)
+    try
     {
-        xmlXPathFreeContext(ctx);
+        xml_parse(xml_doc);
     }
-
-    xml = xmlNewDoc(reinterpret_cast<const xmlChar *>("1.0"));
-
-    if (xml == 0)
+    catch(runtime_error& re)
     {
         return -1;
     }
 
-    ctx = xmlXPathNewContext(xml);
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
 
-    if (ctx == 0)
+int ObjectXML::update_from_node(const xmlNodePtr node)
+{
+    clear_search_cache();
+
+    if (xml != 0)
     {
         xmlFreeDoc(xml);
+    }
+
+    xml = xmlNewDoc(reinterpret_cast<const xmlChar *>("1.0"));
+
+    if (xml == 0)
+    {
         return -1;
     }
 
@@ -369,8 +514,9 @@ int ObjectXML::update_from_node(const xmlNodePtr node)
 
     if (root_node == 0)
     {
-        xmlXPathFreeContext(ctx);
         xmlFreeDoc(xml);
+        xml = 0;
+
         return -1;
     }
 
@@ -408,14 +554,134 @@ void ObjectXML::xml_parse(const string &xml_doc)
     {
         throw runtime_error("Error parsing XML Document");
     }
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+/**
+ *  Statistics of the compiled XPath expression caches, for all the threads
+ */
+static std::atomic<unsigned long> xpath_cache_hits(0);
+static std::atomic<unsigned long> xpath_cache_misses(0);
+static std::atomic<size_t>        xpath_cache_size(0);
+
+/**
+ *  XPath context of each thread, it is reused to evaluate expressions on any
+ *  document. Each thread also keeps its own cache of compiled expressions, so
+ *  evaluations do not need any lock.
+ */
+struct ThreadXPathContext
+{
+    ThreadXPathContext()
+    {
+        ctx = xmlXPathNewContext(0);
+
+        if ( ctx != 0 )
+        {
+            xmlXPathContextSetCache(ctx, 1, -1, 0);
+        }
+    };
+
+    ~ThreadXPathContext()
+    {
+        map<string, xmlXPathCompExprPtr>::iterator it;
+
+        for ( it = cache.begin() ; it != cache.end() ; ++it )
+        {
+            xmlXPathFreeCompExpr(it->second);
+        }
+
+        xpath_cache_size -= cache.size();
+
+        if ( ctx != 0 )
+        {
+            xmlXPathFreeContext(ctx);
+        }
+    };
+
+    xmlXPathContextPtr ctx;
+
+    map<string, xmlXPathCompExprPtr> cache;
+};
+
+static thread_local ThreadXPathContext thread_xpath;
+
+/* -------------------------------------------------------------------------- */
+
+xmlXPathObjectPtr ObjectXML::eval_xpath(const char * expr) const
+{
+    xmlXPathCompExprPtr comp;
+    xmlXPathObjectPtr   obj;
+
+    bool cached = true;
+
+    xmlXPathContextPtr ctx = thread_xpath.ctx;
+
+    map<string, xmlXPathCompExprPtr>& cache = thread_xpath.cache;
+
+    if ( xml == 0 || ctx == 0 )
+    {
+        return 0;
+    }
 
-    ctx = xmlXPathNewContext(xml);
+    map<string, xmlXPathCompExprPtr>::iterator it = cache.find(expr);
 
-    if (ctx == 0)
+    if ( it != cache.end() )
     {
-        xmlFreeDoc(xml);
-        throw runtime_error("Unable to create new XPath context");
+        comp = it->second;
+
+        xpath_cache_hits++;
     }
+    else
+    {
+        xpath_cache_misses++;
+
+        comp = xmlXPathCompile(reinterpret_cast<const xmlChar *>(expr));
+
+        if ( comp == 0 )
+        {
+            return 0;
+        }
+
+        if ( cache.size() < MAX_XPATH_CACHE )
+        {
+            cache.insert(make_pair(expr, comp));
+
+            xpath_cache_size++;
+        }
+        else
+        {
+            cached = false;
+        }
+    }
+
+    ctx->doc  = xml;
+    ctx->node = 0;
+
+    ctx->contextSize       = -1;
+    ctx->proximityPosition = -1;
+
+    obj = xmlXPathCompiledEval(comp, ctx);
+
+    ctx->doc = 0;
+
+    if ( !cached )
+    {
+        xmlXPathFreeCompExpr(comp);
+    }
+
+    return obj;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void ObjectXML::xpath_cache_stats(unsigned long& hits, unsigned long& misses,
+        size_t& size)
+{
+    hits   = xpath_cache_hits;
+    misses = xpath_cache_misses;
+    size   = xpath_cache_size;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -425,8 +691,9 @@ int ObjectXML::rename_nodes(const char * xpath_expr, const char * new_name)
 {
     xmlXPathObjectPtr obj;
 
-    obj = xmlXPathEvalExpression(
-        reinterpret_cast<const xmlChar *>(xpath_expr), ctx);
+    clear_search_cache();
+
+    obj = eval_xpath(xpath_expr);
 
     if (obj == 0 || obj->nodesetval == 0)
     {
@@ -456,39 +723,182 @@ int ObjectXML::rename_nodes(const char * xpath_expr, const char * new_name)
     return renamed;
 }
 
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void ObjectXML::search_values(const char * name, vector<string>& values)
+{
+    if (num_paths == 0)
+    {
+        return;
+    }
+
+    map<string, vector<string> >::iterator it;
+
+    pthread_mutex_lock(&search_mutex);
+
+    it = search_cache.find(name);
+
+    if (it != search_cache.end())
+    {
+        values.insert(values.end(), it->second.begin(), it->second.end());
+
+        pthread_mutex_unlock(&search_mutex);
+
+        return;
+    }
+
+    pthread_mutex_unlock(&search_mutex);
+
+    ostringstream  xpath;
+    vector<string> found;
+
+    xpath << paths[0] << name;
+
+    for (int i = 1; i < num_paths ; i++)
+    {
+        xpath << '|' << paths[i] << name;
+    }
+
+    xpaths(found, xpath.str().c_str());
+
+    values.insert(values.end(), found.begin(), found.end());
+
+    pthread_mutex_lock(&search_mutex);
+
+    search_cache.insert(make_pair(name, found));
+
+    pthread_mutex_unlock(&search_mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void ObjectXML::clear_search_cache()
+{
+    pthread_mutex_lock(&search_mutex);
+
+    search_cache.clear();
+
+    pthread_mutex_unlock(&search_mutex);
+}
+
 /* ************************************************************************ */
 /* Host :: Parse functions to compute rank and evaluate requirements        */
 /* ************************************************************************ */
 
-int ObjectXML::eval_bool(const string& expr, bool& result, char **errmsg)
+/**
+ *  Requirement and rank expressions are compiled once and cached by their
+ *  string, most VMs use the same expressions. The cache is cleared when it
+ *  reaches MAX_EXPR_CACHE expressions.
+ */
+static const size_t MAX_EXPR_CACHE = 1024;
+
+static map<string, shared_ptr<const BoolExpression> > bool_cache;
+
+static map<string, shared_ptr<const ArithExpression> > arith_cache;
+
+static pthread_mutex_t expr_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ *  Gets the compiled expression from the cache or parses it.
+ *    @param expr string
+ *    @param cache of compiled expressions
+ *    @param parse function of the expression grammar
+ *    @param cexpr the compiled expression
+ *    @param errmsg string describing the error, must be freed by the
+ *    calling function
+ *    @return 0 on success
+ */
+template<typename E>
+static int compile_expr(const string& expr,
+        map<string, shared_ptr<const E> >& cache,
+        int (*parse)(E **, char **, yyscan_t),
+        shared_ptr<const E>& cexpr,
+        char **errmsg)
 {
-    const char * str;
-    int          rc;
+    typename map<string, shared_ptr<const E> >::iterator it;
 
     YY_BUFFER_STATE str_buffer = 0;
     yyscan_t scanner = 0;
 
+    E * pexpr = 0;
+    int rc;
+
     *errmsg = 0;
 
-    expr_lex_init(&scanner);
+    pthread_mutex_lock(&expr_cache_mutex);
+
+    it = cache.find(expr);
+
+    if (it != cache.end())
+    {
+        cexpr = it->second;
+
+        pthread_mutex_unlock(&expr_cache_mutex);
+
+        return 0;
+    }
+
+    pthread_mutex_unlock(&expr_cache_mutex);
 
-    str = expr.c_str();
+    expr_lex_init(&scanner);
 
-    str_buffer = expr__scan_string(str, scanner);
+    str_buffer = expr__scan_string(expr.c_str(), scanner);
 
     if (str_buffer == 0)
     {
+        expr_lex_destroy(scanner);
+
         *errmsg=strdup("Error setting scan buffer");
         return -1;
     }
 
-    rc = expr_bool_parse(this, result, errmsg, scanner);
+    rc = parse(&pexpr, errmsg, scanner);
 
     expr__delete_buffer(str_buffer, scanner);
 
     expr_lex_destroy(scanner);
 
-    return rc;
+    if (rc != 0)
+    {
+        delete pexpr;
+        return rc;
+    }
+
+    cexpr.reset(pexpr);
+
+    pthread_mutex_lock(&expr_cache_mutex);
+
+    if (cache.size() >= MAX_EXPR_CACHE)
+    {
+        cache.clear();
+    }
+
+    cache.insert(make_pair(expr, cexpr));
+
+    pthread_mutex_unlock(&expr_cache_mutex);
+
+    return 0;
+}
+
+/* ------------------------------------------------------------------------ */
+/* ------------------------------------------------------------------------ */
+
+int ObjectXML::eval_bool(const string& expr, bool& result, char **errmsg)
+{
+    shared_ptr<const BoolExpression> bexpr;
+
+    int rc = compile_expr(expr, bool_cache, expr_bool_parse, bexpr, errmsg);
+
+    if ( rc != 0 )
+    {
+        result = false;
+        return rc;
+    }
+
+    result = bexpr->eval(*this);
+
+    return 0;
 }
 
 /* ------------------------------------------------------------------------ */
@@ -496,40 +906,122 @@ int ObjectXML::eval_bool(const string& expr, bool& result, char **errmsg)
 
 int ObjectXML::eval_arith(const string& expr, int& result, char **errmsg)
 {
-    const char * str;
-    int rc;
+    shared_ptr<const ArithExpression> aexpr;
 
-    YY_BUFFER_STATE str_buffer = 0;
-    yyscan_t scanner = 0;
+    int rc = compile_expr(expr, arith_cache, expr_arith_parse, aexpr, errmsg);
 
-    *errmsg = 0;
+    if ( rc != 0 )
+    {
+        return rc;
+    }
 
-    expr_lex_init(&scanner);
+    result = static_cast<int>(aexpr->eval(*this));
 
-    str = expr.c_str();
+    return 0;
+}
 
-    str_buffer = expr__scan_string(str, scanner);
+/* ------------------------------------------------------------------------ */
+/* ------------------------------------------------------------------------ */
 
-    if (str_buffer == 0)
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+/* ObjectXML::ChildIndex                                                      */
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+ObjectXML::ChildIndex::ChildIndex(const ObjectXML& oxml)
+{
+    if ( oxml.xml != 0 )
     {
-        goto error_yy;
+        index(xmlDocGetRootElement(oxml.xml));
     }
+}
 
-    rc = expr_arith_parse(this, result, errmsg, scanner);
+/* -------------------------------------------------------------------------- */
 
-    expr__delete_buffer(str_buffer, scanner);
+ObjectXML::ChildIndex::ChildIndex(const xmlNodePtr node)
+{
+    index(node);
+}
 
-    expr_lex_destroy(scanner);
+/* -------------------------------------------------------------------------- */
 
-    return rc;
+void ObjectXML::ChildIndex::index(const xmlNodePtr node)
+{
+    if ( node == 0 )
+    {
+        return;
+    }
 
-error_yy:
+    for (xmlNodePtr cur = node->children; cur != 0; cur = cur->next)
+    {
+        if ( cur->type != XML_ELEMENT_NODE )
+        {
+            continue;
+        }
+
+        children.insert(make_pair(
+                    reinterpret_cast<const char *>(cur->name), cur));
+    }
+}
 
-    *errmsg=strdup("Error setting scan buffer");
+/* -------------------------------------------------------------------------- */
 
-    return -1;
+xmlNodePtr ObjectXML::ChildIndex::node(const char * name) const
+{
+    multimap<string, xmlNodePtr>::const_iterator it = children.find(name);
+
+    if ( it == children.end() )
+    {
+        return 0;
+    }
+
+    return it->second;
 }
 
-/* ------------------------------------------------------------------------ */
-/* ------------------------------------------------------------------------ */
+/* -------------------------------------------------------------------------- */
+
+int ObjectXML::ChildIndex::nodes(const char * name,
+        vector<xmlNodePtr>& content) const
+{
+    multimap<string, xmlNodePtr>::const_iterator it;
+
+    pair<multimap<string, xmlNodePtr>::const_iterator,
+         multimap<string, xmlNodePtr>::const_iterator> range;
+
+    range = children.equal_range(name);
 
+    for (it = range.first; it != range.second; ++it)
+    {
+        content.push_back(it->second);
+    }
+
+    return content.size();
+}
+
+/* -------------------------------------------------------------------------- */
+
+int ObjectXML::ChildIndex::get(string& value, const char * name,
+        const char * def) const
+{
+    xmlNodePtr cur = node(name);
+
+    xmlChar * str_ptr = 0;
+
+    if ( cur != 0 )
+    {
+        str_ptr = xmlNodeGetContent(cur);
+    }
+
+    if ( str_ptr == 0 )
+    {
+        value = def;
+        return -1;
+    }
+
+    value = reinterpret_cast<char *>(str_ptr);
+
+    xmlFree(str_ptr);
+
+    return 0;
+}
@@ -28,7 +28,8 @@ const int ZonePool::STANDALONE_ZONE_ID = 0;
 
 /* -------------------------------------------------------------------------- */
 
-ZonePool::ZonePool(SqlDB * db, bool is_federation_slave):PoolSQL(db,Zone::table)
+ZonePool::ZonePool(SqlDB * db, bool is_federation_slave):
+    PoolSQL(db, Zone::table, !is_federation_slave)
 {
     string error_str;
 